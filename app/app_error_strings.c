@@ -27,3 +27,22 @@ const char* app_error_to_string(err_t code)
         default:                    return "UNKNOWN_APPLICATION_ERROR";
     }
 }
+
+/**
+ * @brief Severity of each code, used by err_uplink.c to decide what is uploaded
+ * first when the comms window is short.
+ */
+errcheck_severity_t app_error_severity(err_t code)
+{
+    switch ((app_err_t)code) {
+        case ERR_POWER:             return ERRCHECK_SEV_CRITICAL;
+        case ERR_FLASH:             return ERRCHECK_SEV_CRITICAL;
+        case ERR_RADIO:             return ERRCHECK_SEV_ERROR;
+        case ERR_SENSOR:            return ERRCHECK_SEV_ERROR;
+        case ERR_BUS_COLLISION:     return ERRCHECK_SEV_WARNING;
+        case ERR_TIMEOUT:           return ERRCHECK_SEV_WARNING;
+        case ERR_CLEANUP_FAILED:    return ERRCHECK_SEV_WARNING;
+        case APP_ERR_NONE:          return ERRCHECK_SEV_INFO;
+        default:                    return ERRCHECK_SEV_ERROR;
+    }
+}
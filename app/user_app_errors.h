@@ -4,7 +4,8 @@
 #include "../src/errcheck.h" // Includes err_t definition
 
 // --- 1. User-Defined Error Codes (Used across the entire application) ---
-// Note: These must not overlap with internal library codes (0xFF, 0x00)
+// Note: These must not overlap with internal library codes (0xFF, 0x00,
+// 0xFE for watchdog hang records and 0xFD for failed allocations)
 typedef enum {
     APP_ERR_NONE = ERR_SUCCESS, // 0x00
     
@@ -25,5 +26,7 @@ typedef enum {
 // This function MUST be implemented by the user in app_error_strings.c 
 // to provide human-readable names.
 extern const char* app_error_to_string(err_t code);
+// app_error_severity() (declared in src/err_uplink.h) is required only when
+// linking err_uplink.c.
 
 #endif // USER_APP_ERRORS_H
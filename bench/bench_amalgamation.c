@@ -0,0 +1,84 @@
+/**
+ * =============================================================================
+ * bench/bench_amalgamation.c
+ * * Compares the separate-TU build with the amalgamated header-only build on
+ * * the paths the amalgamation targets. Build both and compare the tables:
+ * *
+ * *   gcc -O2 -I src -D ERRCHECK_NVRAM_STUB_SILENT bench/bench_amalgamation.c \
+ * *       src/errcheck.c src/err_log.c app/app_error_strings.c -o bench_separate
+ * *   gcc -O2 -I src -D ERRCHECK_NVRAM_STUB_SILENT -D BENCH_SINGLE_HEADER \
+ * *       bench/bench_amalgamation.c app/app_error_strings.c -o bench_single
+ * *
+ * * Add the same ERRCHECK_ENABLE_* flags to both builds to compare a richer
+ * * configuration (the separate build then needs the matching src/ files).
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#ifdef BENCH_SINGLE_HEADER
+    #define ERRCHECK_IMPLEMENTATION
+    #include "errcheck_single.h"
+    #define BUILD_NAME "single header"
+#else
+    #include "errcheck.h"
+    #define BUILD_NAME "separate TUs"
+#endif
+#include <stdio.h>
+#include <time.h>
+#include "../app/user_app_errors.h"
+
+#define ITERATIONS 20000000u
+
+static volatile int g_driver_result = 0;
+
+__attribute__((noinline)) static int driver(void) { return g_driver_result; }
+
+// Failing CHECK: capture + errcheck_log_to_nvram() + commit
+__attribute__((noinline)) static err_t failing_check(void)
+{
+    CHECK(driver(), ERR_SENSOR);
+    return APP_ERR_NONE;
+}
+
+// Passing CHECK: must be identical in both builds
+__attribute__((noinline)) static err_t passing_check(void)
+{
+    CHECK(!driver(), ERR_SENSOR);
+    return APP_ERR_NONE;
+}
+
+// Exit label of a rollback sequence whose context was already logged
+__attribute__((noinline)) static void redundant_log(void)
+{
+    errcheck_log_to_nvram();
+    errcheck_log_to_nvram();
+    errcheck_log_to_nvram();
+    errcheck_log_to_nvram();
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+#define TIME_LOOP(label, per_iter, body) do {                                  \
+    double t0 = now_ns();                                                      \
+    for (uint32_t i = 0; i < ITERATIONS; i++) { body; }                        \
+    double dt = now_ns() - t0;                                                 \
+    printf("  %-34s %8.2f ns\n", label, dt / ITERATIONS / (per_iter));         \
+} while (0)
+
+int main(void)
+{
+    printf("errcheck build: %s\n", BUILD_NAME);
+
+    TIME_LOOP("failing CHECK (capture + log)", 1, (void)failing_check());
+    TIME_LOOP("passing CHECK", 1, (void)passing_check());
+
+    (void)failing_check(); // Leaves a logged context behind
+    TIME_LOOP("errcheck_log_to_nvram() redundant", 4, redundant_log());
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+/**
+ * =============================================================================
+ * bench/bench_crc32c.c
+ * * Throughput of every CRC-32C implementation available on this host, from a
+ * * single sealed record (48 bytes) up to bulk buffers.
+ * * Build: gcc -O2 -I src bench/bench_crc32c.c src/err_crc32c.c -o bench_crc32c
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "err_crc32c.h"
+
+typedef struct {
+    const char *name;
+    uint32_t (*fn)(uint32_t, const void *, size_t);
+} impl_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(void)
+{
+    static const size_t sizes[] = { 48, 256, 4096, 1u << 20 };
+    const size_t total = 256u << 20; // Bytes hashed per (implementation, size) pair
+    impl_t impls[5];
+    int n = 0;
+
+    impls[n++] = (impl_t){ "bitwise", errcheck_crc32c_bitwise };
+#ifndef ERRCHECK_CRC32C_SMALL
+    impls[n++] = (impl_t){ "slicing-by-8", errcheck_crc32c_sb8 };
+#endif
+#ifdef ERRCHECK_CRC32C_HAVE_SSE42
+    if (errcheck_crc32c_sse42_supported()) {
+        impls[n++] = (impl_t){ "sse4.2", errcheck_crc32c_sse42 };
+    }
+#endif
+#ifdef ERRCHECK_CRC32C_HAVE_ARMV8
+    impls[n++] = (impl_t){ "armv8", errcheck_crc32c_armv8 };
+#endif
+
+    uint8_t *buf = malloc(1u << 20);
+    if (buf == NULL) {
+        return 1;
+    }
+    for (size_t i = 0; i < (1u << 20); i++) {
+        buf[i] = (uint8_t)(i * 131u + 7u);
+    }
+
+    printf("dispatch: %s\n", errcheck_crc32c_impl_name());
+    printf("%-14s %10s %12s\n", "impl", "size", "MB/s");
+    for (int k = 0; k < n; k++) {
+        if (impls[k].fn(0, "123456789", 9) != ERRCHECK_CRC32C_CHECK_VALUE) {
+            printf("%-14s FAILED check value\n", impls[k].name);
+            return 1;
+        }
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            // The bitwise loop is ~50x slower; keep its run time reasonable
+            size_t budget = (impls[k].fn == errcheck_crc32c_bitwise) ? total / 32 : total;
+            size_t iters = budget / sizes[s];
+            volatile uint32_t sink = 0;
+            double t0 = now_s();
+            for (size_t i = 0; i < iters; i++) {
+                sink = impls[k].fn(sink, buf, sizes[s]);
+            }
+            double dt = now_s() - t0;
+            printf("%-14s %10zu %12.0f\n", impls[k].name, sizes[s],
+                   (double)(iters * sizes[s]) / 1e6 / dt);
+        }
+    }
+    free(buf);
+    return 0;
+}
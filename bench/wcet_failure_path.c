@@ -0,0 +1,308 @@
+/**
+ * =============================================================================
+ * bench/wcet_failure_path.c
+ * * Measurement-based worst-case execution time of the errcheck failure paths:
+ * *   CHECK       call into a guarded function whose call fails -> ERR_FAILURE
+ * *               returned (context capture + errcheck_log_to_nvram() included)
+ * *   GOTO_CHECK  same, through three rollback steps and the logging exit label
+ * * Each path is sampled millions of times with serialized cycle counter reads,
+ * * warm and with the path's code and data flushed from the caches, with and
+ * * without memory-hogging interference threads, on a pinned CPU. Reports min,
+ * * high percentiles, max and a log2 histogram of every configuration.
+ * *
+ * * Build with the errcheck configuration you want to certify, e.g.:
+ * *   gcc -O2 -pthread -I src -D ERRCHECK_ENABLE_HISTORY -D ERRCHECK_NVRAM_STUB_SILENT \
+ * *       bench/wcet_failure_path.c src/errcheck.c src/err_history.c \
+ * *       app/app_error_strings.c -o wcet_failure_path
+ * * Usage: wcet_failure_path [-n samples] [-c cpu|-1] [-t interference_threads]
+ * * NOTE: Measurements bound what was observed, not what is possible; treat the
+ * * max with the usual safety margin and keep turbo/frequency scaling fixed.
+ * =============================================================================
+ */
+
+#define _GNU_SOURCE // sched_setaffinity(), CPU_SET
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "errcheck.h"
+#include "err_cycles.h"
+#include "../app/user_app_errors.h"
+#ifdef ERRCHECK_ENABLE_HISTORY
+#include "err_history.h"
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h> // _mm_clflush, _mm_mfence
+#endif
+
+#define INTERFERENCE_BYTES (64u << 20)
+#define EVICT_BYTES        (16u << 20) // Cache eviction walk where CLFLUSH is unavailable
+#define HIST_BUCKETS       24
+
+// --- Path under test (noinline so the measured call is a real call) ---
+static volatile int g_driver_result = 0;
+static volatile int g_cleanup_sink = 0;
+
+__attribute__((noinline)) static int passing_driver(void) { return 1; }
+__attribute__((noinline)) static int failing_driver(void) { return g_driver_result; }
+__attribute__((noinline)) static void cleanup_step(void)  { g_cleanup_sink++; }
+
+__attribute__((noinline)) static err_t path_check(void)
+{
+    CHECK(failing_driver(), ERR_SENSOR);
+    return APP_ERR_NONE;
+}
+
+__attribute__((noinline)) static err_t path_goto_check(void)
+{
+    err_t final_result = ERR_FAILURE;
+
+    GOTO_CHECK(passing_driver(), ERR_POWER,  cleanup_power);
+    GOTO_CHECK(passing_driver(), ERR_FLASH,  cleanup_flash);
+    GOTO_CHECK(failing_driver(), ERR_SENSOR, cleanup_sensor);
+    final_result = APP_ERR_NONE;
+    goto exit;
+
+cleanup_sensor:
+    cleanup_step();
+cleanup_flash:
+    cleanup_step();
+cleanup_power:
+    cleanup_step();
+exit:
+    if (final_result == ERR_FAILURE) {
+        errcheck_log_to_nvram();
+    }
+    return final_result;
+}
+
+typedef err_t (*path_fn_t)(void);
+
+// --- Cache flushing ---
+static uint8_t *g_evict_buf = NULL;
+
+#if defined(__x86_64__) || defined(__i386__)
+static void flush_range(const void *p, size_t len)
+{
+    const uint8_t *b = (const uint8_t *)((uintptr_t)p & ~(uintptr_t)63u);
+    for (const uint8_t *q = b; q < (const uint8_t *)p + len; q += 64) {
+        _mm_clflush(q);
+    }
+}
+
+#define FLUSH_CODE(fn) flush_range((const void *)(uintptr_t)(fn), 1024)
+#endif
+
+// Evicts the failure path's code and data from every cache level
+static void flush_caches(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    flush_range((const void *)&g_error_context, sizeof(g_error_context));
+    FLUSH_CODE(path_check);
+    FLUSH_CODE(path_goto_check);
+    FLUSH_CODE(errcheck_log_to_nvram);
+    FLUSH_CODE(errcheck_log_to_nvram_commit);
+    FLUSH_CODE(errcheck_site_id);
+    FLUSH_CODE(errcheck_now_ns);
+#ifdef ERRCHECK_ENABLE_HISTORY
+    flush_range(g_errcheck_history, sizeof(*g_errcheck_history));
+    FLUSH_CODE(errcheck_history_append);
+    FLUSH_CODE(errcheck_record_from_context);
+#endif
+    _mm_mfence();
+#else
+    for (size_t i = 0; i < EVICT_BYTES; i += 64) {
+        g_evict_buf[i]++;
+    }
+#endif
+}
+
+// --- Interference threads: stream writes over a buffer larger than the LLC ---
+static volatile int g_stop_interference = 0;
+
+static void pin_to(int cpu)
+{
+    if (cpu < 0) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        perror("sched_setaffinity");
+    }
+}
+
+static void *interference_main(void *arg)
+{
+    int cpu = (int)(intptr_t)arg;
+    uint8_t *buf = malloc(INTERFERENCE_BYTES);
+
+    pin_to(cpu);
+    while (buf != NULL && !g_stop_interference) {
+        for (size_t i = 0; i < INTERFERENCE_BYTES; i += 64) {
+            buf[i] = (uint8_t)i;
+        }
+    }
+    free(buf);
+    return NULL;
+}
+
+// --- Statistics ---
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double g_ns_per_tick = 1.0;
+
+static void calibrate(void)
+{
+#ifndef ERRCHECK_CYCLES_ARE_NS
+    uint64_t n0 = errcheck_now_ns(), c0 = errcheck_cycles_begin();
+    struct timespec ts = { 0, 100 * 1000 * 1000 };
+    nanosleep(&ts, NULL);
+    uint64_t n1 = errcheck_now_ns(), c1 = errcheck_cycles_end();
+    g_ns_per_tick = (double)(n1 - n0) / (double)(c1 - c0);
+#endif
+}
+
+static void report(const char *config, const char *path, uint64_t *s, size_t n, uint64_t overhead)
+{
+    unsigned hist[HIST_BUCKETS] = {0};
+
+    for (size_t i = 0; i < n; i++) {
+        s[i] = (s[i] > overhead) ? s[i] - overhead : 0;
+        unsigned b = 0;
+        while (b + 1 < HIST_BUCKETS && (s[i] >> (b + 1)) != 0) {
+            b++;
+        }
+        hist[b]++;
+    }
+    qsort(s, n, sizeof(s[0]), cmp_u64);
+
+#define PCT(p) s[(size_t)((double)(n - 1) * (p))]
+    printf("%-24s %-10s %9zu %7llu %7llu %7llu %7llu %7llu %8llu %9llu %10.0f\n",
+           config, path, n, (unsigned long long)s[0], (unsigned long long)PCT(0.5),
+           (unsigned long long)PCT(0.99), (unsigned long long)PCT(0.999),
+           (unsigned long long)PCT(0.9999), (unsigned long long)PCT(0.99999),
+           (unsigned long long)s[n - 1], (double)s[n - 1] * g_ns_per_tick);
+#undef PCT
+
+    printf("    distribution:");
+    for (unsigned b = 0; b < HIST_BUCKETS; b++) {
+        if (hist[b] != 0) {
+            printf(" [%llu,%llu):%u", b == 0 ? 0ull : 1ull << b, 1ull << (b + 1), hist[b]);
+        }
+    }
+    printf("\n");
+}
+
+static uint64_t timer_overhead(void)
+{
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 100000; i++) {
+        uint64_t t0 = errcheck_cycles_begin();
+        uint64_t t1 = errcheck_cycles_end();
+        if (t1 - t0 < best) {
+            best = t1 - t0;
+        }
+    }
+    return best;
+}
+
+static void run_config(const char *config, bool cold, uint64_t *samples, size_t n, uint64_t ovh)
+{
+    static const struct { const char *name; path_fn_t fn; } paths[] = {
+        { "CHECK", path_check },
+        { "GOTO_CHECK", path_goto_check },
+    };
+
+    for (size_t p = 0; p < sizeof(paths) / sizeof(paths[0]); p++) {
+        for (size_t i = 0; i < n; i++) {
+            if (cold) {
+                flush_caches();
+            }
+            uint64_t t0 = errcheck_cycles_begin();
+            err_t r = paths[p].fn();
+            uint64_t t1 = errcheck_cycles_end();
+            if (r != ERR_FAILURE) {
+                fprintf(stderr, "path %s did not fail\n", paths[p].name);
+                exit(1);
+            }
+            samples[i] = t1 - t0;
+        }
+        report(config, paths[p].name, samples, n, ovh);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = 1000000;
+    int cpu = 0;
+    int threads = 2;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:c:t:")) != -1) {
+        switch (opt) {
+        case 'n': n = strtoul(optarg, NULL, 0); break;
+        case 'c': cpu = atoi(optarg); break;
+        case 't': threads = atoi(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-n samples] [-c cpu|-1] [-t threads]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    uint64_t *samples = malloc(n * sizeof(uint64_t));
+    g_evict_buf = calloc(EVICT_BYTES, 1);
+    if (samples == NULL || g_evict_buf == NULL || n == 0) {
+        return 1;
+    }
+
+    pin_to(cpu);
+    calibrate();
+    uint64_t ovh = timer_overhead();
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+    printf("measuring CPU %d, %d interference thread(s), timer overhead %llu ticks "
+           "(subtracted), %.3f ns/tick\n", cpu, threads, (unsigned long long)ovh, g_ns_per_tick);
+    printf("%-24s %-10s %9s %7s %7s %7s %7s %7s %8s %9s %10s\n", "config", "path", "samples",
+           "min", "p50", "p99", "p99.9", "p99.99", "p99.999", "max", "max ns");
+
+    if (threads > 0 && (cpu < 0 || ncpu <= 1)) {
+        printf("note: interference threads are not isolated from the measuring CPU; "
+               "their samples include preemption\n");
+    }
+
+    run_config("warm", false, samples, n, ovh);
+    run_config("cold (flushed)", true, samples, n, ovh);
+
+    pthread_t tid[64];
+    int started = 0;
+    g_stop_interference = 0;
+    for (int i = 0; i < threads && i < 64; i++) {
+        int other = (cpu < 0 || ncpu <= 1) ? -1 : (int)((cpu + 1 + i) % ncpu);
+        if (pthread_create(&tid[started], NULL, interference_main, (void *)(intptr_t)other) == 0) {
+            started++;
+        }
+    }
+    struct timespec warmup = { 0, 50 * 1000 * 1000 };
+    nanosleep(&warmup, NULL);
+
+    run_config("warm + interference", false, samples, n, ovh);
+    run_config("cold + interference", true, samples, n, ovh);
+
+    g_stop_interference = 1;
+    for (int i = 0; i < started; i++) {
+        pthread_join(tid[i], NULL);
+    }
+
+    free(samples);
+    free(g_evict_buf);
+    return 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * =============================================================================
+ * examples/flight_recorder.c
+ * * Demonstrates the shared-memory flight recorder surviving SIGKILL.
+ * * Compile with: -D ERRCHECK_ENABLE_HISTORY -D ERRCHECK_ENABLE_SHM_RECORDER
+ * *               (link src/err_history.c as well)
+ * * Run it twice: the first run kills itself after a few failures, the second
+ * * run prints what the first one left behind before logging its own.
+ * =============================================================================
+ */
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include "../src/errcheck.h"
+#include "../src/err_history.h"
+#include "../app/user_app_errors.h"
+
+#define RECORDER_PATH "/dev/shm/errcheck_example.flight"
+
+// --- Mock Driver (fails on every other attempt) ---
+int sensor_read(int attempt) { return attempt & 1; }
+
+err_t poll_sensor(int attempt)
+{
+    ERRCHECK_BREADCRUMB(0x5E45, attempt);   // "about to read the sensor"
+    CHECK(sensor_read(attempt), ERR_SENSOR);
+    return APP_ERR_NONE;
+}
+
+int main(void)
+{
+    if (errcheck_flight_open(RECORDER_PATH) != 0) {
+        perror("errcheck_flight_open");
+        return 1;
+    }
+
+    // Recovery: whatever the previous process wrote is still in the rings
+    errcheck_record_t prev[ERRCHECK_HISTORY_DEPTH];
+    uint32_t n = errcheck_history_read(&g_errcheck_history->hdr, prev, ERRCHECK_HISTORY_DEPTH);
+    printf("Recovered %u record(s) from generation %u\n",
+           (unsigned)n, (unsigned)(g_errcheck_history->hdr.generation - 1u));
+    for (uint32_t i = 0; i < n; i++) {
+        printf("  seq=%u code=%u line=%u\n",
+               (unsigned)prev[i].seq, (unsigned)prev[i].code, (unsigned)prev[i].line);
+    }
+
+    for (int attempt = 0; attempt < 6; attempt++) {
+        (void)poll_sensor(attempt);
+    }
+
+    if (n == 0) {
+        printf("\nSimulating an abrupt kill; run the example again to recover.\n");
+        fflush(stdout);
+        kill(getpid(), SIGKILL);
+    }
+
+    errcheck_flight_close();
+    unlink(RECORDER_PATH);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * =============================================================================
+ * examples/minidump_crash.c
+ * * A gateway process with a few worker threads logs two failures and then
+ * * dereferences a NULL pointer (or, with "fatal", gives up through
+ * * errcheck_minidump_fatal() and abort(); with "overflow", a worker overflows
+ * * its stack). Every thread takes its own alternate signal stack, so even the
+ * * overflow is dumped. The minidump goes to a file opened at startup.
+ * * Inspect it with tools/errcheck_minidump.
+ * * Compile with: -D ERRCHECK_ENABLE_MINIDUMP -D ERRCHECK_ENABLE_HISTORY
+ * *   gcc -g -pthread -D ERRCHECK_ENABLE_MINIDUMP -D ERRCHECK_ENABLE_HISTORY \
+ * *       -D ERRCHECK_NVRAM_STUB_SILENT examples/minidump_crash.c src/errcheck.c \
+ * *       src/err_minidump.c src/err_history.c app/app_error_strings.c -o minidump_crash
+ * * Usage: minidump_crash <dump-file> [fatal | overflow]
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L // nanosleep()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../src/errcheck.h"
+#include "../src/err_history.h"
+#include "../src/err_minidump.h"
+#include "../app/user_app_errors.h"
+
+#ifndef WORKERS
+    #define WORKERS 3
+#endif
+
+typedef struct {
+    uint32_t rx_bytes;
+    uint8_t *volatile frame;    // Never allocated on the error path
+} uplink_t;
+
+static void *worker(void *arg)
+{
+    struct timespec ts = { 3600, 0 };
+
+    (void)arg;
+    errcheck_minidump_thread_init();
+    nanosleep(&ts, NULL); // Blocked in a syscall: the dump shows its sp and pc
+    return NULL;
+}
+
+// Runaway recursion: each level keeps 1 KiB of stack live
+static uint32_t parse_nested(uint32_t depth)
+{
+    volatile uint8_t frame[1024];
+
+    frame[0] = (uint8_t)depth;
+    if (depth == 0) {
+        return frame[0];
+    }
+    return parse_nested(depth - 1u) + frame[0];
+}
+
+static void *overflow_worker(void *arg)
+{
+    (void)arg;
+    errcheck_minidump_thread_init();
+    ERRCHECK_BREADCRUMB(0x20, 0);
+    return (void *)(uintptr_t)parse_nested(UINT32_MAX);
+}
+
+static err_t radio_attach(void)
+{
+    RETURN_ERR_AND_CONTEXT(ERR_RADIO, 0x2A);
+    return APP_ERR_NONE;
+}
+
+static err_t uplink_send(uplink_t *up)
+{
+    ERRCHECK_BREADCRUMB(0x10, up->rx_bytes);
+    CHECK(radio_attach() == APP_ERR_NONE, ERR_TIMEOUT);
+    return APP_ERR_NONE;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t threads[WORKERS];
+    uplink_t up = { 512, NULL };
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <dump-file> [fatal | overflow]\n", argv[0]);
+        return 2;
+    }
+    int fd = open(argv[1], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0 || errcheck_minidump_install(fd) != 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    for (int i = 0; i < WORKERS; i++) {
+        pthread_create(&threads[i], NULL, worker, NULL);
+    }
+    ERRCHECK_BREADCRUMB(0x01, WORKERS);
+    if (argc > 2 && strcmp(argv[2], "overflow") == 0) {
+        pthread_t runaway;
+        pthread_create(&runaway, NULL, overflow_worker, NULL);
+        pthread_join(runaway, NULL);
+    }
+
+    if (uplink_send(&up) != APP_ERR_NONE) {
+        if (argc > 2 && strcmp(argv[2], "fatal") == 0) {
+            errcheck_minidump_fatal();
+            abort();
+        }
+        // Buggy recovery path: uses the frame it never allocated
+        volatile uint8_t *frame = up.frame;
+        frame[up.rx_bytes] = 0;
+    }
+    printf("not reached\n");
+    return 0;
+}
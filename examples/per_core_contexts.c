@@ -0,0 +1,101 @@
+/**
+ * =============================================================================
+ * examples/per_core_contexts.c
+ * * Emulates an SMP MCU without TLS: one thread per core fails in a tight loop
+ * * and checks that g_error_context still holds its own failure afterwards.
+ * * Built without ERRCHECK_ENABLE_PER_CORE, all "cores" share one context and
+ * * the check catches the other cores' overwrites. Built with it, each core
+ * * has its own context, history ring and counters, and the count is zero.
+ * * Compile with: -D ERRCHECK_ENABLE_PER_CORE -D ERRCHECK_PER_CORE_HOST
+ * *   gcc -O2 -pthread -D ERRCHECK_ENABLE_PER_CORE -D ERRCHECK_PER_CORE_HOST \
+ * *       -D ERRCHECK_CORES=4 -D ERRCHECK_ENABLE_HISTORY -D ERRCHECK_NVRAM_STUB_SILENT \
+ * *       examples/per_core_contexts.c src/errcheck.c src/err_core.c src/err_history.c \
+ * *       src/err_attach.c src/err_log.c app/app_error_strings.c -o per_core_contexts
+ * *   (drop the first two defines and err_core.c for the shared-context build)
+ * * Usage: per_core_contexts [failures-per-core]
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime()
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "../src/errcheck.h"
+#include "../src/err_core.h"
+#include "../src/err_history.h"
+#include "../app/user_app_errors.h"
+
+#ifndef ERRCHECK_CORES
+    #define ERRCHECK_CORES 4u
+#endif
+
+typedef struct {
+    uint32_t core;
+    uint32_t failures;
+    uint32_t foreign;           // Checks that found another core's failure in the context
+    uint64_t elapsed_ns;        // CPU time of the loop
+} core_run_t;
+
+static const err_t s_core_code[4] = { ERR_POWER, ERR_SENSOR, ERR_RADIO, ERR_FLASH };
+
+static uint64_t cpu_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts); // CPU time: threads may share a host CPU
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static err_t adc_sample(uint32_t core, uint32_t i)
+{
+    RETURN_ERR_AND_CONTEXT(s_core_code[core % 4u], i);
+    return APP_ERR_NONE;
+}
+
+static void *core_main(void *arg)
+{
+    core_run_t *run = arg;
+
+#ifdef ERRCHECK_PER_CORE_HOST
+    if (errcheck_core_host_pin(run->core) < 0) {
+        return NULL;
+    }
+#endif
+    uint64_t t0 = cpu_ns();
+    for (uint32_t i = 0; i < run->failures; i++) {
+        (void)adc_sample(run->core, i);
+        if (g_error_context.code != s_core_code[run->core % 4u] ||
+            g_error_context.inner_code != i) {
+            run->foreign++;
+        }
+    }
+    run->elapsed_ns = cpu_ns() - t0;
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t threads[ERRCHECK_CORES];
+    core_run_t runs[ERRCHECK_CORES];
+    uint32_t failures = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 1000000u;
+
+#ifdef ERRCHECK_ENABLE_PER_CORE
+    printf("per-core contexts, %u cores, %u-byte lines\n",
+           (unsigned)ERRCHECK_CORES, (unsigned)ERRCHECK_CACHE_LINE);
+#else
+    printf("one shared context, %u cores\n", (unsigned)ERRCHECK_CORES);
+#endif
+    for (uint32_t c = 0; c < ERRCHECK_CORES; c++) {
+        runs[c] = (core_run_t){ .core = c, .failures = failures };
+        pthread_create(&threads[c], NULL, core_main, &runs[c]);
+    }
+    for (uint32_t c = 0; c < ERRCHECK_CORES; c++) {
+        pthread_join(threads[c], NULL);
+        printf("core %u: %u failures, %u foreign context(s), %.1f ns/failure\n",
+               (unsigned)c, (unsigned)runs[c].failures, (unsigned)runs[c].foreign,
+               (double)runs[c].elapsed_ns / (runs[c].failures ? runs[c].failures : 1u));
+    }
+    errcheck_print_metrics();
+    return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * =============================================================================
+ * examples/virtual_clock.c
+ * * Runs a retry loop with exponential backoff and an overall deadline against
+ * * a virtual clock. Two scenarios, 14 minutes of device time, complete in
+ * * microseconds and produce the same trace on every run.
+ * * Compile with: -D ERRCHECK_ENABLE_TIME_SOURCE -D ERRCHECK_NVRAM_STUB_SILENT
+ * *   gcc -D ERRCHECK_ENABLE_TIME_SOURCE -D ERRCHECK_NVRAM_STUB_SILENT \
+ * *       examples/virtual_clock.c src/errcheck.c src/err_time.c \
+ * *       app/app_error_strings.c -o virtual_clock
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L // clock_gettime()
+#include <stdio.h>
+#include <time.h>
+#include "../src/errcheck.h"
+#include "../src/err_time.h"
+#include "../app/user_app_errors.h"
+
+#define NS_PER_S        1000000000ull
+#define BACKOFF_MIN_S   1u
+#define BACKOFF_MAX_S   64u
+#define DEADLINE_S      600u
+
+// --- Mock modem: refuses to attach for its first 'busy_s' seconds of uptime ---
+static uint64_t s_power_on_ns;
+static uint32_t s_busy_s;
+
+static int modem_attach(void)
+{
+    return errcheck_now_ns() - s_power_on_ns >= (uint64_t)s_busy_s * NS_PER_S;
+}
+
+static err_t modem_try_attach(void)
+{
+    CHECK(modem_attach(), ERR_RADIO);
+    return APP_ERR_NONE;
+}
+
+/**
+ * @brief Retries with doubling backoff until attached or the deadline passes.
+ * * Written against errcheck_now_ns()/errcheck_sleep_ns() only, so the same code
+ * runs on real time in the product and on the virtual clock in tests.
+ */
+static err_t modem_bring_up(uint32_t *attempts)
+{
+    uint64_t deadline = errcheck_now_ns() + (uint64_t)DEADLINE_S * NS_PER_S;
+    uint32_t backoff_s = BACKOFF_MIN_S;
+
+    for (*attempts = 1; ; (*attempts)++) {
+        if (modem_try_attach() == APP_ERR_NONE) {
+            return APP_ERR_NONE;
+        }
+        printf("  t=%4llu s  attempt %2u failed (%s:%u), retry in %u s\n",
+               (unsigned long long)((errcheck_now_ns() - s_power_on_ns) / NS_PER_S),
+               (unsigned)*attempts, g_error_context.file, (unsigned)g_error_context.line,
+               (unsigned)backoff_s);
+        if (errcheck_now_ns() + (uint64_t)backoff_s * NS_PER_S > deadline) {
+            RETURN_ERR_AND_CONTEXT(ERR_TIMEOUT, *attempts);
+        }
+        errcheck_sleep_ns((uint64_t)backoff_s * NS_PER_S);
+        backoff_s = (backoff_s * 2u > BACKOFF_MAX_S) ? BACKOFF_MAX_S : backoff_s * 2u;
+    }
+}
+
+static double wall_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+int main(void)
+{
+    errcheck_vclock_t vc;
+    errcheck_vclock_init(&vc, 0);
+    errcheck_time_set_source(&vc.source);
+
+    for (s_busy_s = 200; s_busy_s <= 700; s_busy_s += 500) {
+        uint32_t attempts = 0;
+        s_power_on_ns = errcheck_now_ns();
+        printf("Modem busy for %u s:\n", (unsigned)s_busy_s);
+
+        double w0 = wall_us();
+        err_t rc = modem_bring_up(&attempts);
+        double w1 = wall_us();
+
+        printf("  -> %s after %u attempt(s), %llu s of device time in %.1f us\n\n",
+               app_error_to_string(rc == APP_ERR_NONE ? APP_ERR_NONE : g_error_context.code),
+               (unsigned)attempts,
+               (unsigned long long)((errcheck_now_ns() - s_power_on_ns) / NS_PER_S), w1 - w0);
+    }
+
+    errcheck_time_set_source(NULL);
+    return 0;
+}
@@ -0,0 +1,234 @@
+/**
+ * =============================================================================
+ * sim/vdev.c
+ * Virtual device models: state machines, latency and fault generation.
+ * =============================================================================
+ * NOTE: Host-only and single-threaded. The PRNG is a seeded xorshift32, so a
+ * given seed and configuration always reproduce the same fault sequence.
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L // nanosleep() in real-time mode
+#include "vdev.h"
+#include <time.h>
+
+static uint64_t s_now_us = 0;
+static uint32_t s_rng = 0x9E3779B9u;
+static bool s_realtime = false;
+static uint32_t s_last_error = VDEV_ERR_NONE;
+
+
+static uint32_t rng_next(void)
+{
+    uint32_t x = s_rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_rng = x;
+    return x;
+}
+
+static bool chance(uint32_t ppm)
+{
+    return ppm != 0 && (rng_next() % 1000000u) < ppm;
+}
+
+// Advances simulated time by the device latency (+ jitter + operation specific time)
+static void spend(const vdev_t *dev, uint32_t extra_us)
+{
+    uint32_t us = dev->cfg.latency_us + extra_us;
+    if (dev->cfg.jitter_us != 0) {
+        us += rng_next() % (dev->cfg.jitter_us + 1u);
+    }
+    s_now_us += us;
+
+    if (s_realtime && us != 0) {
+        struct timespec ts = { (time_t)(us / 1000000u), (long)(us % 1000000u) * 1000L };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static int fail(vdev_t *dev, uint32_t inner)
+{
+    dev->failures++;
+    dev->last_inner = inner;
+    s_last_error = inner;
+    return 0;
+}
+
+// Common operation prologue: consumes time, then draws random and burst faults.
+static int op_begin(vdev_t *dev, uint32_t extra_us, uint32_t default_inner)
+{
+    uint32_t inner = dev->cfg.inner_code != 0 ? dev->cfg.inner_code : default_inner;
+
+    dev->ops++;
+    spend(dev, extra_us);
+
+    if (dev->burst_left > 0) {
+        dev->burst_left--;
+        return fail(dev, inner);
+    }
+    if (dev->cfg.burst_len != 0 && chance(dev->cfg.burst_ppm)) {
+        dev->burst_left = dev->cfg.burst_len - 1u;
+        return fail(dev, inner);
+    }
+    if (chance(dev->cfg.fail_ppm)) {
+        return fail(dev, inner);
+    }
+    return 1;
+}
+
+static bool powered(const vreg_t *supply)
+{
+    return supply == NULL || supply->dev.state == VDEV_ACTIVE;
+}
+
+
+/* --- Simulation control --- */
+
+void vdev_seed(uint32_t seed)
+{
+    s_rng = (seed != 0) ? seed : 0x9E3779B9u; // xorshift must not start at 0
+}
+
+uint64_t vdev_now_us(void)      { return s_now_us; }
+void vdev_reset_clock(void)     { s_now_us = 0; }
+void vdev_set_realtime(bool rt) { s_realtime = rt; }
+uint32_t vdev_last_error(void)  { return s_last_error; }
+
+void vdev_init(vdev_t *dev, const char *name, const vdev_fault_cfg_t *cfg)
+{
+    dev->name = name;
+    dev->state = VDEV_OFF;
+    dev->cfg = *cfg;
+    dev->burst_left = 0;
+    dev->last_inner = VDEV_ERR_NONE;
+    dev->ops = 0;
+    dev->failures = 0;
+}
+
+
+/* --- Power regulator: OFF -> ACTIVE, overcurrent latches FAULT --- */
+
+int vreg_enable(vreg_t *reg)
+{
+    if (reg->dev.state == VDEV_FAULT) {
+        return fail(&reg->dev, VREG_ERR_OVERCURRENT);
+    }
+    if (!op_begin(&reg->dev, reg->ramp_us, VREG_ERR_PGOOD_TIMEOUT)) {
+        if (reg->dev.last_inner == VREG_ERR_OVERCURRENT) {
+            reg->dev.state = VDEV_FAULT;
+        }
+        return 0;
+    }
+    reg->dev.state = VDEV_ACTIVE;
+    return 1;
+}
+
+int vreg_disable(vreg_t *reg)
+{
+    spend(&reg->dev, 0);
+    reg->dev.state = VDEV_OFF; // Also clears a latched overcurrent
+    return 1;
+}
+
+
+/* --- I2C sensor: OFF -> READY (probe) -> ACTIVE (calibrated) --- */
+
+int vsensor_init(vsensor_t *s)
+{
+    if (!powered(s->supply)) {
+        s->dev.ops++;
+        return fail(&s->dev, VI2C_ERR_NACK);
+    }
+    if (!op_begin(&s->dev, 0, VI2C_ERR_NACK)) {
+        return 0;
+    }
+    s->dev.state = VDEV_READY;
+    return 1;
+}
+
+int vsensor_calibrate(vsensor_t *s)
+{
+    if (s->dev.state != VDEV_READY || !powered(s->supply)) {
+        return fail(&s->dev, VDEV_ERR_INVALID_STATE);
+    }
+    if (!op_begin(&s->dev, s->calib_us, VI2C_ERR_ARB_LOST)) {
+        return 0;
+    }
+    s->dev.state = VDEV_ACTIVE;
+    return 1;
+}
+
+int vsensor_deinit(vsensor_t *s)
+{
+    spend(&s->dev, 0);
+    s->dev.state = VDEV_OFF;
+    return 1;
+}
+
+
+/* --- SPI radio: OFF -> STARTING (reset) -> ACTIVE (PLL locked) --- */
+
+int vradio_reset(vradio_t *r)
+{
+    if (!powered(r->supply)) {
+        r->dev.ops++;
+        return fail(&r->dev, VDEV_ERR_INVALID_STATE);
+    }
+    if (!op_begin(&r->dev, 0, VSPI_ERR_CRC)) {
+        return 0;
+    }
+    r->dev.state = VDEV_STARTING;
+    return 1;
+}
+
+int vradio_start(vradio_t *r)
+{
+    if (r->dev.state != VDEV_STARTING || !powered(r->supply)) {
+        return fail(&r->dev, VDEV_ERR_INVALID_STATE);
+    }
+    if (!op_begin(&r->dev, r->pll_lock_us, VSPI_ERR_PLL_UNLOCKED)) {
+        return 0;
+    }
+    r->dev.state = VDEV_ACTIVE;
+    return 1;
+}
+
+int vradio_stop(vradio_t *r)
+{
+    spend(&r->dev, 0);
+    r->dev.state = VDEV_OFF;
+    return 1;
+}
+
+
+/* --- SPI NOR flash: OFF -> READY (ID read) -> verify --- */
+
+int vflash_init(vflash_t *f)
+{
+    if (!powered(f->supply)) {
+        f->dev.ops++;
+        return fail(&f->dev, VFLASH_ERR_JEDEC_ID); // Floating MISO reads back 0xFFFFFF
+    }
+    if (!op_begin(&f->dev, 0, VFLASH_ERR_JEDEC_ID)) {
+        return 0;
+    }
+    f->dev.state = VDEV_READY;
+    return 1;
+}
+
+int vflash_verify(vflash_t *f)
+{
+    if (f->dev.state != VDEV_READY || !powered(f->supply)) {
+        return fail(&f->dev, VDEV_ERR_INVALID_STATE);
+    }
+    return op_begin(&f->dev, f->verify_us, VFLASH_ERR_ECC);
+}
+
+int vflash_deinit(vflash_t *f)
+{
+    spend(&f->dev, 0);
+    f->dev.state = VDEV_OFF;
+    return 1;
+}
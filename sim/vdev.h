@@ -0,0 +1,95 @@
+/**
+ * =============================================================================
+ * sim/vdev.h
+ * Host-side virtual hardware for exercising driver init sequences.
+ * =============================================================================
+ * Four device models (power regulator, I2C sensor, SPI radio, SPI NOR flash),
+ * each a small state machine with configurable latency, jitter, random and
+ * bursty failures, and the inner error codes a real driver would report.
+ * * Driver calls follow the errcheck convention (1 = success, 0 = failure), so
+ * they can be wrapped directly in CHECK()/GOTO_CHECK(). The inner code of the
+ * most recent failure is available from vdev_last_error().
+ * * Time is virtual by default: latencies advance vdev_now_us() instantly, so
+ * thousands of boots can be simulated per second. vdev_set_realtime(true)
+ * makes every operation also sleep for its latency.
+ * =============================================================================
+ */
+
+#ifndef VDEV_H
+#define VDEV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* --- Inner error codes (what a real driver would put in inner_code) --- */
+#define VDEV_ERR_NONE             0x0000u
+#define VDEV_ERR_INVALID_STATE    0x0001u   // Called in the wrong state (e.g. not powered)
+#define VREG_ERR_OVERCURRENT      0x0101u
+#define VREG_ERR_PGOOD_TIMEOUT    0x0102u
+#define VI2C_ERR_NACK             0x0201u
+#define VI2C_ERR_ARB_LOST         0x0202u
+#define VSPI_ERR_PLL_UNLOCKED     0x0301u
+#define VSPI_ERR_CRC              0x0302u
+#define VFLASH_ERR_JEDEC_ID       0x0401u   // Chip did not answer with the expected ID
+#define VFLASH_ERR_ECC            0x0402u
+
+/* --- Fault and timing model shared by all devices --- */
+typedef struct {
+    uint32_t latency_us;        // Nominal duration of each operation
+    uint32_t jitter_us;         // Uniform extra latency in [0, jitter_us]
+    uint32_t fail_ppm;          // Independent failure probability per operation
+    uint32_t burst_ppm;         // Probability per operation of entering a fault burst
+    uint32_t burst_len;         // Operations failing in a row once a burst starts
+    uint32_t inner_code;        // Reported for random/burst failures (0: device default)
+} vdev_fault_cfg_t;
+
+typedef enum {
+    VDEV_OFF = 0,
+    VDEV_STARTING,              // Powered, not yet configured
+    VDEV_READY,
+    VDEV_ACTIVE,                // Regulator output on, radio receiving, ...
+    VDEV_FAULT                  // Latched fault; only deinit/disable recovers
+} vdev_state_t;
+
+typedef struct {
+    const char *name;
+    vdev_state_t state;
+    vdev_fault_cfg_t cfg;
+    uint32_t burst_left;
+    uint32_t last_inner;        // Inner code of this device's last failure
+    uint32_t ops;
+    uint32_t failures;
+} vdev_t;
+
+/* --- Device models --- */
+// Downstream devices NACK / fail with VDEV_ERR_INVALID_STATE while 'supply' is not ACTIVE
+typedef struct { vdev_t dev; uint32_t ramp_us; } vreg_t;           // Extra latency until power-good
+typedef struct { vdev_t dev; const vreg_t *supply; uint32_t calib_us; } vsensor_t;
+typedef struct { vdev_t dev; const vreg_t *supply; uint32_t pll_lock_us; } vradio_t;
+typedef struct { vdev_t dev; const vreg_t *supply; uint32_t verify_us; } vflash_t;
+
+/* --- Simulation control --- */
+void     vdev_seed(uint32_t seed);
+uint64_t vdev_now_us(void);
+void     vdev_reset_clock(void);
+void     vdev_set_realtime(bool realtime);
+uint32_t vdev_last_error(void);                 // Inner code of the latest failure, any device
+void     vdev_init(vdev_t *dev, const char *name, const vdev_fault_cfg_t *cfg);
+
+/* --- Driver API (1 = success, 0 = failure) --- */
+int vreg_enable(vreg_t *reg);
+int vreg_disable(vreg_t *reg);
+
+int vsensor_init(vsensor_t *s);
+int vsensor_calibrate(vsensor_t *s);
+int vsensor_deinit(vsensor_t *s);
+
+int vradio_reset(vradio_t *r);
+int vradio_start(vradio_t *r);
+int vradio_stop(vradio_t *r);
+
+int vflash_init(vflash_t *f);
+int vflash_verify(vflash_t *f);
+int vflash_deinit(vflash_t *f);
+
+#endif /* VDEV_H */
@@ -0,0 +1,63 @@
+/**
+ * =============================================================================
+ * err_acct.h
+ * Optional self-accounting of CPU time spent inside errcheck.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_SELF_ACCOUNTING (link err_acct.c)
+ * * Library code brackets its own work with ERRCHECK_ACCT_START() and charges
+ * each lap to a category with ERRCHECK_ACCT_LAP(), so categories never overlap.
+ * Only failure, logging and formatting paths are timed: the pass path of a
+ * CHECK() is a single compare and stays untouched. Without the define all
+ * macros expand to nothing.
+ * * Each thread charges its own slot (claimed on first use, never recycled, so
+ * totals include exited threads); threads beyond ERRCHECK_ACCT_MAX_THREADS
+ * share the last slot.
+ * =============================================================================
+ */
+
+#ifndef ERR_ACCT_H
+#define ERR_ACCT_H
+
+#include <stdint.h>
+#include "errcheck.h"
+
+#ifndef ERRCHECK_ACCT_MAX_THREADS
+    #define ERRCHECK_ACCT_MAX_THREADS 32u
+#endif
+
+typedef enum {
+    ERRCHECK_ACCT_CAPTURE = 0,  // Building the persisted record (site hash, timestamp)
+    ERRCHECK_ACCT_LOG,          // NVRAM write and the remainder of errcheck_log_to_nvram()
+    ERRCHECK_ACCT_SINK,         // History ring, retained RAM and other record sinks
+    ERRCHECK_ACCT_FORMAT,       // Human-readable output (err_log.c)
+    ERRCHECK_ACCT_INJECT,       // Fault-injection decisions that fired
+    ERRCHECK_ACCT_CATEGORIES
+} errcheck_acct_category_t;
+
+typedef struct {
+    uint64_t cycles[ERRCHECK_ACCT_CATEGORIES];  // errcheck_cycles() ticks (see err_cycles.h)
+    uint64_t calls[ERRCHECK_ACCT_CATEGORIES];
+} errcheck_acct_t;
+
+#ifdef ERRCHECK_ENABLE_SELF_ACCOUNTING
+    #include "err_cycles.h"
+
+    void errcheck_acct_add(errcheck_acct_category_t cat, uint64_t cycles);
+    // Counters of the calling thread
+    void errcheck_acct_snapshot(errcheck_acct_t *out);
+    // Sum over every thread that ever charged time; returns the number of threads
+    uint32_t errcheck_acct_snapshot_all(errcheck_acct_t *out);
+    const char *errcheck_acct_category_name(errcheck_acct_category_t cat);
+
+    #define ERRCHECK_ACCT_START(t)      uint64_t t = errcheck_cycles()
+    #define ERRCHECK_ACCT_LAP(t, cat) do {                      \
+        uint64_t __acct_now = errcheck_cycles();                \
+        errcheck_acct_add((cat), __acct_now - (t));             \
+        (t) = __acct_now;                                       \
+    } while (0)
+#else
+    #define ERRCHECK_ACCT_START(t)      do { } while (0)
+    #define ERRCHECK_ACCT_LAP(t, cat)   do { } while (0)
+#endif
+
+#endif /* ERR_ACCT_H */
@@ -0,0 +1,158 @@
+/**
+ * =============================================================================
+ * err_alloc.c
+ * Allocation wrappers, fixed-block pools and their injection point.
+ * =============================================================================
+ * NOTE: The injection decision is taken before the real allocation, so an
+ * injected failure never allocates and never leaks. Failures are logged
+ * through g_error_context like RETURN_ERR_AND_CONTEXT(), which keeps every
+ * sink (history, sketch, anomaly, retained ring, NVRAM) in one place.
+ * =============================================================================
+ */
+
+#include "err_alloc.h"
+#include "err_usdt.h"
+#include <stdlib.h>
+
+#ifdef ERRCHECK_ENABLE_ALLOC
+
+#ifdef ERRCHECK_ENABLE_INJECT
+#include "err_inject.h"
+#endif
+
+static uint32_t s_alloc_failures = 0;
+static uint32_t s_alloc_injected = 0;
+
+// True if this allocation must fail; consumes a one-shot debugger flag
+static bool alloc_inject(const char *file, uint32_t line)
+{
+#ifdef ERRCHECK_ENABLE_RUNTIME_INJECTION
+    if (g_inject_error_flag == ERRCHECK_ERR_NOMEM) {
+        g_inject_error_flag = 0;
+        ERRCHECK_USDT3(inject, ERRCHECK_ERR_NOMEM, file, line);
+        return true;
+    }
+#endif
+#ifdef ERRCHECK_ENABLE_INJECT
+    if (__atomic_load_n(&g_errcheck_inject_armed, __ATOMIC_RELAXED)
+        && errcheck_inject_eval(ERRCHECK_ERR_NOMEM, file, line, 1) == 0) {
+        return true;
+    }
+#endif
+    (void)file;
+    (void)line;
+    return false;
+}
+
+// Logs the failed allocation as a failure of its own site; returns NULL
+static void *alloc_failed(size_t size, const char *file, uint32_t line, bool injected)
+{
+    __atomic_fetch_add(&s_alloc_failures, 1u, __ATOMIC_RELAXED);
+    if (injected) {
+        __atomic_fetch_add(&s_alloc_injected, 1u, __ATOMIC_RELAXED);
+    }
+    // Resolved once (per-core builds); the caller's site, so not ERRCHECK_SET_CONTEXT()
+    failure_context_t *ctx = &g_error_context;
+    ctx->code = ERRCHECK_ERR_NOMEM;
+    ctx->inner_code = (size > UINT32_MAX) ? UINT32_MAX : (uint32_t)size;
+    ctx->file = file;
+    ctx->line = line;
+    ctx->logged_to_nvram = false;
+    ERRCHECK_USDT4(check_fail, ERRCHECK_ERR_NOMEM, ctx->inner_code, file, line);
+    errcheck_log_to_nvram();
+    return NULL;
+}
+
+void *errcheck_malloc(size_t size, const char *file, uint32_t line)
+{
+    if (alloc_inject(file, line)) {
+        return alloc_failed(size, file, line, true);
+    }
+    void *p = malloc(size);
+    return (p != NULL || size == 0) ? p : alloc_failed(size, file, line, false);
+}
+
+void *errcheck_calloc(size_t count, size_t size, const char *file, uint32_t line)
+{
+    size_t total = (size != 0 && count > SIZE_MAX / size) ? SIZE_MAX : count * size;
+
+    if (alloc_inject(file, line)) {
+        return alloc_failed(total, file, line, true);
+    }
+    void *p = calloc(count, size);
+    return (p != NULL || total == 0) ? p : alloc_failed(total, file, line, false);
+}
+
+void *errcheck_realloc(void *ptr, size_t size, const char *file, uint32_t line)
+{
+    // realloc(ptr, 0) releases memory; there is no failure path to exercise
+    if (size != 0 && alloc_inject(file, line)) {
+        return alloc_failed(size, file, line, true);
+    }
+    void *p = realloc(ptr, size);
+    return (p != NULL || size == 0) ? p : alloc_failed(size, file, line, false);
+}
+
+/**
+ * @brief Carves 'storage' into blocks and links them all into the free list.
+ */
+bool errcheck_pool_init(errcheck_pool_t *pool, void *storage, size_t storage_size,
+                        size_t block_size)
+{
+    size_t align = sizeof(void *);
+    size_t bs = (block_size < align) ? align : (block_size + align - 1u) / align * align;
+    size_t n = (storage != NULL) ? storage_size / bs : 0;
+    uint8_t *base = storage;
+
+    pool->free_list = NULL;
+    pool->block_size = bs;
+    pool->blocks = (n > UINT32_MAX) ? UINT32_MAX : (uint32_t)n;
+    pool->in_use = 0;
+    pool->high_water = 0;
+    for (uint32_t i = pool->blocks; i-- > 0;) {
+        void **block = (void **)(void *)(base + (size_t)i * bs);
+        *block = pool->free_list;
+        pool->free_list = block;
+    }
+    return pool->blocks > 0;
+}
+
+void *errcheck_pool_alloc(errcheck_pool_t *pool, const char *file, uint32_t line)
+{
+    void **block = pool->free_list;
+
+    if (alloc_inject(file, line)) {
+        return alloc_failed(pool->block_size, file, line, true);
+    }
+    if (block == NULL) {
+        return alloc_failed(pool->block_size, file, line, false);
+    }
+    pool->free_list = *block;
+    pool->in_use++;
+    if (pool->in_use > pool->high_water) {
+        pool->high_water = pool->in_use;
+    }
+    return block;
+}
+
+void errcheck_pool_free(errcheck_pool_t *pool, void *block)
+{
+    if (block == NULL) {
+        return;
+    }
+    *(void **)block = pool->free_list;
+    pool->free_list = block;
+    pool->in_use--;
+}
+
+uint32_t errcheck_alloc_failures(void)
+{
+    return __atomic_load_n(&s_alloc_failures, __ATOMIC_RELAXED);
+}
+
+uint32_t errcheck_alloc_injected(void)
+{
+    return __atomic_load_n(&s_alloc_injected, __ATOMIC_RELAXED);
+}
+
+#endif /* ERRCHECK_ENABLE_ALLOC */
@@ -0,0 +1,84 @@
+/**
+ * =============================================================================
+ * err_alloc.h
+ * Allocation wrappers and fixed-block pools that fail like a CHECK() site.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_ALLOC (link err_alloc.c)
+ * * ERRCHECK_MALLOC()/CALLOC()/REALLOC() and ERRCHECK_POOL_ALLOC() take the
+ * allocation site from __FILE__/__LINE__ and consult the same injection as a
+ * guarded call, with code ERRCHECK_ERR_NOMEM:
+ *   - rules in err_inject.h (site, code, once/nth/every/rate), when
+ *     ERRCHECK_ENABLE_INJECT is also defined;
+ *   - g_inject_error_flag == ERRCHECK_ERR_NOMEM (one shot), when
+ *     ERRCHECK_ENABLE_RUNTIME_INJECTION is defined.
+ * With ERRCHECK_ENABLE_SITE_TABLE every wrapper call is listed in the site
+ * table, so tools/errcheck_campaign explores allocation failures as well.
+ * * A failed allocation, real or injected, returns NULL and is logged at once
+ * as an ERRCHECK_ERR_NOMEM failure of the allocation site (inner code: the
+ * requested size, saturating at 0xFFFFFFFF). The CHECK() that then tests the
+ * pointer logs its own code at its own line, so the record of the root cause
+ * comes first.
+ * * Pools hand out fixed-size blocks from caller-provided storage through a free
+ * list (O(1), no fragmentation). A pool is not thread-safe: use one per task
+ * or lock around it.
+ * =============================================================================
+ */
+
+#ifndef ERR_ALLOC_H
+#define ERR_ALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "errcheck.h"
+
+// Failure code of allocation records
+#ifndef ERRCHECK_ERR_NOMEM
+    #define ERRCHECK_ERR_NOMEM ((err_t)0xFD)
+#endif
+
+typedef struct {
+    void *free_list;            // Next free block; each free block links to the next
+    size_t block_size;
+    uint32_t blocks;
+    uint32_t in_use;
+    uint32_t high_water;
+} errcheck_pool_t;
+
+#ifdef ERRCHECK_ENABLE_ALLOC
+    void *errcheck_malloc(size_t size, const char *file, uint32_t line);
+    void *errcheck_calloc(size_t count, size_t size, const char *file, uint32_t line);
+    // On failure the original block is left untouched, as with realloc()
+    void *errcheck_realloc(void *ptr, size_t size, const char *file, uint32_t line);
+
+    // 'storage' holds 'blocks' blocks of 'block_size' bytes; the size is rounded
+    // up to a multiple of sizeof(void *) and 'storage' must be aligned for it.
+    // Returns false if the storage is too small for a single block.
+    bool errcheck_pool_init(errcheck_pool_t *pool, void *storage, size_t storage_size,
+                            size_t block_size);
+    void *errcheck_pool_alloc(errcheck_pool_t *pool, const char *file, uint32_t line);
+    void errcheck_pool_free(errcheck_pool_t *pool, void *block);
+
+    // Failed allocations so far, and how many of them were injected
+    uint32_t errcheck_alloc_failures(void);
+    uint32_t errcheck_alloc_injected(void);
+
+    #if defined(ERRCHECK_ENABLE_SITE_TABLE) && defined(__GNUC__)
+        #define ERRCHECK_ALLOC_SITE(call) __extension__({                  \
+            ERRCHECK_SITE_RECORD(ERRCHECK_ERR_NOMEM);                      \
+            (call);                                                        \
+        })
+    #else
+        #define ERRCHECK_ALLOC_SITE(call) (call)
+    #endif
+
+    #define ERRCHECK_MALLOC(size) \
+        ERRCHECK_ALLOC_SITE(errcheck_malloc((size), __FILE__, __LINE__))
+    #define ERRCHECK_CALLOC(count, size) \
+        ERRCHECK_ALLOC_SITE(errcheck_calloc((count), (size), __FILE__, __LINE__))
+    #define ERRCHECK_REALLOC(ptr, size) \
+        ERRCHECK_ALLOC_SITE(errcheck_realloc((ptr), (size), __FILE__, __LINE__))
+    #define ERRCHECK_POOL_ALLOC(pool) \
+        ERRCHECK_ALLOC_SITE(errcheck_pool_alloc((pool), __FILE__, __LINE__))
+#endif
+
+#endif /* ERR_ALLOC_H */
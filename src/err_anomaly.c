@@ -0,0 +1,130 @@
+/**
+ * =============================================================================
+ * err_anomaly.c
+ * Integer EWMA rate/variance tracking with k-sigma alarms.
+ * =============================================================================
+ * NOTE: Only errcheck_anomaly_tick() writes the statistics, with atomic stores
+ * so the hook's reads are never torn; the failure path performs one atomic
+ * increment and one compare. Exactly one failure per window
+ * sees the counter equal 'fire_at', so the hook runs at most once per window
+ * and code even with several failing threads.
+ * Anomalous windows are folded into the baseline like any other: a sustained
+ * new rate raises one alarm and then becomes the norm.
+ * * EWMA update with alpha = 2^-s (West's incremental form):
+ *     diff = x - mean;  incr = diff * alpha;  mean += incr;
+ *     var  = (1 - alpha) * (var + diff * incr)
+ * =============================================================================
+ */
+
+#include "err_anomaly.h"
+#include <stddef.h>
+
+#ifdef ERRCHECK_ENABLE_ANOMALY
+
+#define ANOMALY_MAX_WINDOW 0xFFFFu  // Window counts saturate here for the statistics
+
+static errcheck_anomaly_slot_t s_anomaly[ERRCHECK_ANOMALY_CODES];
+static errcheck_anomaly_hook_t s_anomaly_hook = NULL;
+
+static errcheck_anomaly_slot_t *anomaly_slot(uint32_t code)
+{
+    return &s_anomaly[code < ERRCHECK_ANOMALY_CODES ? code : ERRCHECK_ANOMALY_CODES - 1u];
+}
+
+static uint32_t isqrt64(uint64_t v)
+{
+    uint64_t root = 0, bit = 1ull << 62;
+
+    while (bit > v) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+void errcheck_anomaly_record(uint32_t code)
+{
+    errcheck_anomaly_slot_t *s = anomaly_slot(code);
+    uint32_t n = __atomic_add_fetch(&s->window, 1u, __ATOMIC_RELAXED);
+    uint32_t fire_at = __atomic_load_n(&s->fire_at, __ATOMIC_RELAXED);
+    errcheck_anomaly_hook_t hook = __atomic_load_n(&s_anomaly_hook, __ATOMIC_ACQUIRE);
+
+    if (n != fire_at || fire_at == 0) {
+        return;
+    }
+    __atomic_fetch_add(&s->alarms, 1u, __ATOMIC_RELAXED);
+    if (hook != NULL) {
+        hook(code, n, __atomic_load_n(&s->mean_q16, __ATOMIC_RELAXED),
+             errcheck_anomaly_sigma_q16(s));
+    }
+}
+
+uint32_t errcheck_anomaly_sigma_q16(const errcheck_anomaly_slot_t *slot)
+{
+    // sqrt of a Q16.16 value is Q8.8; scale the radicand up so the root is Q16.16.
+    // Window counts are capped at ANOMALY_MAX_WINDOW, so var << 16 only
+    // overflows for a variance beyond any reachable one (sigma >= 2^16).
+    uint64_t var = __atomic_load_n(&slot->var_q16, __ATOMIC_RELAXED);
+    return (var >> 48) != 0 ? UINT32_MAX : isqrt64(var << 16);
+}
+
+void errcheck_anomaly_tick(void)
+{
+    for (uint32_t i = 0; i < ERRCHECK_ANOMALY_CODES; i++) {
+        errcheck_anomaly_slot_t *s = &s_anomaly[i];
+        uint32_t x = __atomic_exchange_n(&s->window, 0u, __ATOMIC_RELAXED);
+
+        if (x > ANOMALY_MAX_WINDOW) {
+            x = ANOMALY_MAX_WINDOW;
+        }
+
+        int64_t diff = ((int64_t)x << 16) - (int64_t)s->mean_q16;
+        int64_t incr = diff / (1 << ERRCHECK_ANOMALY_ALPHA_SHIFT);
+        uint64_t sq = (uint64_t)(diff < 0 ? -diff : diff) * (uint64_t)(incr < 0 ? -incr : incr);
+        uint64_t var = s->var_q16 + (sq >> 16);
+
+        __atomic_store_n(&s->mean_q16, (uint32_t)((int64_t)s->mean_q16 + incr), __ATOMIC_RELAXED);
+        __atomic_store_n(&s->var_q16, var - (var >> ERRCHECK_ANOMALY_ALPHA_SHIFT), __ATOMIC_RELAXED);
+        if (s->ticks < UINT32_MAX) {
+            s->ticks++;
+        }
+
+        uint32_t fire_at = 0;
+        if (s->ticks >= ERRCHECK_ANOMALY_WARMUP_TICKS) {
+            uint64_t limit = (uint64_t)s->mean_q16
+                           + (uint64_t)ERRCHECK_ANOMALY_K_SIGMA * errcheck_anomaly_sigma_q16(s);
+            limit = (limit + 0xFFFFu) >> 16;   // Round up to whole failures
+            if (limit < ERRCHECK_ANOMALY_MIN_EVENTS) {
+                limit = ERRCHECK_ANOMALY_MIN_EVENTS;
+            }
+            fire_at = (limit >= UINT32_MAX) ? 0 : (uint32_t)limit + 1u;
+        }
+        __atomic_store_n(&s->fire_at, fire_at, __ATOMIC_RELAXED);
+    }
+}
+
+void errcheck_anomaly_set_hook(errcheck_anomaly_hook_t hook)
+{
+    __atomic_store_n(&s_anomaly_hook, hook, __ATOMIC_RELEASE);
+}
+
+void errcheck_anomaly_get(uint32_t code, errcheck_anomaly_slot_t *out)
+{
+    const errcheck_anomaly_slot_t *s = anomaly_slot(code);
+
+    *out = *s;
+    out->window = __atomic_load_n(&s->window, __ATOMIC_RELAXED);
+    out->mean_q16 = __atomic_load_n(&s->mean_q16, __ATOMIC_RELAXED);
+    out->var_q16 = __atomic_load_n(&s->var_q16, __ATOMIC_RELAXED);
+    out->alarms = __atomic_load_n(&s->alarms, __ATOMIC_RELAXED);
+}
+
+#endif /* ERRCHECK_ENABLE_ANOMALY */
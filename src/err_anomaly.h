@@ -0,0 +1,71 @@
+/**
+ * =============================================================================
+ * err_anomaly.h
+ * Online anomaly detection on per-code failure rates.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_ANOMALY (link err_anomaly.c)
+ * * The application calls errcheck_anomaly_tick() at a fixed period (e.g. 1 s).
+ * Each tick folds the failures counted per code since the previous tick into an
+ * exponentially weighted mean and variance (alpha = 2^-ERRCHECK_ANOMALY_ALPHA_SHIFT,
+ * Q16.16 integer arithmetic, no floating point) and derives the next window's
+ * threshold: mean + ERRCHECK_ANOMALY_K_SIGMA * sigma, never below
+ * ERRCHECK_ANOMALY_MIN_EVENTS.
+ * * Each logged failure increments its code's window counter. The failure that
+ * pushes the counter past the threshold calls the hook once per window, so the
+ * application reacts while the burst is still in progress. No alarms are raised
+ * during the first ERRCHECK_ANOMALY_WARMUP_TICKS ticks of a code.
+ * * Codes >= ERRCHECK_ANOMALY_CODES share the last slot. Footprint:
+ * ERRCHECK_ANOMALY_CODES x 32 bytes.
+ * =============================================================================
+ */
+
+#ifndef ERR_ANOMALY_H
+#define ERR_ANOMALY_H
+
+#include <stdint.h>
+#include "errcheck.h"
+
+#ifndef ERRCHECK_ANOMALY_CODES
+    #define ERRCHECK_ANOMALY_CODES        16u
+#endif
+#ifndef ERRCHECK_ANOMALY_ALPHA_SHIFT
+    #define ERRCHECK_ANOMALY_ALPHA_SHIFT  4u    // alpha = 1/16
+#endif
+#ifndef ERRCHECK_ANOMALY_K_SIGMA
+    #define ERRCHECK_ANOMALY_K_SIGMA      4u
+#endif
+#ifndef ERRCHECK_ANOMALY_MIN_EVENTS
+    #define ERRCHECK_ANOMALY_MIN_EVENTS   3u    // Never alarm on fewer failures per window
+#endif
+#ifndef ERRCHECK_ANOMALY_WARMUP_TICKS
+    #define ERRCHECK_ANOMALY_WARMUP_TICKS 16u
+#endif
+
+typedef struct {
+    uint32_t window;            // Failures since the last tick
+    uint32_t fire_at;           // Window count that raises the hook (0 while warming up)
+    uint32_t mean_q16;          // EWMA failures per tick, Q16.16
+    uint32_t ticks;             // Ticks observed (saturating)
+    uint64_t var_q16;           // EWMA variance, Q16.16
+    uint32_t alarms;            // Hook invocations
+    uint32_t reserved;
+} errcheck_anomaly_slot_t;
+
+// Called from the failure path: keep it short (set a flag, post an event).
+// 'count' is the window count that crossed the threshold; mean and sigma are Q16.16.
+typedef void (*errcheck_anomaly_hook_t)(uint32_t code, uint32_t count,
+                                        uint32_t mean_q16, uint32_t sigma_q16);
+
+#ifdef ERRCHECK_ENABLE_ANOMALY
+    // Called from errcheck_log_to_nvram_commit()
+    void errcheck_anomaly_record(uint32_t code);
+
+    // Periodic update; call from one task only
+    void errcheck_anomaly_tick(void);
+
+    void errcheck_anomaly_set_hook(errcheck_anomaly_hook_t hook);
+    void errcheck_anomaly_get(uint32_t code, errcheck_anomaly_slot_t *out);
+    uint32_t errcheck_anomaly_sigma_q16(const errcheck_anomaly_slot_t *slot);
+#endif
+
+#endif /* ERR_ANOMALY_H */
@@ -0,0 +1,149 @@
+/**
+ * =============================================================================
+ * err_attach.c
+ * Per-thread attachment arena and the offline entry decoder.
+ * =============================================================================
+ * NOTE: The arena is only touched by its own thread. A block in the history
+ * ring is published like a record: its seq is cleared first and written last,
+ * so a reader that sees the owning record's seq before and after copying the
+ * block never takes a half-rewritten one.
+ * =============================================================================
+ */
+
+#include "err_attach.h"
+#include <string.h>
+
+#ifdef ERRCHECK_ENABLE_ATTACH
+
+typedef struct {
+    uint16_t used;
+    uint16_t flags;
+    uint8_t data[ERRCHECK_ATTACH_BYTES];
+} attach_arena_t;
+
+static ERRCHECK_THREAD_LOCAL attach_arena_t t_attach;
+
+static void attach_put(uint8_t key, uint8_t type, const void *value, uint8_t size, bool prefixed)
+{
+    attach_arena_t *a = &t_attach;
+    uint32_t need = 2u + (prefixed ? 1u : 0u) + size;
+
+    if (key == 0 || a->used + need > ERRCHECK_ATTACH_BYTES) {
+        a->flags |= ERRCHECK_ATTACH_TRUNCATED;
+        return;
+    }
+    uint8_t *p = &a->data[a->used];
+    *p++ = key;
+    *p++ = type;
+    if (prefixed) {
+        *p++ = size;
+    }
+    memcpy(p, value, size);
+    a->used = (uint16_t)(a->used + need);
+}
+
+void errcheck_attach_u32(uint8_t key, uint32_t value)
+{
+    attach_put(key, ERRCHECK_ATT_U32, &value, sizeof(value), false);
+}
+
+void errcheck_attach_i32(uint8_t key, int32_t value)
+{
+    attach_put(key, ERRCHECK_ATT_I32, &value, sizeof(value), false);
+}
+
+void errcheck_attach_u64(uint8_t key, uint64_t value)
+{
+    attach_put(key, ERRCHECK_ATT_U64, &value, sizeof(value), false);
+}
+
+void errcheck_attach_hex32(uint8_t key, uint32_t value)
+{
+    attach_put(key, ERRCHECK_ATT_HEX32, &value, sizeof(value), false);
+}
+
+void errcheck_attach_bytes(uint8_t key, const void *data, uint8_t size)
+{
+    attach_put(key, ERRCHECK_ATT_BYTES, data, size, true);
+}
+
+void errcheck_attach_clear(void)
+{
+    t_attach.used = 0;
+    t_attach.flags = 0;
+}
+
+bool errcheck_attach_pending(void)
+{
+    return t_attach.used != 0 || t_attach.flags != 0;
+}
+
+/**
+ * @brief Publishes the arena as the attachment block of record 'seq' and empties it.
+ */
+void errcheck_attach_take(errcheck_attach_block_t *block, uint32_t seq)
+{
+    __atomic_store_n(&block->seq, 0u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(block->data, t_attach.data, t_attach.used);
+    block->len = t_attach.used;
+    block->flags = t_attach.flags;
+    __atomic_store_n(&block->seq, seq, __ATOMIC_RELEASE);
+    errcheck_attach_clear();
+}
+
+#endif /* ERRCHECK_ENABLE_ATTACH */
+
+/**
+ * @brief Decodes one entry; used by tools, so it trusts nothing in 'data'.
+ */
+bool errcheck_attach_next(const uint8_t *data, uint16_t len, uint16_t *pos,
+                          errcheck_attach_t *out)
+{
+    uint32_t p = *pos;
+
+    if (p + 2u > len || data[p] == 0) {
+        return false;
+    }
+    out->key = data[p];
+    out->type = data[p + 1u];
+    out->value = 0;
+    out->bytes = NULL;
+    p += 2u;
+
+    switch (out->type) {
+    case ERRCHECK_ATT_U32:
+    case ERRCHECK_ATT_HEX32:
+    case ERRCHECK_ATT_I32: {
+        uint32_t v;
+        if (p + sizeof(v) > len) {
+            return false;
+        }
+        memcpy(&v, &data[p], sizeof(v));
+        out->value = (out->type == ERRCHECK_ATT_I32) ? (uint64_t)(int64_t)(int32_t)v : v;
+        out->size = sizeof(v);
+        p += sizeof(v);
+        break;
+    }
+    case ERRCHECK_ATT_U64:
+        if (p + sizeof(out->value) > len) {
+            return false;
+        }
+        memcpy(&out->value, &data[p], sizeof(out->value));
+        out->size = sizeof(out->value);
+        p += sizeof(out->value);
+        break;
+    case ERRCHECK_ATT_BYTES:
+        if (p + 1u > len || p + 1u + data[p] > len) {
+            return false;
+        }
+        out->size = data[p];
+        out->bytes = &data[p + 1u];
+        p += 1u + data[p];
+        break;
+    default:
+        return false;
+    }
+    *pos = (uint16_t)p;
+    return true;
+}
@@ -0,0 +1,89 @@
+/**
+ * =============================================================================
+ * err_attach.h
+ * Typed key/value attachments stored with failure records.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_ATTACH (link err_attach.c; needs
+ *              ERRCHECK_ENABLE_HISTORY)
+ * * inner_code holds one number. Code that detects a failure, typically a
+ * driver just before it returns 0 to a CHECK(), can attach more of its
+ * state: a channel, a sensor id, a byte count, a status register, a few raw
+ * bytes. Each attachment is copied into a per-thread arena in a fixed
+ * binary layout (key, type, raw value), so it costs a handful of stores and
+ * no formatting. The next failure logged on that thread takes the arena
+ * along: the history ring keeps one attachment block per record slot, so
+ * attachments persist in the flight recorder file next to their record. The
+ * record carries ERRCHECK_REC_ATTACHED. Tools format the blocks offline with
+ * errcheck_attach_next().
+ * * Entry layout, values in host byte order:
+ *   key:8 (1..255)  type:8  value (4 or 8 bytes; BYTES: length:8 then data)
+ * An entry that does not fit the arena is dropped and the block is marked
+ * ERRCHECK_ATTACH_TRUNCATED. Attachments of a failure that is handled without
+ * being logged stay in the arena: call errcheck_attach_clear() when swallowing
+ * an error.
+ * =============================================================================
+ */
+
+#ifndef ERR_ATTACH_H
+#define ERR_ATTACH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "errcheck.h"
+
+#ifndef ERRCHECK_ATTACH_BYTES
+    #define ERRCHECK_ATTACH_BYTES 56u   // Arena and block payload; block is 64 bytes
+#endif
+
+typedef enum {
+    ERRCHECK_ATT_U32 = 1,
+    ERRCHECK_ATT_I32,
+    ERRCHECK_ATT_U64,
+    ERRCHECK_ATT_HEX32,             // Register or bit field: printed in hex
+    ERRCHECK_ATT_BYTES              // Up to 255 bytes, length-prefixed
+} errcheck_attach_type_t;
+
+#define ERRCHECK_ATTACH_TRUNCATED 0x0001u
+
+/* --- Attachment block persisted per history slot --- */
+typedef struct {
+    uint32_t seq;                   // seq of the owning record; 0 while empty or rewritten
+    uint16_t len;                   // Bytes used in 'data'
+    uint16_t flags;                 // ERRCHECK_ATTACH_* bits
+    uint8_t data[ERRCHECK_ATTACH_BYTES];
+} errcheck_attach_block_t;
+
+/* --- One decoded entry --- */
+typedef struct {
+    uint8_t key;
+    uint8_t type;                   // errcheck_attach_type_t
+    uint8_t size;                   // Bytes at 'bytes' (BYTES only)
+    uint64_t value;                 // Numeric types; I32 is sign-extended
+    const uint8_t *bytes;
+} errcheck_attach_t;
+
+// Decodes the entry at '*pos' of a block payload and advances '*pos'. Returns
+// false at the end or on a malformed entry. Available without the define.
+bool errcheck_attach_next(const uint8_t *data, uint16_t len, uint16_t *pos,
+                          errcheck_attach_t *out);
+
+#ifdef ERRCHECK_ENABLE_ATTACH
+    #ifndef ERRCHECK_ENABLE_HISTORY
+        #error "ERRCHECK_ENABLE_ATTACH requires ERRCHECK_ENABLE_HISTORY"
+    #endif
+
+    void errcheck_attach_u32(uint8_t key, uint32_t value);
+    void errcheck_attach_i32(uint8_t key, int32_t value);
+    void errcheck_attach_u64(uint8_t key, uint64_t value);
+    void errcheck_attach_hex32(uint8_t key, uint32_t value);
+    void errcheck_attach_bytes(uint8_t key, const void *data, uint8_t size);
+    // Drops this thread's pending attachments
+    void errcheck_attach_clear(void);
+
+    // True if this thread has attachments waiting for the next record
+    bool errcheck_attach_pending(void);
+    // Moves this thread's attachments into 'block' for the record with 'seq'
+    void errcheck_attach_take(errcheck_attach_block_t *block, uint32_t seq);
+#endif
+
+#endif /* ERR_ATTACH_H */
@@ -0,0 +1,77 @@
+/**
+ * =============================================================================
+ * err_core.c
+ * Per-core context access and the host emulation of core IDs.
+ * =============================================================================
+ * NOTE: The per-core contexts themselves are defined in errcheck.c, next to the
+ * single-context definition they replace. On the host, the core ID is a
+ * thread-local variable. Pinning uses sched_setaffinity(), which needs
+ * _GNU_SOURCE; in the amalgamation pass -D_GNU_SOURCE, otherwise threads only
+ * get their core ID.
+ * =============================================================================
+ */
+
+#if defined(ERRCHECK_PER_CORE_HOST) && defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // sched_setaffinity(), CPU_SET()
+#endif
+
+#include "err_core.h"
+#include <string.h>
+
+#ifdef ERRCHECK_ENABLE_PER_CORE
+
+#ifdef ERRCHECK_PER_CORE_HOST
+#include <unistd.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#endif
+
+/**
+ * @brief Copies the context of 'core'. The owning core may be writing it, so a
+ * copy taken during a failure can mix the old and the new failure.
+ */
+void errcheck_core_context_get(uint32_t core, failure_context_t *out)
+{
+    if (core >= ERRCHECK_CORES) {
+        memset(out, 0, sizeof(*out));
+        out->code = ERR_SUCCESS;
+        return;
+    }
+    *out = g_errcheck_core_context[core].ctx;
+}
+
+
+#ifdef ERRCHECK_PER_CORE_HOST
+
+static ERRCHECK_THREAD_LOCAL uint32_t t_core_id = 0;
+
+uint32_t errcheck_core_id(void)
+{
+    return t_core_id;
+}
+
+/**
+ * @brief Binds the calling thread to an emulated core and, on Linux, to a host CPU.
+ */
+int errcheck_core_host_pin(uint32_t core)
+{
+    if (core >= ERRCHECK_CORES) {
+        return -1;
+    }
+    t_core_id = core;
+#if defined(__linux__) && defined(CPU_SET)
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET((int)(core % (uint32_t)(cpus > 0 ? cpus : 1)), &set);
+    return (sched_setaffinity(0, sizeof(set), &set) == 0) ? 0 : 1;
+#else
+    return 1;
+#endif
+}
+
+#endif /* ERRCHECK_PER_CORE_HOST */
+
+#endif /* ERRCHECK_ENABLE_PER_CORE */
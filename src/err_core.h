@@ -0,0 +1,50 @@
+/**
+ * =============================================================================
+ * err_core.h
+ * Per-core failure state for SMP targets without thread-local storage.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_PER_CORE (link err_core.c)
+ * Host test:   -D ERRCHECK_PER_CORE_HOST (POSIX hosts only)
+ * * A multicore MCU running bare-metal or an AMP-style RTOS has no TLS, so every
+ * core writes the one g_error_context. Two cores failing together overwrite
+ * each other's context and keep pulling its cache line back and forth. In this
+ * configuration each core owns its failure state, and every per-core entry
+ * starts on its own ERRCHECK_CACHE_LINE boundary:
+ *   - g_error_context names the calling core's context, so CHECK() and friends,
+ *     err_log.c and application code keep working unchanged;
+ *   - the history ring and breadcrumbs (ERRCHECK_ENABLE_HISTORY) are one region
+ *     per core, with their own heads: g_errcheck_history_core[];
+ *   - the lifetime counters (ERRCHECK_ENABLE_PERSIST_COUNTERS) count per core
+ *     and add the cores up when read or checkpointed.
+ * The anomaly windows, the sketch and the retained ring stay shared: they
+ * summarise the whole device.
+ * * The core comes from errcheck_core_id(), which the application provides. The
+ * failure path calls it once per stage (capture, logging, each sink). Code
+ * that can fail must not move between cores in the middle of a failure (pin
+ * the task or keep it on its core, as AMP firmware does anyway).
+ * * ERRCHECK_PER_CORE_HOST emulates this on a POSIX host. Each thread that
+ * stands for a core calls errcheck_core_host_pin(). On Linux the thread is
+ * also pinned to host CPU (core % online CPUs). Threads that never call it
+ * run as core 0, like the boot core.
+ * =============================================================================
+ */
+
+#ifndef ERR_CORE_H
+#define ERR_CORE_H
+
+#include <stdint.h>
+#include "errcheck.h"
+
+#ifdef ERRCHECK_ENABLE_PER_CORE
+    // Copies the context of any core, e.g. for a supervisor core reporting all of them
+    void errcheck_core_context_get(uint32_t core, failure_context_t *out);
+
+    #ifdef ERRCHECK_PER_CORE_HOST
+        // Makes the calling thread core 'core' and pins it to a host CPU where the
+        // platform allows. Returns 0 if pinned, 1 if only the core ID was set
+        // (no affinity support), -1 if 'core' is out of range.
+        int errcheck_core_host_pin(uint32_t core);
+    #endif
+#endif
+
+#endif /* ERR_CORE_H */
@@ -0,0 +1,466 @@
+/**
+ * =============================================================================
+ * err_counters.c
+ * Persistent per-code counters: delta log, bank compaction and write budget.
+ * =============================================================================
+ * NOTE: The failure path performs one atomic increment. Boot, checkpoints and
+ * queries run from one task. A record is programmed body first and magic last,
+ * so a reset in between leaves no valid record. Boot then finds neither a
+ * record nor erased flash, and the next checkpoint compacts into the other bank
+ * rather than programming over the torn bytes.
+ * =============================================================================
+ */
+
+#if defined(ERRCHECK_COUNTERS_HOST_FILE) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // pread(), pwrite(), O_CLOEXEC under strict -std=c99
+#endif
+
+#include "err_counters.h"
+#include "err_crc32c.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef ERRCHECK_ENABLE_PERSIST_COUNTERS
+
+#ifdef ERRCHECK_COUNTERS_HOST_FILE
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define COUNTERS_DAY_NS     (86400ull * 1000000000ull)
+#define COUNTERS_NO_BANK    2u
+#define COUNTERS_BUDGET_MAGIC 0x54474442u   // "BDGT" little-endian
+
+typedef enum { COUNTERS_OK, COUNTERS_ERASED, COUNTERS_BAD } counters_read_t;
+
+// One record as laid out in flash; also the read buffer during boot
+typedef struct {
+    errcheck_counters_record_t hdr;
+    errcheck_counters_entry_t entries[ERRCHECK_COUNTERS_CODES];
+} counters_image_t;
+
+// Daily budget carried across warm resets; 'crc' is CRC-32C over the two fields before it
+typedef struct {
+    uint32_t magic;             // COUNTERS_BUDGET_MAGIC, anything else is cold-boot garbage
+    uint32_t bytes_today;
+    uint64_t day_elapsed_ns;    // Uptime spent in the budget day, earlier boots included
+    uint32_t crc;
+    uint32_t reserved;
+} counters_budget_t;
+
+#ifdef ERRCHECK_ENABLE_PER_CORE
+    #define COUNTERS_CORES      ERRCHECK_CORES
+    #define COUNTERS_THIS_CORE  errcheck_core_id()
+#else
+    #define COUNTERS_CORES      1u
+    #define COUNTERS_THIS_CORE  0u
+#endif
+
+// Failures this boot, counted by each core in its own cache lines (failure path)
+typedef struct {
+    uint32_t live[ERRCHECK_COUNTERS_CODES];
+} ERRCHECK_CORE_ALIGNED counters_live_t;
+
+static counters_live_t s_cnt_live[COUNTERS_CORES];
+static uint32_t s_cnt_saved[ERRCHECK_COUNTERS_CODES];   // Part of the live counts already logged
+static uint32_t s_cnt_base[ERRCHECK_COUNTERS_CODES];    // Stored totals
+static uint32_t s_cnt_delta[ERRCHECK_COUNTERS_CODES];
+static counters_image_t s_cnt_img;
+
+static bool s_cnt_ready = false;
+static uint32_t s_cnt_bank = 0;
+static uint32_t s_cnt_offset = 0;       // Next free byte in the active bank
+static uint32_t s_cnt_seq = 0;          // seq of the last record in the active bank
+static uint64_t s_cnt_day_start = 0;
+static uint64_t s_cnt_day_carry = 0;    // Uptime of the budget day before this boot
+static uint64_t s_cnt_last_tick = 0;
+static errcheck_counters_stats_t s_cnt_stats;
+#ifndef ERRCHECK_COUNTERS_HOST_FILE
+static counters_budget_t s_cnt_budget ERRCHECK_NOINIT;
+#endif
+
+
+static uint32_t counters_slot(uint32_t code)
+{
+    return code < ERRCHECK_COUNTERS_CODES ? code : ERRCHECK_COUNTERS_CODES - 1u;
+}
+
+// Failures of a slot this boot, all cores (wraps like the counters themselves)
+static uint32_t counters_live(uint32_t slot)
+{
+    uint32_t n = 0;
+
+    for (uint32_t core = 0; core < COUNTERS_CORES; core++) {
+        n += __atomic_load_n(&s_cnt_live[core].live[slot], __ATOMIC_RELAXED);
+    }
+    return n;
+}
+
+static uint32_t counters_sat_add(uint32_t a, uint32_t b)
+{
+    return (a > UINT32_MAX - b) ? UINT32_MAX : a + b;
+}
+
+static uint32_t counters_size(uint32_t count)
+{
+    return (uint32_t)(sizeof(errcheck_counters_record_t) + count * sizeof(errcheck_counters_entry_t));
+}
+
+static uint32_t counters_crc(const counters_image_t *img)
+{
+    uint32_t crc = errcheck_crc32c(0, &img->hdr.seq, sizeof(errcheck_counters_record_t) -
+                                   offsetof(errcheck_counters_record_t, seq));
+    return errcheck_crc32c(crc, img->entries, img->hdr.count * sizeof(errcheck_counters_entry_t));
+}
+
+static uint32_t counters_budget_crc(const counters_budget_t *b)
+{
+    return errcheck_crc32c(0, &b->bytes_today, offsetof(counters_budget_t, crc) -
+                           offsetof(counters_budget_t, bytes_today));
+}
+
+static bool counters_budget_load(counters_budget_t *b);
+static void counters_budget_store(const counters_budget_t *b);
+
+/**
+ * @brief Saves the budget spent so far to retained RAM. A reset loop then
+ * continues the budget day instead of starting a new one at every boot.
+ */
+static void counters_budget_save(uint64_t now)
+{
+    counters_budget_t b = {
+        .magic = COUNTERS_BUDGET_MAGIC,
+        .bytes_today = s_cnt_stats.bytes_today,
+        .day_elapsed_ns = s_cnt_day_carry + (now - s_cnt_day_start),
+    };
+
+    b.crc = counters_budget_crc(&b);
+    counters_budget_store(&b);
+}
+
+/**
+ * @brief Reads and verifies the record at 'offset' of 'bank' into s_cnt_img.
+ */
+static counters_read_t counters_read(uint32_t bank, uint32_t offset)
+{
+    errcheck_counters_record_t *hdr = &s_cnt_img.hdr;
+    const uint8_t *raw = (const uint8_t *)hdr;
+
+    if (offset + sizeof(*hdr) > ERRCHECK_COUNTERS_BANK_BYTES ||
+        !errcheck_counters_store_read(bank, offset, hdr, sizeof(*hdr))) {
+        return COUNTERS_BAD;
+    }
+    if (hdr->magic != ERRCHECK_COUNTERS_MAGIC) {
+        for (size_t i = 0; i < sizeof(*hdr); i++) {
+            if (raw[i] != 0xFFu) {
+                return COUNTERS_BAD;
+            }
+        }
+        return COUNTERS_ERASED;
+    }
+    if (hdr->count > ERRCHECK_COUNTERS_CODES ||
+        offset + counters_size(hdr->count) > ERRCHECK_COUNTERS_BANK_BYTES ||
+        !errcheck_counters_store_read(bank, offset + (uint32_t)sizeof(*hdr), s_cnt_img.entries,
+                                      hdr->count * (uint32_t)sizeof(errcheck_counters_entry_t))) {
+        return COUNTERS_BAD;
+    }
+    return (hdr->crc == counters_crc(&s_cnt_img)) ? COUNTERS_OK : COUNTERS_BAD;
+}
+
+/**
+ * @brief Picks the bank with the newest snapshot and replays its log.
+ */
+uint32_t errcheck_counters_boot(void)
+{
+    uint32_t best = COUNTERS_NO_BANK;
+    uint32_t best_seq = 0;
+
+    for (uint32_t bank = 0; bank < 2u; bank++) {
+        if (counters_read(bank, 0) == COUNTERS_OK &&
+            s_cnt_img.hdr.kind == ERRCHECK_COUNTERS_SNAPSHOT &&
+            (best == COUNTERS_NO_BANK || (int32_t)(s_cnt_img.hdr.seq - best_seq) > 0)) {
+            best = bank;
+            best_seq = s_cnt_img.hdr.seq;
+        }
+    }
+
+    memset(s_cnt_base, 0, sizeof(s_cnt_base));
+    memset(&s_cnt_stats, 0, sizeof(s_cnt_stats));
+    s_cnt_seq = 0;
+    // Without a valid bank, the first checkpoint compacts into bank 0
+    s_cnt_bank = (best == COUNTERS_NO_BANK) ? 1u : best;
+    s_cnt_offset = ERRCHECK_COUNTERS_BANK_BYTES;
+
+    uint32_t offset = 0;
+    while (best != COUNTERS_NO_BANK) {
+        counters_read_t st = counters_read(best, offset);
+        if (st == COUNTERS_ERASED) {
+            s_cnt_offset = offset; // Clean end of the log: appends continue here
+            break;
+        }
+        if (st != COUNTERS_OK ||
+            (offset != 0 && (s_cnt_img.hdr.kind != ERRCHECK_COUNTERS_DELTA ||
+                             s_cnt_img.hdr.seq != s_cnt_seq + 1u))) {
+            break;
+        }
+        for (uint32_t i = 0; i < s_cnt_img.hdr.count; i++) {
+            uint32_t slot = counters_slot(s_cnt_img.entries[i].code);
+            s_cnt_base[slot] = counters_sat_add(s_cnt_base[slot], s_cnt_img.entries[i].value);
+        }
+        s_cnt_seq = s_cnt_img.hdr.seq;
+        s_cnt_stats.replayed++;
+        offset += counters_size(s_cnt_img.hdr.count);
+    }
+
+    counters_budget_t budget;
+    s_cnt_day_start = errcheck_now_ns();
+    s_cnt_day_carry = 0;
+    if (counters_budget_load(&budget) && budget.magic == COUNTERS_BUDGET_MAGIC &&
+        budget.crc == counters_budget_crc(&budget) && budget.day_elapsed_ns < COUNTERS_DAY_NS) {
+        s_cnt_day_carry = budget.day_elapsed_ns;
+        s_cnt_stats.bytes_today = budget.bytes_today;
+    }
+    s_cnt_last_tick = s_cnt_day_start;
+    s_cnt_ready = true;
+    return s_cnt_stats.replayed;
+}
+
+void errcheck_counters_record(uint32_t code)
+{
+    __atomic_fetch_add(&s_cnt_live[COUNTERS_THIS_CORE].live[counters_slot(code)], 1u,
+                       __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Appends the changed counters as deltas, or compacts into the other bank.
+ */
+uint32_t errcheck_counters_checkpoint(void)
+{
+    uint32_t changed = 0;
+    uint32_t nonzero = 0;
+
+    if (!s_cnt_ready) {
+        return 0;
+    }
+    for (uint32_t c = 0; c < ERRCHECK_COUNTERS_CODES; c++) {
+        s_cnt_delta[c] = counters_live(c) - s_cnt_saved[c];
+        changed += (s_cnt_delta[c] != 0) ? 1u : 0u;
+        nonzero += (counters_sat_add(s_cnt_base[c], s_cnt_delta[c]) != 0) ? 1u : 0u;
+    }
+    if (changed == 0) {
+        return 0;
+    }
+
+    bool compact = s_cnt_offset + counters_size(changed) > ERRCHECK_COUNTERS_BANK_BYTES;
+    uint32_t size = counters_size(compact ? nonzero : changed);
+    uint64_t now = errcheck_now_ns();
+    if (s_cnt_day_carry + (now - s_cnt_day_start) >= COUNTERS_DAY_NS) {
+        s_cnt_day_start = now;
+        s_cnt_day_carry = 0;
+        s_cnt_stats.bytes_today = 0;
+    }
+    if (s_cnt_stats.bytes_today + size > ERRCHECK_COUNTERS_DAILY_BYTES) {
+        s_cnt_stats.deferred++;
+        counters_budget_save(now);
+        return 0;
+    }
+
+    counters_image_t *img = &s_cnt_img;
+    uint32_t n = 0;
+    for (uint32_t c = 0; c < ERRCHECK_COUNTERS_CODES; c++) {
+        uint32_t value = compact ? counters_sat_add(s_cnt_base[c], s_cnt_delta[c]) : s_cnt_delta[c];
+        if (value != 0) {
+            img->entries[n].code = c;
+            img->entries[n].value = value;
+            n++;
+        }
+    }
+    img->hdr.magic = ERRCHECK_COUNTERS_MAGIC;
+    img->hdr.seq = s_cnt_seq + 1u;
+    img->hdr.kind = (uint16_t)(compact ? ERRCHECK_COUNTERS_SNAPSHOT : ERRCHECK_COUNTERS_DELTA);
+    img->hdr.count = (uint16_t)n;
+    img->hdr.crc = counters_crc(img);
+
+    uint32_t bank = compact ? (s_cnt_bank ^ 1u) : s_cnt_bank;
+    uint32_t offset = compact ? 0u : s_cnt_offset;
+    const uint8_t *raw = (const uint8_t *)img;
+    const uint32_t body = (uint32_t)offsetof(errcheck_counters_record_t, crc);
+
+    s_cnt_stats.bytes_today += size; // Charged even on failure: the flash was worn anyway
+    counters_budget_save(now);       // Before the write, so a reset during it stays charged
+    if ((compact && !errcheck_counters_store_erase(bank)) ||
+        !errcheck_counters_store_program(bank, offset + body, raw + body, size - body) ||
+        !errcheck_counters_store_program(bank, offset, raw, body)) {
+        s_cnt_stats.failed++;
+        if (!compact) {
+            s_cnt_offset = ERRCHECK_COUNTERS_BANK_BYTES; // Tail may be torn: compact next time
+        }
+        return 0;
+    }
+
+    for (uint32_t c = 0; c < ERRCHECK_COUNTERS_CODES; c++) {
+        s_cnt_base[c] = counters_sat_add(s_cnt_base[c], s_cnt_delta[c]);
+        s_cnt_saved[c] += s_cnt_delta[c];
+    }
+    s_cnt_seq = img->hdr.seq;
+    s_cnt_bank = bank;
+    s_cnt_offset = offset + size;
+    s_cnt_stats.checkpoints++;
+    s_cnt_stats.compactions += compact ? 1u : 0u;
+    s_cnt_stats.bytes_total += size;
+    return size;
+}
+
+void errcheck_counters_tick(void)
+{
+    uint64_t now = errcheck_now_ns();
+
+    if (now - s_cnt_last_tick >= (uint64_t)ERRCHECK_COUNTERS_INTERVAL_S * 1000000000ull) {
+        s_cnt_last_tick = now;
+        (void)errcheck_counters_checkpoint();
+    }
+}
+
+uint32_t errcheck_counters_shutdown(void)
+{
+    return errcheck_counters_checkpoint();
+}
+
+uint32_t errcheck_counters_total(uint32_t code)
+{
+    uint32_t slot = counters_slot(code);
+    uint32_t pending = counters_live(slot) - s_cnt_saved[slot];
+
+    return counters_sat_add(s_cnt_base[slot], pending);
+}
+
+uint32_t errcheck_counters_since_boot(uint32_t code)
+{
+    return counters_live(counters_slot(code));
+}
+
+void errcheck_counters_get_stats(errcheck_counters_stats_t *out)
+{
+    *out = s_cnt_stats;
+}
+
+#ifndef ERRCHECK_COUNTERS_HOST_FILE
+
+static bool counters_budget_load(counters_budget_t *b)
+{
+    *b = s_cnt_budget;
+    return true;
+}
+
+static void counters_budget_store(const counters_budget_t *b)
+{
+    s_cnt_budget = *b;
+}
+
+#else /* ERRCHECK_COUNTERS_HOST_FILE */
+
+static int s_cnt_fd = -1;
+
+static off_t counters_host_pos(uint32_t bank, uint32_t offset)
+{
+    return (off_t)bank * ERRCHECK_COUNTERS_BANK_BYTES + offset;
+}
+
+// The retained budget follows the two banks in the file, standing in for .noinit
+static bool counters_budget_load(counters_budget_t *b)
+{
+    return s_cnt_fd >= 0 &&
+           pread(s_cnt_fd, b, sizeof(*b), counters_host_pos(2u, 0)) == (ssize_t)sizeof(*b);
+}
+
+static void counters_budget_store(const counters_budget_t *b)
+{
+    if (s_cnt_fd >= 0) {
+        (void)pwrite(s_cnt_fd, b, sizeof(*b), counters_host_pos(2u, 0));
+    }
+}
+
+bool errcheck_counters_store_read(uint32_t bank, uint32_t offset, void *buf, uint32_t len)
+{
+    return s_cnt_fd >= 0 && bank < 2u && offset + len <= ERRCHECK_COUNTERS_BANK_BYTES &&
+           pread(s_cnt_fd, buf, len, counters_host_pos(bank, offset)) == (ssize_t)len;
+}
+
+/**
+ * @brief Programs like NOR flash: bits can only go from 1 to 0.
+ */
+bool errcheck_counters_store_program(uint32_t bank, uint32_t offset, const void *data, uint32_t len)
+{
+    uint8_t cell[64];
+    const uint8_t *src = data;
+
+    while (len > 0) {
+        uint32_t n = (len < sizeof(cell)) ? len : (uint32_t)sizeof(cell);
+        if (!errcheck_counters_store_read(bank, offset, cell, n)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            cell[i] &= src[i];
+        }
+        if (pwrite(s_cnt_fd, cell, n, counters_host_pos(bank, offset)) != (ssize_t)n) {
+            return false;
+        }
+        src += n;
+        offset += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool errcheck_counters_store_erase(uint32_t bank)
+{
+    uint8_t erased[256];
+
+    memset(erased, 0xFF, sizeof(erased));
+    for (uint32_t off = 0; s_cnt_fd >= 0 && bank < 2u && off < ERRCHECK_COUNTERS_BANK_BYTES;
+         off += (uint32_t)sizeof(erased)) {
+        uint32_t n = ERRCHECK_COUNTERS_BANK_BYTES - off;
+        n = (n < sizeof(erased)) ? n : (uint32_t)sizeof(erased);
+        if (pwrite(s_cnt_fd, erased, n, counters_host_pos(bank, off)) != (ssize_t)n) {
+            return false;
+        }
+    }
+    return s_cnt_fd >= 0 && bank < 2u;
+}
+
+/**
+ * @brief Opens (or creates, erased) the file holding both banks and the budget.
+ */
+int errcheck_counters_host_attach(const char *path)
+{
+    struct stat st;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (s_cnt_fd >= 0) {
+        close(s_cnt_fd);
+    }
+    s_cnt_fd = fd;
+    counters_budget_t cold;
+    memset(&cold, 0xFF, sizeof(cold));
+    if ((uint64_t)st.st_size != (uint64_t)counters_host_pos(2u, sizeof(cold)) &&
+        (ftruncate(fd, 0) != 0 || !errcheck_counters_store_erase(0) ||
+         !errcheck_counters_store_erase(1) ||
+         pwrite(fd, &cold, sizeof(cold), counters_host_pos(2u, 0)) != (ssize_t)sizeof(cold))) {
+        close(fd);
+        s_cnt_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+#endif /* ERRCHECK_COUNTERS_HOST_FILE */
+
+#endif /* ERRCHECK_ENABLE_PERSIST_COUNTERS */
@@ -0,0 +1,134 @@
+/**
+ * =============================================================================
+ * err_counters.h
+ * Per-code failure counters that persist across reboots.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_PERSIST_COUNTERS (link err_counters.c and
+ *              err_crc32c.c)
+ * Host test:   -D ERRCHECK_COUNTERS_HOST_FILE (POSIX hosts only)
+ * * Every logged failure increments a RAM counter for its code. Checkpoints
+ * write only the counters that changed since the previous checkpoint, as
+ * deltas, appended to a log in one of two flash banks. errcheck_counters_boot()
+ * replays the newest bank, so totals keep growing over the device lifetime.
+ * When the active bank is full, one snapshot record of all totals is written
+ * to the other bank (erased first) and the log continues there. A reset during
+ * a write leaves a record with a bad CRC; boot ignores it and the previous
+ * state is used.
+ * * Checkpoints run from errcheck_counters_tick() every
+ * ERRCHECK_COUNTERS_INTERVAL_S and from errcheck_counters_shutdown(). All
+ * writes, snapshots included, are charged to a budget of
+ * ERRCHECK_COUNTERS_DAILY_BYTES per day of uptime. A checkpoint that would
+ * overrun it is deferred, and its deltas stay in RAM for the next one. The bytes
+ * spent and the uptime of the budget day are kept in retained RAM (.noinit, see
+ * err_retained.h for the linker section), so a reset loop continues the day
+ * instead of starting a fresh budget at every boot. Uptime between the last
+ * checkpoint and a reset is not carried, which only stretches the day. A power
+ * cycle clears retained RAM and does start a new day.
+ * * Codes >= ERRCHECK_COUNTERS_CODES share the last slot. Totals saturate at
+ * UINT32_MAX. Failures since the last checkpoint are lost on an unplanned reset.
+ * With ERRCHECK_ENABLE_PER_CORE each core counts in its own cache lines and the
+ * queries and checkpoints add the cores up.
+ * =============================================================================
+ */
+
+#ifndef ERR_COUNTERS_H
+#define ERR_COUNTERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "errcheck.h"
+
+/* --- Configuration --- */
+#ifndef ERRCHECK_COUNTERS_CODES
+    #define ERRCHECK_COUNTERS_CODES        32u
+#endif
+#ifndef ERRCHECK_COUNTERS_BANK_BYTES
+    #define ERRCHECK_COUNTERS_BANK_BYTES   4096u   // One erasable flash sector per bank
+#endif
+#ifndef ERRCHECK_COUNTERS_INTERVAL_S
+    #define ERRCHECK_COUNTERS_INTERVAL_S   3600u
+#endif
+#ifndef ERRCHECK_COUNTERS_DAILY_BYTES
+    #define ERRCHECK_COUNTERS_DAILY_BYTES  2048u
+#endif
+
+#ifndef ERRCHECK_NOINIT
+    #define ERRCHECK_NOINIT __attribute__((section(".noinit")))
+#endif
+
+#define ERRCHECK_COUNTERS_MAGIC    0x544E4345u   // "ECNT" little-endian
+#define ERRCHECK_COUNTERS_SNAPSHOT 1u            // Entries are absolute totals
+#define ERRCHECK_COUNTERS_DELTA    2u            // Entries are added to the totals
+
+/* --- Log record: header followed by 'count' entries; 'crc' covers everything after it --- */
+typedef struct {
+    uint32_t magic;
+    uint32_t crc;               // CRC-32C over seq, kind, count and the entries
+    uint32_t seq;               // Checkpoint number, consecutive within a bank
+    uint16_t kind;              // ERRCHECK_COUNTERS_SNAPSHOT / _DELTA
+    uint16_t count;
+} errcheck_counters_record_t;
+
+typedef struct {
+    uint32_t code;
+    uint32_t value;
+} errcheck_counters_entry_t;
+
+#if ERRCHECK_COUNTERS_BANK_BYTES < 2u * (16u + 8u * ERRCHECK_COUNTERS_CODES)
+    #error "ERRCHECK_COUNTERS_BANK_BYTES must hold at least two full snapshots"
+#endif
+#if ERRCHECK_COUNTERS_DAILY_BYTES < 16u + 8u * ERRCHECK_COUNTERS_CODES
+    #error "ERRCHECK_COUNTERS_DAILY_BYTES must cover one full snapshot, or compaction is deferred forever"
+#endif
+
+typedef struct {
+    uint32_t checkpoints;       // Records written since boot (snapshots included)
+    uint32_t compactions;       // Bank switches since boot
+    uint32_t deferred;          // Checkpoints postponed by the daily budget
+    uint32_t failed;            // Store errors (retried at the next checkpoint)
+    uint32_t bytes_today;       // Bytes charged to the current budget day (earlier boots included)
+    uint32_t bytes_total;       // Bytes written since boot
+    uint32_t replayed;          // Records merged by errcheck_counters_boot()
+} errcheck_counters_stats_t;
+
+/**
+ * @brief REQUIRED (user): flash access for the two counter banks.
+ * * Banks are 0 and 1, each ERRCHECK_COUNTERS_BANK_BYTES long. Reads of erased
+ * flash must return 0xFF. program() is only called on erased bytes, at
+ * increasing offsets. Each hook returns true once the operation is confirmed.
+ * ERRCHECK_COUNTERS_HOST_FILE provides all three.
+ */
+extern bool errcheck_counters_store_read(uint32_t bank, uint32_t offset, void *buf, uint32_t len);
+extern bool errcheck_counters_store_program(uint32_t bank, uint32_t offset,
+                                            const void *data, uint32_t len);
+extern bool errcheck_counters_store_erase(uint32_t bank);
+
+#ifdef ERRCHECK_ENABLE_PERSIST_COUNTERS
+    // Merges the stored totals; call once at startup. Failures logged earlier are kept.
+    // Returns the number of log records replayed.
+    uint32_t errcheck_counters_boot(void);
+
+    // Called from errcheck_log_to_nvram_commit()
+    void errcheck_counters_record(uint32_t code);
+
+    // Periodic call (e.g. from the idle task): checkpoints once per interval
+    void errcheck_counters_tick(void);
+    // Checkpoints now, within the budget; returns the bytes written (0 if none)
+    uint32_t errcheck_counters_checkpoint(void);
+    // Final checkpoint before a planned reset or power-off
+    uint32_t errcheck_counters_shutdown(void);
+
+    // Lifetime count of a code: stored total plus failures not yet checkpointed
+    uint32_t errcheck_counters_total(uint32_t code);
+    // Failures of a code since this boot
+    uint32_t errcheck_counters_since_boot(uint32_t code);
+    void errcheck_counters_get_stats(errcheck_counters_stats_t *out);
+
+    #ifdef ERRCHECK_COUNTERS_HOST_FILE
+        // Backs both banks, and the retained budget after them, with a file; a new
+        // file starts erased. Call before boot.
+        int errcheck_counters_host_attach(const char *path);
+    #endif
+#endif
+
+#endif /* ERR_COUNTERS_H */
@@ -0,0 +1,240 @@
+/**
+ * =============================================================================
+ * err_crc32c.c
+ * CRC-32C implementations: SSE4.2, ARMv8, slicing-by-8 and bitwise.
+ * =============================================================================
+ * NOTE: The slicing-by-8 tables and the dispatch pointer are initialized on
+ * first use. Initialization is idempotent (every racing thread computes the same
+ * values), and the pointer is published with release/acquire ordering.
+ * =============================================================================
+ */
+
+#include "err_crc32c.h"
+#include <string.h>
+
+#if defined(ERRCHECK_CRC32C_HAVE_SSE42)
+#include <nmmintrin.h>
+#endif
+#if defined(ERRCHECK_CRC32C_HAVE_ARMV8)
+#include <arm_acle.h>
+#endif
+
+#define CRC32C_POLY_REFLECTED 0x82F63B78u
+
+typedef uint32_t (*crc32c_fn_t)(uint32_t crc, const void *data, size_t len);
+
+
+/**
+ * @brief Reference implementation: one bit per step, no table.
+ */
+uint32_t errcheck_crc32c_bitwise(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    crc = ~crc;
+    while (len-- > 0) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (CRC32C_POLY_REFLECTED & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+
+#ifndef ERRCHECK_CRC32C_SMALL
+
+static uint32_t s_sb8_table[8][256];
+static int s_sb8_ready = 0;
+
+static void sb8_init(void)
+{
+    if (__atomic_load_n(&s_sb8_ready, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c >> 1) ^ (CRC32C_POLY_REFLECTED & (0u - (c & 1u)));
+        }
+        s_sb8_table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int t = 1; t < 8; t++) {
+            uint32_t prev = s_sb8_table[t - 1][i];
+            s_sb8_table[t][i] = (prev >> 8) ^ s_sb8_table[0][prev & 0xFFu];
+        }
+    }
+    __atomic_store_n(&s_sb8_ready, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Portable slicing-by-8: eight table lookups per 8 input bytes.
+ */
+uint32_t errcheck_crc32c_sb8(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    sb8_init();
+    crc = ~crc;
+
+    // Byte steps until 8-byte aligned, so the word loads below are aligned
+    while (len > 0 && ((uintptr_t)p & 7u) != 0) {
+        crc = (crc >> 8) ^ s_sb8_table[0][(crc ^ *p++) & 0xFFu];
+        len--;
+    }
+    while (len >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, p, 4);
+        memcpy(&hi, p + 4, 4);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        lo = __builtin_bswap32(lo);
+        hi = __builtin_bswap32(hi);
+#endif
+        lo ^= crc;
+        crc = s_sb8_table[7][lo & 0xFFu] ^ s_sb8_table[6][(lo >> 8) & 0xFFu] ^
+              s_sb8_table[5][(lo >> 16) & 0xFFu] ^ s_sb8_table[4][lo >> 24] ^
+              s_sb8_table[3][hi & 0xFFu] ^ s_sb8_table[2][(hi >> 8) & 0xFFu] ^
+              s_sb8_table[1][(hi >> 16) & 0xFFu] ^ s_sb8_table[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+    while (len-- > 0) {
+        crc = (crc >> 8) ^ s_sb8_table[0][(crc ^ *p++) & 0xFFu];
+    }
+    return ~crc;
+}
+
+
+#if defined(ERRCHECK_CRC32C_HAVE_SSE42)
+
+int errcheck_crc32c_sse42_supported(void)
+{
+    return __builtin_cpu_supports("sse4.2");
+}
+
+/**
+ * @brief SSE4.2 CRC32 instruction, 8 (x86-64) or 4 (x86) bytes per step.
+ */
+__attribute__((target("sse4.2")))
+uint32_t errcheck_crc32c_sse42(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    crc = ~crc;
+    while (len > 0 && ((uintptr_t)p & 7u) != 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+        len--;
+    }
+#if defined(__x86_64__)
+    uint64_t c64 = crc;
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        c64 = _mm_crc32_u64(c64, w);
+        p += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)c64;
+#endif
+    while (len >= 4) {
+        uint32_t w;
+        memcpy(&w, p, 4);
+        crc = _mm_crc32_u32(crc, w);
+        p += 4;
+        len -= 4;
+    }
+    while (len-- > 0) {
+        crc = _mm_crc32_u8(crc, *p++);
+    }
+    return ~crc;
+}
+
+#endif /* ERRCHECK_CRC32C_HAVE_SSE42 */
+
+
+#if defined(ERRCHECK_CRC32C_HAVE_ARMV8)
+
+/**
+ * @brief ARMv8 CRC32CX/CRC32CB instructions, 8 bytes per step.
+ */
+uint32_t errcheck_crc32c_armv8(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    crc = ~crc;
+    while (len > 0 && ((uintptr_t)p & 7u) != 0) {
+        crc = __crc32cb(crc, *p++);
+        len--;
+    }
+    while (len >= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        crc = __crc32cd(crc, w);
+        p += 8;
+        len -= 8;
+    }
+    while (len-- > 0) {
+        crc = __crc32cb(crc, *p++);
+    }
+    return ~crc;
+}
+
+#endif /* ERRCHECK_CRC32C_HAVE_ARMV8 */
+
+#endif /* !ERRCHECK_CRC32C_SMALL */
+
+
+/* --- Dispatch --- */
+
+static crc32c_fn_t select_impl(void)
+{
+#if defined(ERRCHECK_CRC32C_SMALL)
+    return errcheck_crc32c_bitwise;
+#elif defined(ERRCHECK_CRC32C_HAVE_ARMV8)
+    return errcheck_crc32c_armv8;
+#else
+#if defined(ERRCHECK_CRC32C_HAVE_SSE42)
+    if (errcheck_crc32c_sse42_supported()) {
+        return errcheck_crc32c_sse42;
+    }
+#endif
+    return errcheck_crc32c_sb8;
+#endif
+}
+
+static crc32c_fn_t s_crc32c_impl = NULL;
+
+uint32_t errcheck_crc32c(uint32_t crc, const void *data, size_t len)
+{
+    crc32c_fn_t fn = __atomic_load_n(&s_crc32c_impl, __ATOMIC_ACQUIRE);
+
+    if (fn == NULL) {
+        fn = select_impl();
+        __atomic_store_n(&s_crc32c_impl, fn, __ATOMIC_RELEASE);
+    }
+    return fn(crc, data, len);
+}
+
+const char *errcheck_crc32c_impl_name(void)
+{
+    crc32c_fn_t fn = select_impl();
+    (void)fn; // Unused when only the bitwise loop is built
+
+#if defined(ERRCHECK_CRC32C_HAVE_SSE42)
+    if (fn == errcheck_crc32c_sse42) {
+        return "sse4.2";
+    }
+#endif
+#if defined(ERRCHECK_CRC32C_HAVE_ARMV8)
+    if (fn == errcheck_crc32c_armv8) {
+        return "armv8";
+    }
+#endif
+#ifndef ERRCHECK_CRC32C_SMALL
+    if (fn == errcheck_crc32c_sb8) {
+        return "slicing-by-8";
+    }
+#endif
+    return "bitwise";
+}
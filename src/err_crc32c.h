@@ -0,0 +1,51 @@
+/**
+ * =============================================================================
+ * err_crc32c.h
+ * CRC-32C (Castagnoli) integrity checksum for persisted failure records.
+ * =============================================================================
+ * errcheck_crc32c() picks the fastest implementation available at run time:
+ *   - SSE4.2 CRC32 instruction (x86/x86-64, checked with CPUID on first use)
+ *   - ARMv8 CRC32C instructions (AArch64 builds with __ARM_FEATURE_CRC32)
+ *   - Slicing-by-8 portable fallback (8 KiB table built on first use)
+ * * Define ERRCHECK_CRC32C_SMALL on small MCUs to keep only the table-less
+ * bitwise loop (no RAM table, slowest).
+ * * All variants use the usual pre/post-inverted convention, so calls chain:
+ * errcheck_crc32c(errcheck_crc32c(0, a, na), b, nb) == CRC of a followed by b.
+ * =============================================================================
+ */
+
+#ifndef ERR_CRC32C_H
+#define ERR_CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ERRCHECK_CRC32C_CHECK_VALUE 0xE3069283u   // CRC-32C of "123456789"
+
+/* Dispatching entry point: use this one */
+uint32_t errcheck_crc32c(uint32_t crc, const void *data, size_t len);
+
+// Name of the implementation errcheck_crc32c() dispatches to ("sse4.2", "armv8",
+// "slicing-by-8" or "bitwise").
+const char *errcheck_crc32c_impl_name(void);
+
+/* Individual implementations (benchmarks, cross-checks) */
+uint32_t errcheck_crc32c_bitwise(uint32_t crc, const void *data, size_t len);
+
+#ifndef ERRCHECK_CRC32C_SMALL
+    uint32_t errcheck_crc32c_sb8(uint32_t crc, const void *data, size_t len);
+
+    #if defined(__x86_64__) || defined(__i386__)
+        #define ERRCHECK_CRC32C_HAVE_SSE42 1
+        // Only call when errcheck_crc32c_sse42_supported() returns true
+        uint32_t errcheck_crc32c_sse42(uint32_t crc, const void *data, size_t len);
+        int errcheck_crc32c_sse42_supported(void);
+    #endif
+
+    #if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+        #define ERRCHECK_CRC32C_HAVE_ARMV8 1
+        uint32_t errcheck_crc32c_armv8(uint32_t crc, const void *data, size_t len);
+    #endif
+#endif
+
+#endif /* ERR_CRC32C_H */
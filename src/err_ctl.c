@@ -0,0 +1,304 @@
+/**
+ * =============================================================================
+ * err_ctl.c
+ * Control socket server (see err_ctl.h for the protocol).
+ * =============================================================================
+ * NOTE: The server thread is the only writer of the injection table while it
+ * runs. It polls with a short timeout so errcheck_ctl_stop() never waits on a
+ * blocked accept() or read() for longer than ERRCHECK_CTL_POLL_MS.
+ * =============================================================================
+ */
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // poll() under strict -std=c99
+#endif
+
+#include "err_ctl.h"
+
+#ifdef ERRCHECK_ENABLE_CTL
+
+#include "err_inject.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef ERRCHECK_CTL_POLL_MS
+    #define ERRCHECK_CTL_POLL_MS 200
+#endif
+#ifndef ERRCHECK_CTL_IDLE_MS
+    #define ERRCHECK_CTL_IDLE_MS 5000   // A silent client is dropped after this
+#endif
+#define CTL_LINE_MAX 256u
+
+static const char *const s_ctl_triggers[] = { "once", "nth", "every", "rate" };
+
+static pthread_t s_ctl_thread;
+static int s_ctl_fd = -1;
+static int s_ctl_running = 0;
+static char s_ctl_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+static void ctl_reply(int fd, const char *fmt, ...)
+{
+    char buf[CTL_LINE_MAX];
+    va_list ap;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n > 0) {
+        // MSG_NOSIGNAL: a client that hung up must not SIGPIPE the service
+        (void)send(fd, buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1u, MSG_NOSIGNAL);
+    }
+}
+
+static bool ctl_parse_u32(const char *s, uint32_t *out)
+{
+    char *end;
+    unsigned long v;
+
+    errno = 0;
+    v = strtoul(s, &end, 0);
+    if (errno != 0 || end == s || *end != '\0' || v > UINT32_MAX) {
+        return false;
+    }
+    *out = (uint32_t)v;
+    return true;
+}
+
+static void ctl_list(int fd)
+{
+    for (int i = 0; i < (int)ERRCHECK_INJECT_RULES; i++) {
+        errcheck_inject_status_t st;
+        if (!errcheck_inject_get(i, &st)) {
+            continue;
+        }
+        ctl_reply(fd, "%d code=", i);
+        if (st.rule.code == ERRCHECK_INJECT_ANY_CODE) {
+            ctl_reply(fd, "any");
+        } else {
+            ctl_reply(fd, "%" PRIu32, st.rule.code);
+        }
+        ctl_reply(fd, " site=0x%08" PRIX32 " %s", st.rule.site, s_ctl_triggers[st.rule.trigger]);
+        if (st.rule.trigger != ERRCHECK_INJECT_ONCE) {
+            ctl_reply(fd, "=%" PRIu32, st.rule.param);
+        }
+        ctl_reply(fd, " latency=%" PRIu32 "%s hits=%" PRIu32 " fired=%" PRIu32 "\n",
+                  st.rule.latency_us, st.rule.fail ? "" : " nofail", st.hits, st.fired);
+    }
+}
+
+// Returns false when the client asked to disconnect
+static bool ctl_command(int fd, char *line)
+{
+    char *args = line + strcspn(line, " \t");
+
+    if (*args != '\0') {
+        *args++ = '\0';
+    }
+    if (strcmp(line, "arm") == 0) {
+        errcheck_inject_rule_t rule;
+        const char *why = errcheck_inject_parse(args, &rule);
+        int slot = (why == NULL) ? errcheck_inject_arm(&rule) : -1;
+        if (why != NULL) {
+            ctl_reply(fd, "err %s\n", why);
+        } else if (slot < 0) {
+            ctl_reply(fd, "err rule table full\n");
+        } else {
+            ctl_reply(fd, "ok %d\n", slot);
+        }
+    } else if (strcmp(line, "disarm") == 0) {
+        uint32_t slot;
+        if (strcmp(args, "all") == 0) {
+            errcheck_inject_disarm_all();
+            ctl_reply(fd, "ok\n");
+        } else if (ctl_parse_u32(args, &slot) && slot <= INT32_MAX
+                   && errcheck_inject_disarm((int)slot)) {
+            ctl_reply(fd, "ok\n");
+        } else {
+            ctl_reply(fd, "err no such rule\n");
+        }
+    } else if (strcmp(line, "list") == 0) {
+        ctl_list(fd);
+        ctl_reply(fd, "ok\n");
+    } else if (strcmp(line, "quit") == 0) {
+        return false;
+    } else if (line[0] != '\0') {
+        ctl_reply(fd, "err unknown command\n");
+    }
+    return true;
+}
+
+static void ctl_serve(int fd)
+{
+    char buf[CTL_LINE_MAX];
+    size_t have = 0;
+    int idle_ms = 0;
+
+    while (__atomic_load_n(&s_ctl_running, __ATOMIC_ACQUIRE)) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, ERRCHECK_CTL_POLL_MS) <= 0) {
+            idle_ms += ERRCHECK_CTL_POLL_MS;
+            if (idle_ms >= ERRCHECK_CTL_IDLE_MS) {
+                ctl_reply(fd, "err idle timeout\n");
+                return;
+            }
+            continue;
+        }
+        ssize_t got = read(fd, buf + have, sizeof(buf) - 1u - have);
+        if (got <= 0) {
+            return;
+        }
+        have += (size_t)got;
+        idle_ms = 0;
+
+        char *nl;
+        while ((nl = memchr(buf, '\n', have)) != NULL) {
+            size_t len = (size_t)(nl - buf) + 1u;
+            *nl = '\0';
+            if (nl > buf && nl[-1] == '\r') {
+                nl[-1] = '\0';
+            }
+            if (!ctl_command(fd, buf)) {
+                return;
+            }
+            memmove(buf, buf + len, have - len);
+            have -= len;
+        }
+        if (have == sizeof(buf) - 1u) {
+            ctl_reply(fd, "err line too long\n");
+            return;
+        }
+    }
+}
+
+static void *ctl_thread_main(void *arg)
+{
+    (void)arg;
+    while (__atomic_load_n(&s_ctl_running, __ATOMIC_ACQUIRE)) {
+        struct pollfd pfd = { .fd = s_ctl_fd, .events = POLLIN };
+        if (poll(&pfd, 1, ERRCHECK_CTL_POLL_MS) <= 0) {
+            continue;
+        }
+        int client = accept(s_ctl_fd, NULL, NULL);
+        if (client >= 0) {
+            // One client at a time: a stalled one must not lock the others out
+            struct timeval tv = {
+                .tv_sec = ERRCHECK_CTL_IDLE_MS / 1000,
+                .tv_usec = (ERRCHECK_CTL_IDLE_MS % 1000) * 1000,
+            };
+            (void)setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            (void)setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            ctl_serve(client);
+            close(client);
+        }
+    }
+    return NULL;
+}
+
+// 0 if nobody serves the socket at 'addr' any more (safe to replace), else an
+// errno value: EADDRINUSE while a live process still accepts on it
+static int ctl_probe(const struct sockaddr_un *addr)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        return errno;
+    }
+    // Non-blocking: a live server with a full backlog answers EAGAIN, not a hang
+    (void)fcntl(fd, F_SETFL, O_NONBLOCK);
+    int rc = (connect(fd, (const struct sockaddr *)addr, sizeof(*addr)) == 0) ? EADDRINUSE : errno;
+    close(fd);
+    if (rc == EAGAIN || rc == EINPROGRESS) {
+        return EADDRINUSE;
+    }
+    return (rc == ECONNREFUSED || rc == ENOENT) ? 0 : rc;
+}
+
+/**
+ * @brief Creates the socket at 'path' (replacing a stale socket, never a live
+ * one or another kind of file) and starts serving.
+ */
+int errcheck_ctl_start(const char *path)
+{
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    int rc;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        return ENAMETOOLONG;
+    }
+    if (__atomic_exchange_n(&s_ctl_running, 1, __ATOMIC_ACQ_REL)) {
+        return EBUSY;
+    }
+    strcpy(addr.sun_path, path);
+    strcpy(s_ctl_path, path);
+
+    s_ctl_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s_ctl_fd < 0) {
+        rc = errno;
+        goto fail;
+    }
+    // Only a stale socket is replaced; never unlink a file someone else put there
+    // or a socket another process still serves
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            rc = EEXIST;
+            goto fail;
+        }
+        if ((rc = ctl_probe(&addr)) != 0) {
+            goto fail;
+        }
+        (void)unlink(path);
+    } else if (errno != ENOENT) {
+        rc = errno;
+        goto fail;
+    }
+    // Owner only. Nobody can connect before listen(), so the mode is set in time
+    // without touching the process-wide umask.
+    if (bind(s_ctl_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        rc = errno;
+        goto fail;
+    }
+    if (chmod(path, 0600) != 0 || listen(s_ctl_fd, 1) != 0) {
+        rc = errno;
+        (void)unlink(path);
+        goto fail;
+    }
+    rc = pthread_create(&s_ctl_thread, NULL, ctl_thread_main, NULL);
+    if (rc != 0) {
+        goto fail;
+    }
+    return 0;
+
+fail:
+    if (s_ctl_fd >= 0) {
+        close(s_ctl_fd);
+        s_ctl_fd = -1;
+    }
+    __atomic_store_n(&s_ctl_running, 0, __ATOMIC_RELEASE);
+    return rc;
+}
+
+void errcheck_ctl_stop(void)
+{
+    if (!__atomic_exchange_n(&s_ctl_running, 0, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+    pthread_join(s_ctl_thread, NULL);
+    close(s_ctl_fd);
+    s_ctl_fd = -1;
+    (void)unlink(s_ctl_path);
+}
+
+#endif /* ERRCHECK_ENABLE_CTL */
@@ -0,0 +1,35 @@
+/**
+ * =============================================================================
+ * err_ctl.h
+ * Unix-domain control socket for arming injection rules in a running service.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_CTL (POSIX hosts only; link err_ctl.c and
+ *              err_inject.c, build with -D ERRCHECK_ENABLE_INJECT and -pthread)
+ * * errcheck_ctl_start(path) serves a line-based text protocol on a background
+ * thread, one client at a time; a client silent for ERRCHECK_CTL_IDLE_MS (5 s)
+ * is dropped. The socket is created with mode 0600. Commands
+ * only publish rules through the lock-free table in err_inject.c, so checking
+ * threads never wait for the control thread and the process is never stopped.
+ *   arm [code=N] [site=0xHEX | at=FILE:LINE] [once | nth=N | every=N | rate=A/B]
+ *       [latency=US] [nofail]        -> ok <slot>   (default: once, fail)
+ *   disarm <slot> | disarm all       -> ok
+ *   list                             -> one line per armed rule, then ok
+ *   quit                             closes the connection
+ * Errors are answered with "err <reason>".
+ * * e.g.  echo 'arm code=3 every=10 latency=2000' | socat - UNIX-CONNECT:/run/app.ctl
+ * =============================================================================
+ */
+
+#ifndef ERR_CTL_H
+#define ERR_CTL_H
+
+#ifdef ERRCHECK_ENABLE_CTL
+    // Returns 0, or an errno value if the socket or thread cannot be created
+    // (EEXIST if 'path' exists and is not a socket, EADDRINUSE if another process
+    // still serves it)
+    int errcheck_ctl_start(const char *path);
+    // Closes the connection and the socket and removes the socket file
+    void errcheck_ctl_stop(void);
+#endif
+
+#endif /* ERR_CTL_H */
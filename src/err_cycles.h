@@ -0,0 +1,88 @@
+/**
+ * =============================================================================
+ * err_cycles.h
+ * Cycle/tick counter access for timing errcheck paths.
+ * =============================================================================
+ * errcheck_cycles()        cheapest free-running counter read (accounting)
+ * errcheck_cycles_begin()  serialized read for the start of a measured region
+ * errcheck_cycles_end()    serialized read for the end of a measured region
+ * * Sources: x86 TSC, AArch64 CNTVCT_EL0, Cortex-M3/4/7/33 DWT->CYCCNT (enable
+ * DWT and CYCCNT in the startup code), otherwise errcheck_now_ns().
+ * Units are counter ticks; ERRCHECK_CYCLES_ARE_NS is defined when they are ns.
+ * =============================================================================
+ */
+
+#ifndef ERR_CYCLES_H
+#define ERR_CYCLES_H
+
+#include <stdint.h>
+#include "errcheck.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+static inline uint64_t errcheck_cycles(void)
+{
+    uint32_t lo, hi;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline uint64_t errcheck_cycles_begin(void)
+{
+    uint32_t lo, hi;
+    // LFENCE keeps earlier instructions from drifting into the measured region
+    __asm__ __volatile__("lfence\n\trdtsc" : "=a"(lo), "=d"(hi) :: "memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+
+static inline uint64_t errcheck_cycles_end(void)
+{
+    uint32_t lo, hi, aux;
+    // RDTSCP waits for the measured region; LFENCE keeps later code out of it
+    __asm__ __volatile__("rdtscp\n\tlfence" : "=a"(lo), "=d"(hi), "=c"(aux) :: "memory");
+    (void)aux;
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#elif defined(__aarch64__)
+
+static inline uint64_t errcheck_cycles(void)
+{
+    uint64_t v;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+}
+
+static inline uint64_t errcheck_cycles_begin(void)
+{
+    uint64_t v;
+    __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(v) :: "memory");
+    return v;
+}
+
+static inline uint64_t errcheck_cycles_end(void)
+{
+    uint64_t v;
+    __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0\n\tisb" : "=r"(v) :: "memory");
+    return v;
+}
+
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+
+#define ERRCHECK_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004u)
+
+// 32-bit counter: measured regions must stay below 2^32 cycles
+static inline uint64_t errcheck_cycles(void)       { return ERRCHECK_DWT_CYCCNT; }
+static inline uint64_t errcheck_cycles_begin(void) { __asm__ __volatile__("dsb\n\tisb" ::: "memory"); return ERRCHECK_DWT_CYCCNT; }
+static inline uint64_t errcheck_cycles_end(void)   { uint64_t v = ERRCHECK_DWT_CYCCNT; __asm__ __volatile__("dsb\n\tisb" ::: "memory"); return v; }
+
+#else
+
+#define ERRCHECK_CYCLES_ARE_NS 1
+static inline uint64_t errcheck_cycles(void)       { return errcheck_now_ns(); }
+static inline uint64_t errcheck_cycles_begin(void) { return errcheck_now_ns(); }
+static inline uint64_t errcheck_cycles_end(void)   { return errcheck_now_ns(); }
+
+#endif
+
+#endif /* ERR_CYCLES_H */
@@ -0,0 +1,358 @@
+/**
+ * =============================================================================
+ * err_history.c
+ * Failure history ring, breadcrumbs and the optional shared-memory flight recorder.
+ * =============================================================================
+ * NOTE: Writers claim a slot with an atomic increment of the head, fill it, and
+ * publish the slot's sequence number last. A reader that finds a sequence number
+ * that does not match the slot index treats the slot as torn (the writer was
+ * killed or preempted mid-record) and skips it.
+ * =============================================================================
+ */
+
+#if defined(ERRCHECK_ENABLE_SHM_RECORDER) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // mmap(), ftruncate(), O_CLOEXEC under strict -std=c99
+#endif
+
+#include "err_history.h"
+#include <string.h>
+
+#ifdef ERRCHECK_ENABLE_SHM_RECORDER
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef ERRCHECK_ENABLE_ATTACH
+#define ERRCHECK_HISTORY_ATTACH_INIT                                           \
+    .attach_size = (uint16_t)sizeof(errcheck_attach_block_t),                  \
+    .attach_offset = (uint32_t)offsetof(errcheck_history_region_t, attachments),
+#else
+#define ERRCHECK_HISTORY_ATTACH_INIT
+#endif
+
+#define ERRCHECK_HISTORY_HEADER_INIT {                                         \
+    .magic = ERRCHECK_HISTORY_MAGIC,                                           \
+    .version = ERRCHECK_HISTORY_VERSION,                                       \
+    .header_size = (uint16_t)sizeof(errcheck_history_header_t),                \
+    .record_size = (uint16_t)sizeof(errcheck_record_t),                        \
+    .breadcrumb_size = (uint16_t)sizeof(errcheck_breadcrumb_t),                \
+    .record_depth = ERRCHECK_HISTORY_DEPTH,                                    \
+    .breadcrumb_depth = ERRCHECK_BREADCRUMB_DEPTH,                             \
+    .record_offset = (uint32_t)offsetof(errcheck_history_region_t, records),   \
+    .breadcrumb_offset = (uint32_t)offsetof(errcheck_history_region_t, breadcrumbs), \
+    ERRCHECK_HISTORY_ATTACH_INIT                                               \
+}
+
+#ifdef ERRCHECK_ENABLE_PER_CORE
+// Each core appends to its own region, so the heads never move between caches
+errcheck_history_region_t g_errcheck_history_core[ERRCHECK_CORES] = {
+    [0 ... ERRCHECK_CORES - 1] = { .hdr = ERRCHECK_HISTORY_HEADER_INIT }
+};
+#else
+// In-process region used unless a flight recorder file is mapped
+static errcheck_history_region_t s_history_local = { .hdr = ERRCHECK_HISTORY_HEADER_INIT };
+
+errcheck_history_region_t *g_errcheck_history = &s_history_local;
+#endif
+
+
+/**
+ * @brief Converts a captured context into the fixed persisted layout.
+ */
+void errcheck_record_from_context(errcheck_record_t *rec, const failure_context_t *ctx)
+{
+    rec->seq = 0;
+    rec->site = errcheck_site_id(ctx->file, ctx->line);
+    rec->inner_code = ctx->inner_code;
+    rec->line = ctx->line;
+    rec->timestamp_ns = errcheck_now_ns();
+    rec->code = (uint32_t)ctx->code;
+#ifdef ERRCHECK_ENABLE_ATTACH
+    rec->flags = errcheck_attach_pending() ? ERRCHECK_REC_ATTACHED : 0u;
+#else
+    rec->flags = 0;
+#endif
+    rec->reserved = 0;
+}
+
+/**
+ * @brief Appends a record to the active history ring (lock-free, multi-writer).
+ */
+void errcheck_history_append(const errcheck_record_t *rec)
+{
+    errcheck_history_region_t *h = g_errcheck_history;
+    uint32_t n = __atomic_fetch_add(&h->hdr.record_head, 1u, __ATOMIC_RELAXED);
+    errcheck_record_t *slot = &h->records[n & (ERRCHECK_HISTORY_DEPTH - 1u)];
+
+#ifdef ERRCHECK_ENABLE_ATTACH
+    // Only records built from the failing thread's context carry its attachments
+    if ((rec->flags & ERRCHECK_REC_ATTACHED) != 0) {
+        errcheck_attach_take(&h->attachments[n & (ERRCHECK_HISTORY_DEPTH - 1u)], n + 1u);
+    }
+#endif
+
+    // Invalidate first so a half-overwritten slot never passes for the old record
+    __atomic_store_n(&slot->seq, 0u, __ATOMIC_RELAXED);
+    slot->site = rec->site;
+    slot->inner_code = rec->inner_code;
+    slot->line = rec->line;
+    slot->timestamp_ns = rec->timestamp_ns;
+    slot->code = rec->code;
+    slot->flags = rec->flags;
+    slot->reserved = 0;
+    __atomic_store_n(&slot->seq, n + 1u, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Records an application breadcrumb. 'tag' must be non-zero.
+ */
+void errcheck_breadcrumb(uint32_t tag, uint32_t value)
+{
+    errcheck_history_region_t *h = g_errcheck_history;
+    uint32_t n = __atomic_fetch_add(&h->hdr.breadcrumb_head, 1u, __ATOMIC_RELAXED);
+    errcheck_breadcrumb_t *slot = &h->breadcrumbs[n & (ERRCHECK_BREADCRUMB_DEPTH - 1u)];
+
+    __atomic_store_n(&slot->tag, 0u, __ATOMIC_RELAXED);
+    slot->timestamp_ns = errcheck_now_ns();
+    slot->value = value;
+    __atomic_store_n(&slot->tag, tag, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Sanity-checks a region header against the number of bytes available.
+ */
+bool errcheck_history_header_valid(const errcheck_history_header_t *hdr, size_t size)
+{
+    if (size < sizeof(*hdr) || hdr->magic != ERRCHECK_HISTORY_MAGIC ||
+        hdr->version != ERRCHECK_HISTORY_VERSION) {
+        return false;
+    }
+    if (hdr->record_depth == 0 || (hdr->record_depth & (hdr->record_depth - 1u)) != 0 ||
+        hdr->breadcrumb_depth == 0 ||
+        (hdr->breadcrumb_depth & (hdr->breadcrumb_depth - 1u)) != 0) {
+        return false;
+    }
+    if (hdr->record_size < sizeof(errcheck_record_t) ||
+        hdr->breadcrumb_size < sizeof(errcheck_breadcrumb_t)) {
+        return false;
+    }
+    uint64_t rec_end = (uint64_t)hdr->record_offset +
+                       (uint64_t)hdr->record_depth * hdr->record_size;
+    uint64_t crumb_end = (uint64_t)hdr->breadcrumb_offset +
+                         (uint64_t)hdr->breadcrumb_depth * hdr->breadcrumb_size;
+    uint64_t attach_end = (uint64_t)hdr->attach_offset +
+                          (uint64_t)hdr->record_depth * hdr->attach_size;
+    if (hdr->attach_size != 0 && (hdr->attach_size < offsetof(errcheck_attach_block_t, data) ||
+                                  hdr->attach_offset < hdr->header_size || attach_end > size)) {
+        return false;
+    }
+    return hdr->record_offset >= hdr->header_size && rec_end <= size &&
+           hdr->breadcrumb_offset >= hdr->header_size && crumb_end <= size;
+}
+
+/**
+ * @brief Copies the valid records of a region, oldest first.
+ */
+uint32_t errcheck_history_read(const errcheck_history_header_t *hdr,
+                               errcheck_record_t *out, uint32_t max)
+{
+    const uint8_t *base = (const uint8_t *)hdr + hdr->record_offset;
+    uint32_t head = __atomic_load_n(&hdr->record_head, __ATOMIC_ACQUIRE);
+    uint32_t count = head < hdr->record_depth ? head : hdr->record_depth;
+    uint32_t n = 0;
+
+    for (uint32_t i = head - count; i != head && n < max; i++) {
+        const errcheck_record_t *slot = (const errcheck_record_t *)
+            (base + (size_t)(i & (hdr->record_depth - 1u)) * hdr->record_size);
+        // A writer zeroes seq, rewrites the fields and publishes a new seq: the copy
+        // is only whole if the same seq is seen before and after it
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != i + 1u) {
+            continue;
+        }
+        memcpy(&out[n], slot, sizeof(out[n]));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == i + 1u) {
+            out[n].seq = i + 1u;
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Copies a record's attachment payload if the block still belongs to it.
+ */
+uint16_t errcheck_history_attachments(const errcheck_history_header_t *hdr,
+                                      const errcheck_record_t *rec,
+                                      uint8_t *out, uint16_t max, uint16_t *flags)
+{
+    if (hdr->attach_size == 0 || rec->seq == 0 || (rec->flags & ERRCHECK_REC_ATTACHED) == 0) {
+        return 0;
+    }
+    const errcheck_attach_block_t *block = (const errcheck_attach_block_t *)
+        ((const uint8_t *)hdr + hdr->attach_offset +
+         (size_t)((rec->seq - 1u) & (hdr->record_depth - 1u)) * hdr->attach_size);
+    uint16_t room = (uint16_t)(hdr->attach_size - offsetof(errcheck_attach_block_t, data));
+
+    if (__atomic_load_n(&block->seq, __ATOMIC_ACQUIRE) != rec->seq) {
+        return 0;
+    }
+    uint16_t len = block->len;
+    len = (len > room) ? room : len;
+    len = (len > max) ? max : len;
+    memcpy(out, block->data, len);
+    *flags = block->flags;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (__atomic_load_n(&block->seq, __ATOMIC_RELAXED) == rec->seq) ? len : 0;
+}
+
+/**
+ * @brief Copies the valid breadcrumbs of a region, oldest first.
+ */
+uint32_t errcheck_breadcrumb_read(const errcheck_history_header_t *hdr,
+                                  errcheck_breadcrumb_t *out, uint32_t max)
+{
+    const uint8_t *base = (const uint8_t *)hdr + hdr->breadcrumb_offset;
+    uint32_t head = __atomic_load_n(&hdr->breadcrumb_head, __ATOMIC_ACQUIRE);
+    uint32_t count = head < hdr->breadcrumb_depth ? head : hdr->breadcrumb_depth;
+    uint32_t n = 0;
+
+    for (uint32_t i = head - count; i != head && n < max; i++) {
+        const errcheck_breadcrumb_t *slot = (const errcheck_breadcrumb_t *)
+            (base + (size_t)(i & (hdr->breadcrumb_depth - 1u)) * hdr->breadcrumb_size);
+        uint32_t tag = __atomic_load_n(&slot->tag, __ATOMIC_ACQUIRE);
+        if (tag == 0) {
+            continue;
+        }
+        memcpy(&out[n], slot, sizeof(out[n]));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        // Tags repeat, so also drop the slot if a later writer has claimed it since
+        if (__atomic_load_n(&slot->tag, __ATOMIC_RELAXED) == tag &&
+            __atomic_load_n(&hdr->breadcrumb_head, __ATOMIC_RELAXED) - i <= hdr->breadcrumb_depth) {
+            out[n].tag = tag;
+            n++;
+        }
+    }
+    return n;
+}
+
+
+#ifdef ERRCHECK_ENABLE_SHM_RECORDER
+
+static errcheck_history_region_t *s_flight_map = NULL;
+
+// True if an existing mapping was written by a build with the same layout
+static bool layout_matches(const errcheck_history_header_t *hdr)
+{
+    static const errcheck_history_header_t expected = ERRCHECK_HISTORY_HEADER_INIT;
+
+    return hdr->magic == expected.magic && hdr->version == expected.version &&
+           hdr->header_size == expected.header_size &&
+           hdr->record_size == expected.record_size &&
+           hdr->breadcrumb_size == expected.breadcrumb_size &&
+           hdr->record_depth == expected.record_depth &&
+           hdr->breadcrumb_depth == expected.breadcrumb_depth &&
+           hdr->record_offset == expected.record_offset &&
+           hdr->breadcrumb_offset == expected.breadcrumb_offset &&
+           hdr->attach_size == expected.attach_size &&
+           hdr->attach_offset == expected.attach_offset;
+}
+
+/**
+ * @brief Maps a flight recorder file and makes it the active history region.
+ */
+int errcheck_flight_open(const char *path)
+{
+    const size_t size = sizeof(errcheck_history_region_t);
+    struct stat st;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    bool same_size = ((size_t)st.st_size == size);
+    if (!same_size && ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file referenced
+    if (p == MAP_FAILED) {
+        return -1;
+    }
+
+    errcheck_history_region_t *r = (errcheck_history_region_t *)p;
+    if (!same_size || !layout_matches(&r->hdr)) {
+        static const errcheck_history_header_t fresh = ERRCHECK_HISTORY_HEADER_INIT;
+        memset(r, 0, size);
+        r->hdr = fresh;
+    }
+    r->hdr.generation++;
+    r->hdr.owner_pid = (uint32_t)getpid();
+
+    errcheck_flight_close();
+    s_flight_map = r;
+    __atomic_store_n(&g_errcheck_history, r, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/**
+ * @brief Detaches the flight recorder; later records go to the in-process region.
+ * * The region is unmapped at once. Call this only while no other thread can log a
+ * failure or breadcrumb (e.g. after joining workers, before exit): a writer that
+ * loaded the old g_errcheck_history pointer would store into the unmapped pages.
+ */
+void errcheck_flight_close(void)
+{
+    if (s_flight_map == NULL) {
+        return;
+    }
+    __atomic_store_n(&g_errcheck_history, &s_history_local, __ATOMIC_RELEASE);
+    munmap(s_flight_map, sizeof(*s_flight_map));
+    s_flight_map = NULL;
+}
+
+/**
+ * @brief Maps a flight recorder file read-only for inspection.
+ */
+const errcheck_history_header_t *errcheck_flight_attach(const char *path, size_t *size)
+{
+    struct stat st;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(errcheck_history_header_t)) {
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+    if (!errcheck_history_header_valid((const errcheck_history_header_t *)p,
+                                       (size_t)st.st_size)) {
+        munmap(p, (size_t)st.st_size);
+        return NULL;
+    }
+    *size = (size_t)st.st_size;
+    return (const errcheck_history_header_t *)p;
+}
+
+void errcheck_flight_detach(const errcheck_history_header_t *hdr, size_t size)
+{
+    if (hdr != NULL) {
+        munmap((void *)hdr, size);
+    }
+}
+
+#endif /* ERRCHECK_ENABLE_SHM_RECORDER */
@@ -0,0 +1,151 @@
+/**
+ * =============================================================================
+ * err_history.h
+ * Failure history ring, breadcrumb trail and shared-memory flight recorder.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_HISTORY (errcheck.c appends every logged failure)
+ * Optional:    -D ERRCHECK_ENABLE_SHM_RECORDER (POSIX hosts only)
+ * * By default both rings live in a static region inside the process. In flight
+ * recorder mode the very same region is a MAP_SHARED file mapping (e.g. under
+ * /dev/shm), so the kernel keeps the last records after SIGKILL/OOM and a
+ * supervisor or the restarted process can read them back. The hot path writes
+ * exactly the same stores in both modes; there is no msync() or copy.
+ * =============================================================================
+ */
+
+#ifndef ERR_HISTORY_H
+#define ERR_HISTORY_H
+
+#include <stddef.h>
+#include "errcheck.h"
+#include "err_attach.h"
+
+/* --- Configuration (depths must be powers of two) --- */
+#ifndef ERRCHECK_HISTORY_DEPTH
+    #define ERRCHECK_HISTORY_DEPTH 16u
+#endif
+#ifndef ERRCHECK_BREADCRUMB_DEPTH
+    #define ERRCHECK_BREADCRUMB_DEPTH 32u
+#endif
+
+#if (ERRCHECK_HISTORY_DEPTH & (ERRCHECK_HISTORY_DEPTH - 1u)) != 0
+    #error "ERRCHECK_HISTORY_DEPTH must be a power of two"
+#endif
+#if (ERRCHECK_BREADCRUMB_DEPTH & (ERRCHECK_BREADCRUMB_DEPTH - 1u)) != 0
+    #error "ERRCHECK_BREADCRUMB_DEPTH must be a power of two"
+#endif
+
+#define ERRCHECK_HISTORY_MAGIC   0x52464345u   // "ECFR" little-endian
+#define ERRCHECK_HISTORY_VERSION 2u
+
+#define ERRCHECK_REC_ATTACHED    0x0001u      // An attachment block belongs to the record
+
+/* --- Persisted failure record (fixed 32-byte layout, host endianness) --- */
+typedef struct {
+    uint32_t seq;               // 1-based write sequence; 0 marks an empty or torn slot
+    uint32_t site;              // errcheck_site_id(file, line)
+    uint32_t inner_code;        // Copy of failure_context_t.inner_code
+    uint32_t line;              // Source line of the failing check
+    uint64_t timestamp_ns;      // errcheck_now_ns() at logging time
+    uint32_t code;              // err_t widened so user-defined err_t types fit
+    uint16_t flags;             // ERRCHECK_REC_* bits
+    uint16_t reserved;
+} errcheck_record_t;
+
+/* --- Breadcrumb: cheap application event leading up to a failure (16 bytes) --- */
+typedef struct {
+    uint64_t timestamp_ns;
+    uint32_t tag;               // Application-defined event identifier (0 marks an empty slot)
+    uint32_t value;
+} errcheck_breadcrumb_t;
+
+/* --- Self-describing region header ---
+ * Readers must locate the rings through the offsets/sizes stored here rather than
+ * through the C struct below, so a tool built with different depths can still parse
+ * a recorder file. Heads count total writes; slot = head & (depth - 1). */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint16_t record_size;
+    uint16_t breadcrumb_size;
+    uint32_t record_depth;
+    uint32_t breadcrumb_depth;
+    uint32_t record_offset;
+    uint32_t breadcrumb_offset;
+    uint32_t generation;        // Incremented every time a process attaches for writing
+    uint32_t owner_pid;         // Last writer (0 for the in-process region)
+    volatile uint32_t record_head;
+    volatile uint32_t breadcrumb_head;
+    uint16_t attach_size;       // Bytes per attachment block, 0 if the writer had none
+    uint16_t reserved;
+    uint32_t attach_offset;     // record_depth blocks; block i belongs to record slot i
+} errcheck_history_header_t;
+
+typedef struct {
+    errcheck_history_header_t hdr;
+    errcheck_record_t records[ERRCHECK_HISTORY_DEPTH];
+    errcheck_breadcrumb_t breadcrumbs[ERRCHECK_BREADCRUMB_DEPTH];
+#ifdef ERRCHECK_ENABLE_ATTACH
+    errcheck_attach_block_t attachments[ERRCHECK_HISTORY_DEPTH];
+#endif
+} ERRCHECK_CORE_ALIGNED errcheck_history_region_t;
+
+#ifdef ERRCHECK_ENABLE_PER_CORE
+    #ifdef ERRCHECK_ENABLE_SHM_RECORDER
+        #error "ERRCHECK_ENABLE_SHM_RECORDER cannot be combined with ERRCHECK_ENABLE_PER_CORE"
+    #endif
+    // One complete region per core; each has its own heads and sequence numbers.
+    // Supervisors read another core's history through &g_errcheck_history_core[n].hdr.
+    extern errcheck_history_region_t g_errcheck_history_core[ERRCHECK_CORES];
+    #define g_errcheck_history (&g_errcheck_history_core[errcheck_core_id()])
+#else
+    // Region currently receiving records (static storage, or the flight recorder mapping).
+    extern errcheck_history_region_t *g_errcheck_history;
+#endif
+
+/* Function prototypes */
+void errcheck_record_from_context(errcheck_record_t *rec, const failure_context_t *ctx);
+void errcheck_history_append(const errcheck_record_t *rec);
+// Hands a record to every enabled sink: history, sketch, anomaly, lifetime counters
+// and retained ring (errcheck.c; linked in every configuration)
+void errcheck_sinks_emit(const errcheck_record_t *rec);
+void errcheck_breadcrumb(uint32_t tag, uint32_t value);
+
+// Copies valid records of a region oldest-first into 'out'; returns the count copied.
+uint32_t errcheck_history_read(const errcheck_history_header_t *hdr,
+                               errcheck_record_t *out, uint32_t max);
+// Same for breadcrumbs.
+uint32_t errcheck_breadcrumb_read(const errcheck_history_header_t *hdr,
+                                  errcheck_breadcrumb_t *out, uint32_t max);
+// Copies the attachment payload of record 'rec' (read from the same region) into
+// 'out'; returns the bytes copied, 0 if it has none or it was overwritten since.
+uint16_t errcheck_history_attachments(const errcheck_history_header_t *hdr,
+                                      const errcheck_record_t *rec,
+                                      uint8_t *out, uint16_t max, uint16_t *flags);
+// Returns true if 'hdr' describes a parsable region of at most 'size' bytes.
+bool errcheck_history_header_valid(const errcheck_history_header_t *hdr, size_t size);
+
+#define ERRCHECK_BREADCRUMB(tag, value) \
+    errcheck_breadcrumb((uint32_t)(tag), (uint32_t)(value))
+
+
+/* ========================================================================= */
+/* Optional: Shared-memory flight recorder (POSIX hosts)                     */
+/* ========================================================================= */
+#ifdef ERRCHECK_ENABLE_SHM_RECORDER
+    // Maps 'path' read/write and redirects the rings into it. A file left behind by a
+    // previous run with the same layout is kept, so new records continue after the old
+    // ones. Call once at startup, before other threads can fail. Returns 0 on success.
+    int errcheck_flight_open(const char *path);
+    // Switches back to the in-process region and unmaps the file (contents are kept).
+    // Only call it while no other thread can append or leave a breadcrumb.
+    void errcheck_flight_close(void);
+
+    // Read-only view for supervisors and post-mortem tools. Returns NULL if the file
+    // is missing or does not hold a valid region.
+    const errcheck_history_header_t *errcheck_flight_attach(const char *path, size_t *size);
+    void errcheck_flight_detach(const errcheck_history_header_t *hdr, size_t size);
+#endif
+
+#endif /* ERR_HISTORY_H */
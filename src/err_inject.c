@@ -0,0 +1,409 @@
+/**
+ * =============================================================================
+ * err_inject.c
+ * Injection rule table and the per-check decision.
+ * =============================================================================
+ * NOTE: Each rule slot has a state word: bit 0 is set while a writer updates
+ * the slot, bit 1 while the rule is armed, and the remaining bits count
+ * updates. A checking thread copies the rule between two reads of the state
+ * and ignores the slot unless both reads match and show an armed, idle rule,
+ * so a rule changed mid-copy is never half applied. The hit counter carries
+ * the state word it was armed with, and a hit is only counted while that tag
+ * still matches, so a stale copy never takes a hit from a re-armed rule.
+ * =============================================================================
+ */
+
+#include "err_inject.h"
+#include "err_acct.h"
+#include "err_usdt.h"
+#include <stddef.h>
+
+#ifdef ERRCHECK_ENABLE_INJECT
+
+#include <stdlib.h>
+#include <string.h>
+#if defined(__unix__)
+#include <stdio.h>
+#endif
+
+#define INJECT_BUSY     1u
+#define INJECT_ARMED    2u
+#define INJECT_GEN_STEP 4u
+
+typedef struct {
+    uint32_t state;
+    uint32_t site;
+    uint32_t code;
+    uint32_t trigger;
+    uint32_t param;
+    uint32_t latency_us;
+    uint32_t fail;
+    uint32_t fired;
+    uint64_t hits;              // Armed state word (high half), matching calls (low half)
+} inject_slot_t;
+
+uint32_t g_errcheck_inject_armed = 0;
+
+static inject_slot_t s_inject[ERRCHECK_INJECT_RULES];
+static ERRCHECK_THREAD_LOCAL uint32_t t_inject_rng = 0;
+
+// xorshift32, seeded per thread from the clock and a thread-local address
+// unless errcheck_inject_seed() was called
+static uint32_t inject_random(void)
+{
+    uint32_t x = t_inject_rng;
+
+    if (x == 0) {
+        x = (uint32_t)errcheck_now_ns() ^ (uint32_t)(uintptr_t)&t_inject_rng;
+        x |= 1u;
+    }
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    t_inject_rng = x;
+    return x;
+}
+
+void errcheck_inject_seed(uint32_t seed)
+{
+    t_inject_rng = seed | 1u;
+}
+
+// Takes the slot for writing if it is idle and its armed bit equals 'armed'
+static bool inject_lock(inject_slot_t *s, bool armed, uint32_t *state)
+{
+    uint32_t cur = __atomic_load_n(&s->state, __ATOMIC_RELAXED);
+
+    if ((cur & INJECT_BUSY) != 0 || ((cur & INJECT_ARMED) != 0) != armed) {
+        return false;
+    }
+    if (!__atomic_compare_exchange_n(&s->state, &cur, cur | INJECT_BUSY, false,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return false;
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    *state = cur;
+    return true;
+}
+
+// State word the slot gets when the writer holding 'state' unlocks it
+static uint32_t inject_next_state(uint32_t state, bool armed)
+{
+    return ((state & ~(INJECT_BUSY | INJECT_ARMED)) + INJECT_GEN_STEP)
+         | (armed ? INJECT_ARMED : 0u);
+}
+
+static void inject_unlock(inject_slot_t *s, uint32_t state, bool armed)
+{
+    __atomic_store_n(&s->state, inject_next_state(state, armed), __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Arms a rule in the first free slot.
+ */
+int errcheck_inject_arm(const errcheck_inject_rule_t *rule)
+{
+    if (rule->trigger > ERRCHECK_INJECT_RATE
+        || ((rule->trigger == ERRCHECK_INJECT_NTH || rule->trigger == ERRCHECK_INJECT_EVERY)
+            && rule->param == 0)) {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < ERRCHECK_INJECT_RULES; i++) {
+        inject_slot_t *s = &s_inject[i];
+        uint32_t state;
+
+        if (!inject_lock(s, false, &state)) {
+            continue;
+        }
+        __atomic_store_n(&s->site, rule->site, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->code, rule->code, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->trigger, (uint32_t)rule->trigger, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->param, rule->param, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->latency_us, rule->latency_us, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->fail, rule->fail ? 1u : 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->hits, (uint64_t)inject_next_state(state, true) << 32, __ATOMIC_RELAXED);
+        __atomic_store_n(&s->fired, 0u, __ATOMIC_RELAXED);
+        inject_unlock(s, state, true);
+        __atomic_fetch_add(&g_errcheck_inject_armed, 1u, __ATOMIC_RELEASE);
+        return (int)i;
+    }
+    return -1;
+}
+
+bool errcheck_inject_disarm(int slot)
+{
+    uint32_t state;
+
+    if (slot < 0 || (uint32_t)slot >= ERRCHECK_INJECT_RULES
+        || !inject_lock(&s_inject[slot], true, &state)) {
+        return false;
+    }
+    inject_unlock(&s_inject[slot], state, false);
+    __atomic_fetch_sub(&g_errcheck_inject_armed, 1u, __ATOMIC_RELAXED);
+    return true;
+}
+
+void errcheck_inject_disarm_all(void)
+{
+    for (int i = 0; i < (int)ERRCHECK_INJECT_RULES; i++) {
+        (void)errcheck_inject_disarm(i);
+    }
+}
+
+bool errcheck_inject_get(int slot, errcheck_inject_status_t *out)
+{
+    if (slot < 0 || (uint32_t)slot >= ERRCHECK_INJECT_RULES) {
+        return false;
+    }
+    const inject_slot_t *s = &s_inject[slot];
+    uint32_t state = __atomic_load_n(&s->state, __ATOMIC_ACQUIRE);
+
+    out->rule.site = __atomic_load_n(&s->site, __ATOMIC_RELAXED);
+    out->rule.code = __atomic_load_n(&s->code, __ATOMIC_RELAXED);
+    out->rule.trigger = (errcheck_inject_trigger_t)__atomic_load_n(&s->trigger, __ATOMIC_RELAXED);
+    out->rule.param = __atomic_load_n(&s->param, __ATOMIC_RELAXED);
+    out->rule.latency_us = __atomic_load_n(&s->latency_us, __ATOMIC_RELAXED);
+    out->rule.fail = __atomic_load_n(&s->fail, __ATOMIC_RELAXED) != 0;
+    out->hits = (uint32_t)__atomic_load_n(&s->hits, __ATOMIC_RELAXED);
+    out->fired = __atomic_load_n(&s->fired, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (state & (INJECT_BUSY | INJECT_ARMED)) == INJECT_ARMED
+        && state == __atomic_load_n(&s->state, __ATOMIC_RELAXED);
+}
+
+static bool inject_parse_u32(const char *s, uint32_t *out)
+{
+    char *end;
+    unsigned long v = strtoul(s, &end, 0);
+
+    if (end == s || *end != '\0' || v > UINT32_MAX) {
+        return false;
+    }
+    *out = (uint32_t)v;
+    return true;
+}
+
+// Splits off the next blank-separated token; NULL at the end
+static char *inject_token(char **cursor)
+{
+    char *p = *cursor + strspn(*cursor, " \t");
+
+    if (*p == '\0') {
+        return NULL;
+    }
+    char *end = p + strcspn(p, " \t");
+    *cursor = end;
+    if (*end != '\0') {
+        *end = '\0';
+        *cursor = end + 1;
+    }
+    return p;
+}
+
+const char *errcheck_inject_parse(char *args, errcheck_inject_rule_t *rule)
+{
+    memset(rule, 0, sizeof(*rule));
+    rule->code = ERRCHECK_INJECT_ANY_CODE;
+    rule->site = ERRCHECK_INJECT_ANY_SITE;
+    rule->trigger = ERRCHECK_INJECT_ONCE;
+    rule->fail = true;
+
+    for (char *tok = inject_token(&args); tok != NULL; tok = inject_token(&args)) {
+        char *val = strchr(tok, '=');
+        if (val != NULL) {
+            *val++ = '\0';
+        }
+        if (strcmp(tok, "once") == 0 && val == NULL) {
+            rule->trigger = ERRCHECK_INJECT_ONCE;
+        } else if (strcmp(tok, "nofail") == 0 && val == NULL) {
+            rule->fail = false;
+        } else if (val == NULL) {
+            return "expected key=value";
+        } else if (strcmp(tok, "code") == 0) {
+            if (!inject_parse_u32(val, &rule->code)) {
+                return "bad code";
+            }
+        } else if (strcmp(tok, "site") == 0) {
+            if (!inject_parse_u32(val, &rule->site)) {
+                return "bad site";
+            }
+        } else if (strcmp(tok, "at") == 0) {
+            char *colon = strrchr(val, ':');
+            uint32_t line;
+            if (colon == NULL) {
+                return "at needs FILE:LINE";
+            }
+            *colon = '\0';
+            if (!inject_parse_u32(colon + 1, &line)) {
+                return "bad line";
+            }
+            rule->site = errcheck_site_id(val, line);
+        } else if (strcmp(tok, "nth") == 0 || strcmp(tok, "every") == 0) {
+            rule->trigger = (tok[0] == 'n') ? ERRCHECK_INJECT_NTH : ERRCHECK_INJECT_EVERY;
+            if (!inject_parse_u32(val, &rule->param) || rule->param == 0) {
+                return "n must be >= 1";
+            }
+        } else if (strcmp(tok, "rate") == 0) {
+            char *slash = strchr(val, '/');
+            uint32_t num, den;
+            if (slash == NULL) {
+                return "rate needs A/B";
+            }
+            *slash = '\0';
+            if (!inject_parse_u32(val, &num) || !inject_parse_u32(slash + 1, &den)
+                || den == 0 || num > den) {
+                return "bad rate";
+            }
+            rule->trigger = ERRCHECK_INJECT_RATE;
+            rule->param = (uint32_t)(((uint64_t)num << 16) / den);
+        } else if (strcmp(tok, "latency") == 0) {
+            if (!inject_parse_u32(val, &rule->latency_us)) {
+                return "bad latency";
+            }
+        } else {
+            return "unknown argument";
+        }
+    }
+    return NULL;
+}
+
+// Counts a matching call against the rule armed as 'state'; fails once the slot
+// has been re-armed, so the new rule's count (and its ONCE) stays untouched
+static bool inject_hit(inject_slot_t *s, uint32_t state, uint32_t *n)
+{
+    uint64_t h = __atomic_load_n(&s->hits, __ATOMIC_RELAXED);
+
+    do {
+        if ((uint32_t)(h >> 32) != state) {
+            return false;
+        }
+        *n = (uint32_t)h + 1u;
+    } while (!__atomic_compare_exchange_n(&s->hits, &h, (h & ~(uint64_t)UINT32_MAX) | *n, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return true;
+}
+
+static bool inject_triggered(uint32_t n, uint32_t trigger, uint32_t param)
+{
+    switch (trigger) {
+    case ERRCHECK_INJECT_ONCE:  return n == 1u;
+    case ERRCHECK_INJECT_NTH:   return n == param;
+    case ERRCHECK_INJECT_EVERY: return (n % param) == 0u;
+    case ERRCHECK_INJECT_RATE:  return (inject_random() >> 16) < param;
+    default:                    return false;
+    }
+}
+
+/**
+ * @brief Applies the armed rules to one guarded call. The first rule that fires
+ * decides; later rules are not counted for this call.
+ */
+int errcheck_inject_eval(uint32_t code, const char *file, uint32_t line, int result)
+{
+    uint32_t site = 0;
+    bool have_site = false;
+
+    for (uint32_t i = 0; i < ERRCHECK_INJECT_RULES; i++) {
+        inject_slot_t *s = &s_inject[i];
+        uint32_t state = __atomic_load_n(&s->state, __ATOMIC_ACQUIRE);
+
+        if ((state & (INJECT_BUSY | INJECT_ARMED)) != INJECT_ARMED) {
+            continue;
+        }
+        uint32_t r_site = __atomic_load_n(&s->site, __ATOMIC_RELAXED);
+        uint32_t r_code = __atomic_load_n(&s->code, __ATOMIC_RELAXED);
+        uint32_t trigger = __atomic_load_n(&s->trigger, __ATOMIC_RELAXED);
+        uint32_t param = __atomic_load_n(&s->param, __ATOMIC_RELAXED);
+        uint32_t latency_us = __atomic_load_n(&s->latency_us, __ATOMIC_RELAXED);
+        uint32_t fail = __atomic_load_n(&s->fail, __ATOMIC_RELAXED);
+        uint32_t n;
+
+        if (r_code != ERRCHECK_INJECT_ANY_CODE && r_code != code) {
+            continue;
+        }
+        if (r_site != ERRCHECK_INJECT_ANY_SITE) {
+            if (!have_site) {
+                site = errcheck_site_id(file, line);
+                have_site = true;
+            }
+            if (r_site != site) {
+                continue;
+            }
+        }
+        // Count first, then re-check: a hit that lands before a re-arm is reset
+        // with the old rule, one after it is refused by inject_hit()
+        if (!inject_hit(s, state, &n)) {
+            continue;
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (state != __atomic_load_n(&s->state, __ATOMIC_RELAXED)) {
+            continue;   // Re-armed under us; the new rule applies from the next call
+        }
+        if (!inject_triggered(n, trigger, param)) {
+            continue;
+        }
+
+        ERRCHECK_ACCT_START(acct_t);
+        __atomic_fetch_add(&s->fired, 1u, __ATOMIC_RELAXED);
+        ERRCHECK_USDT3(inject, code, file, line);
+        ERRCHECK_ACCT_LAP(acct_t, ERRCHECK_ACCT_INJECT);   // The delay is not CPU time
+        if (latency_us != 0) {
+            errcheck_sleep_ns((uint64_t)latency_us * 1000u);
+        }
+        return fail ? 0 : result;
+    }
+    return result;
+}
+
+#if defined(__unix__) && defined(__GNUC__) && !defined(ERRCHECK_INJECT_NO_ENV)
+static uint32_t inject_fired_total(void)
+{
+    uint32_t total = 0;
+
+    for (uint32_t i = 0; i < ERRCHECK_INJECT_RULES; i++) {
+        total += __atomic_load_n(&s_inject[i].fired, __ATOMIC_RELAXED);
+    }
+    return total;
+}
+
+static void inject_write_report(void)
+{
+    const char *path = getenv("ERRCHECK_INJECT_REPORT");
+    FILE *f = (path != NULL) ? fopen(path, "w") : NULL;
+
+    if (f != NULL) {
+        fprintf(f, "fired %lu\n", (unsigned long)inject_fired_total());
+        fclose(f);
+    }
+}
+
+// Arms the rules in $ERRCHECK_INJECT before main(), e.g. for campaign runs
+__attribute__((constructor))
+static void inject_arm_from_env(void)
+{
+    const char *env = getenv("ERRCHECK_INJECT");
+    char spec[512];
+
+    if (env == NULL || strlen(env) >= sizeof(spec)) {
+        return;
+    }
+    strcpy(spec, env);
+    for (char *item = spec; item != NULL;) {
+        char *next = strchr(item, ';');
+        errcheck_inject_rule_t rule;
+        if (next != NULL) {
+            *next++ = '\0';
+        }
+        if (errcheck_inject_parse(item, &rule) == NULL) {
+            (void)errcheck_inject_arm(&rule);
+        }
+        item = next;
+    }
+    if (getenv("ERRCHECK_INJECT_REPORT") != NULL) {
+        atexit(inject_write_report);
+    }
+}
+#endif
+
+#endif /* ERRCHECK_ENABLE_INJECT */
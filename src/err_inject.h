@@ -0,0 +1,92 @@
+/**
+ * =============================================================================
+ * err_inject.h
+ * Rule-based fault injection that can be re-armed while the service runs.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_INJECT (link err_inject.c)
+ * * Every CHECK()/GOTO_CHECK() consults a fixed table of ERRCHECK_INJECT_RULES
+ * rules after its call returns. A rule matches a code and/or a site and fires
+ * on a trigger:
+ *   ONCE    the first matching call
+ *   NTH     the n-th matching call only
+ *   EVERY   every n-th matching call
+ *   RATE    each matching call with probability param / 65536
+ * A firing rule adds 'latency_us' of delay (inside the call, so the watchdog
+ * sees it) and, if 'fail' is set, forces the check to fail.
+ * * Lock-free on the hot path: with no rule armed a guarded call pays one
+ * relaxed load and a branch. Rules are published through a per-rule sequence
+ * word, so arming and disarming from another thread (the control socket, see
+ * err_ctl.h) never blocks or tears a rule under a checking thread. Writers must
+ * not race each other (one control thread, or the application's own setup).
+ * * On POSIX hosts, rules in the environment variable ERRCHECK_INJECT (separated
+ * by ';', syntax of errcheck_inject_parse()) are armed at load time. If
+ * ERRCHECK_INJECT_REPORT names a file, the number of fired decisions is written
+ * there at exit (used by tools/errcheck_campaign). -D ERRCHECK_INJECT_NO_ENV
+ * compiles both out, for a second copy of this file in a process (the
+ * tools/errcheck_preload shim) that must neither arm the application's rules
+ * nor overwrite its report.
+ * * Independent of ERRCHECK_ENABLE_RUNTIME_INJECTION (g_inject_error_flag), which
+ * stays available for debugger use.
+ * =============================================================================
+ */
+
+#ifndef ERR_INJECT_H
+#define ERR_INJECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "errcheck.h"
+
+#ifndef ERRCHECK_INJECT_RULES
+    #define ERRCHECK_INJECT_RULES 16u
+#endif
+
+#define ERRCHECK_INJECT_ANY_CODE 0xFFFFFFFFu
+#define ERRCHECK_INJECT_ANY_SITE 0u
+
+typedef enum {
+    ERRCHECK_INJECT_ONCE = 0,
+    ERRCHECK_INJECT_NTH,
+    ERRCHECK_INJECT_EVERY,
+    ERRCHECK_INJECT_RATE
+} errcheck_inject_trigger_t;
+
+typedef struct {
+    uint32_t site;              // errcheck_site_id(file, line), or ERRCHECK_INJECT_ANY_SITE
+    uint32_t code;              // err_flag of the check, or ERRCHECK_INJECT_ANY_CODE
+    errcheck_inject_trigger_t trigger;
+    uint32_t param;             // NTH/EVERY: n (>= 1); RATE: probability x 65536
+    uint32_t latency_us;        // Delay added when the rule fires
+    bool fail;                  // Force the check to fail when the rule fires
+} errcheck_inject_rule_t;
+
+typedef struct {
+    errcheck_inject_rule_t rule;
+    uint32_t hits;              // Matching calls since the rule was armed
+    uint32_t fired;
+} errcheck_inject_status_t;
+
+#ifdef ERRCHECK_ENABLE_INJECT
+    // Number of armed rules; the hot path skips the table while it is 0
+    extern uint32_t g_errcheck_inject_armed;
+
+    // Returns the rule slot, or -1 if the table is full or the rule is invalid
+    int errcheck_inject_arm(const errcheck_inject_rule_t *rule);
+    bool errcheck_inject_disarm(int slot);
+    void errcheck_inject_disarm_all(void);
+    // False if the slot holds no armed rule
+    bool errcheck_inject_get(int slot, errcheck_inject_status_t *out);
+
+    // Parses "[code=N] [site=0xHEX | at=FILE:LINE] [once | nth=N | every=N |
+    // rate=A/B] [latency=US] [nofail]" (defaults: any code and site, once, fail).
+    // Modifies 'args'; returns NULL, or the reason the rule was rejected.
+    const char *errcheck_inject_parse(char *args, errcheck_inject_rule_t *rule);
+
+    // Seeds the calling thread's RATE draws, for runs that must repeat exactly
+    void errcheck_inject_seed(uint32_t seed);
+
+    // Called by CHECK()/GOTO_CHECK(); returns 'result', or 0 to force a failure
+    int errcheck_inject_eval(uint32_t code, const char *file, uint32_t line, int result);
+#endif
+
+#endif /* ERR_INJECT_H */
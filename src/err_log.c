@@ -12,6 +12,15 @@
  */
 
 #include "errcheck.h"
+#include "err_acct.h"
+#include "err_sketch.h"
+#include "err_anomaly.h"
+#include "err_watchdog.h"
+#include "err_inject.h"
+#include "err_alloc.h"
+#include "err_counters.h"
+#include "err_core.h"
+#include "err_history.h"
 #include <stdio.h>       
 #include <inttypes.h> // Needed for PRIu32 format specifier
 
@@ -49,6 +58,8 @@ void errcheck_print_last_error(void)
         return;
     }
 
+    ERRCHECK_ACCT_START(acct_t);
+
     printf("\r\n=== FATAL ERROR ===\r\n");
     
     // Line 1: Error Code and Human-Readable Name (via the user-supplied function)
@@ -68,4 +79,130 @@ void errcheck_print_last_error(void)
     printf("NVRAM Logged : %s\r\n", g_error_context.logged_to_nvram ? "YES" : "NO");
     
     printf("===================\r\n\r\n");
+    ERRCHECK_ACCT_LAP(acct_t, ERRCHECK_ACCT_FORMAT);
+}
+
+/**
+ * @brief Prints the library's own metrics (enabled optional modules only).
+ */
+void errcheck_print_metrics(void)
+{
+    ERRCHECK_ACCT_START(acct_t);
+
+    printf("\r\n=== ERRCHECK METRICS ===\r\n");
+
+#ifdef ERRCHECK_ENABLE_PER_CORE
+    for (uint32_t c = 0; c < ERRCHECK_CORES; c++) {
+        failure_context_t ctx;
+        errcheck_core_context_get(c, &ctx);
+        if (ctx.code == ERR_SUCCESS) {
+            printf("Core %-2" PRIu32 "      : no failure", c);
+        } else {
+            printf("Core %-2" PRIu32 "      : last %s at %s:%" PRIu32, c,
+                   app_error_to_string(ctx.code), ctx.file ? ctx.file : "N/A", ctx.line);
+        }
+#ifdef ERRCHECK_ENABLE_HISTORY
+        printf(", %" PRIu32 " record(s)",
+               __atomic_load_n(&g_errcheck_history_core[c].hdr.record_head, __ATOMIC_RELAXED));
+#endif
+        printf("\r\n");
+    }
+#endif
+
+#ifdef ERRCHECK_ENABLE_SELF_ACCOUNTING
+    // Snapshot first so this block's own formatting is not half-counted
+    errcheck_acct_t acct;
+    uint32_t threads = errcheck_acct_snapshot_all(&acct);
+    uint64_t total = 0;
+    for (int c = 0; c < ERRCHECK_ACCT_CATEGORIES; c++) {
+        total += acct.cycles[c];
+    }
+    printf("Self time    : %" PRIu64 " ticks over %" PRIu32 " thread(s)\r\n", total, threads);
+    for (int c = 0; c < ERRCHECK_ACCT_CATEGORIES; c++) {
+        printf("  %-10s : %12" PRIu64 " ticks %8" PRIu64 " calls %8" PRIu64 " ticks/call\r\n",
+               errcheck_acct_category_name((errcheck_acct_category_t)c),
+               acct.cycles[c], acct.calls[c],
+               acct.calls[c] != 0 ? acct.cycles[c] / acct.calls[c] : 0);
+    }
+#endif
+
+#ifdef ERRCHECK_ENABLE_SKETCH
+    errcheck_sketch_t sk;
+    errcheck_sketch_snapshot(&sk);
+    printf("Failures     : %" PRIu32 " summarised, %" PRIu32 " skipped (busy), "
+           "~%" PRIu32 " distinct inner codes\r\n",
+           sk.total, sk.skipped, errcheck_sketch_distinct_inner(&sk));
+    printf("Top sites    :");
+    for (uint32_t i = 0; i < ERRCHECK_SKETCH_TOPK && sk.sites[i].count != 0; i++) {
+        printf(" 0x%08" PRIX32 " x%" PRIu32 "(-%" PRIu32 ")",
+               sk.sites[i].key, sk.sites[i].count, sk.sites[i].error);
+    }
+    printf("\r\nTop inner    :");
+    for (uint32_t i = 0; i < ERRCHECK_SKETCH_TOPK && sk.inner[i].count != 0; i++) {
+        printf(" 0x%" PRIX32 " x%" PRIu32 "(-%" PRIu32 ")",
+               sk.inner[i].key, sk.inner[i].count, sk.inner[i].error);
+    }
+    printf("\r\n");
+#endif
+
+#ifdef ERRCHECK_ENABLE_ANOMALY
+    printf("Rates        : code  mean/tick  sigma  alarm>  alarms\r\n");
+    for (uint32_t c = 0; c < ERRCHECK_ANOMALY_CODES; c++) {
+        errcheck_anomaly_slot_t a;
+        errcheck_anomaly_get(c, &a);
+        if (a.mean_q16 == 0 && a.alarms == 0) {
+            continue;
+        }
+        // Q16.16 printed with two decimals
+        printf("               %4" PRIu32 " %7" PRIu32 ".%02" PRIu32 " %4" PRIu32 ".%02" PRIu32,
+               c, a.mean_q16 >> 16, ((a.mean_q16 & 0xFFFFu) * 100u) >> 16,
+               errcheck_anomaly_sigma_q16(&a) >> 16,
+               ((errcheck_anomaly_sigma_q16(&a) & 0xFFFFu) * 100u) >> 16);
+        if (a.fire_at != 0) {
+            printf(" %7" PRIu32, a.fire_at - 1u);
+        } else {
+            printf(" %7s", "warmup");
+        }
+        printf(" %7" PRIu32 "\r\n", a.alarms);
+    }
+#endif
+
+#ifdef ERRCHECK_ENABLE_INJECT
+    printf("Injection    : %" PRIu32 " rule(s) armed\r\n",
+           __atomic_load_n(&g_errcheck_inject_armed, __ATOMIC_RELAXED));
+    for (int i = 0; i < (int)ERRCHECK_INJECT_RULES; i++) {
+        errcheck_inject_status_t st;
+        if (errcheck_inject_get(i, &st)) {
+            printf("  rule %-2d    : code 0x%" PRIX32 " site 0x%08" PRIX32 " hits %" PRIu32
+                   " fired %" PRIu32 "\r\n", i, st.rule.code, st.rule.site, st.hits, st.fired);
+        }
+    }
+#endif
+
+#ifdef ERRCHECK_ENABLE_WATCHDOG
+    printf("Hangs        : %" PRIu32 " guarded call(s) exceeded the watchdog limit\r\n",
+           errcheck_watchdog_hangs());
+#endif
+
+#ifdef ERRCHECK_ENABLE_ALLOC
+    printf("Alloc fails  : %" PRIu32 " (%" PRIu32 " injected)\r\n",
+           errcheck_alloc_failures(), errcheck_alloc_injected());
+#endif
+
+#ifdef ERRCHECK_ENABLE_PERSIST_COUNTERS
+    errcheck_counters_stats_t cs;
+    errcheck_counters_get_stats(&cs);
+    printf("Lifetime     : %" PRIu32 " checkpoint(s), %" PRIu32 " B today, %" PRIu32
+           " deferred, %" PRIu32 " failed\r\n",
+           cs.checkpoints, cs.bytes_today, cs.deferred, cs.failed);
+    for (uint32_t c = 0; c < ERRCHECK_COUNTERS_CODES; c++) {
+        if (errcheck_counters_total(c) != 0) {
+            printf("  code %-4" PRIu32 "  : %10" PRIu32 " total %8" PRIu32 " this boot\r\n",
+                   c, errcheck_counters_total(c), errcheck_counters_since_boot(c));
+        }
+    }
+#endif
+
+    printf("========================\r\n\r\n");
+    ERRCHECK_ACCT_LAP(acct_t, ERRCHECK_ACCT_FORMAT);
 }
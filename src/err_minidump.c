@@ -0,0 +1,571 @@
+/**
+ * =============================================================================
+ * err_minidump.c
+ * Async-signal-safe minidump writer (Linux).
+ * =============================================================================
+ * NOTE: Everything here may run in a signal handler of a corrupted process.
+ * Buffers are static, syscalls are issued inline (x86-64, AArch64; other
+ * architectures go through libc's syscall()), and only the first thread to
+ * fail writes. Other failing threads wait up to five seconds for it and then
+ * take their signal's default action. Registers are copied from the
+ * ucontext's mcontext as an array of 64-bit words: gregs[] on x86-64, and
+ * regs[31], sp, pc, pstate on AArch64. Field names are not used, because they
+ * depend on the feature-test macros in effect.
+ * =============================================================================
+ */
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // sigaction(), ucontext_t under strict -std=c99
+#endif
+
+#include "err_minidump.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef ERRCHECK_ENABLE_MINIDUMP
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#ifdef ERRCHECK_ENABLE_HISTORY
+#include "err_history.h"
+#endif
+
+#if defined(__x86_64__)
+    #define MD_ARCH      62u
+    #define MD_REG_FIRST 0u     // mcontext_t starts with gregs[23]
+    #define MD_REG_COUNT 23u
+    #define MD_REG_SP    15u    // REG_RSP
+#elif defined(__aarch64__)
+    #define MD_ARCH      183u
+    #define MD_REG_FIRST 1u     // After fault_address
+    #define MD_REG_COUNT 34u
+    #define MD_REG_SP    31u
+#else
+    #define MD_ARCH      0u
+    #define MD_REG_COUNT 0u
+#endif
+
+#ifndef SA_ONSTACK
+    #define SA_ONSTACK   0x08000000 // XSI only in <signal.h>; this is its Linux value
+#endif
+#ifndef SS_DISABLE
+    #define SS_DISABLE   2          // Likewise
+#endif
+
+#define MD_PAGE      4096u
+#define MD_WAIT_MS   5000
+
+static int s_md_fd = -1;
+static int s_md_state = 0;              // 0 armed, 1 writing, 2 written
+
+static uint64_t s_md_regs[MD_REG_COUNT > 3u ? MD_REG_COUNT : 3u];
+static uint8_t s_md_stack[ERRCHECK_MINIDUMP_STACK_BYTES];
+static struct iovec s_md_remote[ERRCHECK_MINIDUMP_STACK_BYTES / MD_PAGE + 1u];
+static uint8_t s_md_scratch[4096];      // getdents64 and /proc/self/maps
+static char s_md_text[512];             // /proc/<tid>/stat and /proc/<tid>/syscall
+static errcheck_minidump_thread_t s_md_threads[ERRCHECK_MINIDUMP_THREADS];
+// One handler stack per thread that called errcheck_minidump_thread_init(); a
+// set bit in s_md_altstack_used marks a stack in use. The key's destructor
+// returns the stack when its thread exits.
+static uint8_t s_md_altstacks[ERRCHECK_MINIDUMP_ALTSTACKS][ERRCHECK_MINIDUMP_ALTSTACK_BYTES]
+    __attribute__((aligned(16)));
+static uint64_t s_md_altstack_used = 0;
+static pthread_key_t s_md_altstack_key;
+static pthread_once_t s_md_altstack_once = PTHREAD_ONCE_INIT;
+
+
+/* --- Raw syscalls: negative errno on failure --- */
+#if defined(__x86_64__)
+static long md_sys(long n, long a, long b, long c, long d, long e, long f)
+{
+    long ret;
+    register long r10 __asm__("r10") = d;
+    register long r8 __asm__("r8") = e;
+    register long r9 __asm__("r9") = f;
+
+    __asm__ volatile("syscall"
+                     : "=a"(ret)
+                     : "a"(n), "D"(a), "S"(b), "d"(c), "r"(r10), "r"(r8), "r"(r9)
+                     : "rcx", "r11", "memory");
+    return ret;
+}
+#elif defined(__aarch64__)
+static long md_sys(long n, long a, long b, long c, long d, long e, long f)
+{
+    register long x8 __asm__("x8") = n;
+    register long x0 __asm__("x0") = a;
+    register long x1 __asm__("x1") = b;
+    register long x2 __asm__("x2") = c;
+    register long x3 __asm__("x3") = d;
+    register long x4 __asm__("x4") = e;
+    register long x5 __asm__("x5") = f;
+
+    __asm__ volatile("svc 0"
+                     : "+r"(x0)
+                     : "r"(x8), "r"(x1), "r"(x2), "r"(x3), "r"(x4), "r"(x5)
+                     : "memory");
+    return x0;
+}
+#else
+extern long syscall(long number, ...);
+
+static long md_sys(long n, long a, long b, long c, long d, long e, long f)
+{
+    long ret = syscall(n, a, b, c, d, e, f);
+    return (ret == -1) ? -errno : ret;
+}
+#endif
+
+#define MD_SYS1(n, a)          md_sys((n), (long)(a), 0, 0, 0, 0, 0)
+#define MD_SYS3(n, a, b, c)    md_sys((n), (long)(a), (long)(b), (long)(c), 0, 0, 0)
+
+static uint64_t md_now(void)
+{
+    struct timespec ts;
+
+    if (md_sys(SYS_clock_gettime, CLOCK_MONOTONIC, (long)&ts, 0, 0, 0, 0) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int md_open(const char *path, int flags)
+{
+    return (int)md_sys(SYS_openat, AT_FDCWD, (long)path, flags | O_RDONLY | O_CLOEXEC, 0, 0, 0);
+}
+
+static bool md_write(const void *data, size_t len)
+{
+    const uint8_t *p = data;
+
+    while (len > 0) {
+        long n = MD_SYS3(SYS_write, s_md_fd, p, len);
+        if (n == -EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes one stream made of up to two parts, then pads it to 8 bytes.
+ */
+static bool md_stream(uint32_t type, const void *a, uint32_t na, const void *b, uint32_t nb)
+{
+    static const uint8_t zeros[8];
+    errcheck_minidump_stream_t s = { type, na + nb };
+
+    return md_write(&s, sizeof(s)) && md_write(a, na) && (nb == 0 || md_write(b, nb)) &&
+           md_write(zeros, (8u - ((na + nb) & 7u)) & 7u);
+}
+
+// Reads a small /proc file into s_md_text (NUL-terminated); returns its length
+static size_t md_read_text(const char *path)
+{
+    size_t len = 0;
+    int fd = md_open(path, 0);
+
+    if (fd < 0) {
+        return 0;
+    }
+    while (len < sizeof(s_md_text) - 1u) {
+        long n = MD_SYS3(SYS_read, fd, s_md_text + len, sizeof(s_md_text) - 1u - len);
+        if (n <= 0) {
+            break;
+        }
+        len += (size_t)n;
+    }
+    MD_SYS1(SYS_close, fd);
+    s_md_text[len] = '\0';
+    return len;
+}
+
+static uint64_t md_parse_hex(const char *s)
+{
+    uint64_t v = 0;
+
+    if (s[0] == '0' && s[1] == 'x') {
+        s += 2;
+    }
+    for (;; s++) {
+        uint32_t d;
+        if (*s >= '0' && *s <= '9') {
+            d = (uint32_t)(*s - '0');
+        } else if (*s >= 'a' && *s <= 'f') {
+            d = (uint32_t)(*s - 'a' + 10);
+        } else {
+            return v;
+        }
+        v = (v << 4) | d;
+    }
+}
+
+// Builds "/proc/self/task/<tid>/<leaf>" without stdio
+static void md_task_path(char *out, uint32_t tid, const char *leaf)
+{
+    static const char prefix[] = "/proc/self/task/";
+    char digits[10];
+    int n = 0;
+
+    memcpy(out, prefix, sizeof(prefix) - 1u);
+    out += sizeof(prefix) - 1u;
+    do {
+        digits[n++] = (char)('0' + tid % 10u);
+        tid /= 10u;
+    } while (tid != 0);
+    while (n > 0) {
+        *out++ = digits[--n];
+    }
+    *out++ = '/';
+    while (*leaf != '\0') {
+        *out++ = *leaf++;
+    }
+    *out = '\0';
+}
+
+/**
+ * @brief Name and state from /proc/<tid>/stat; sp and pc from /proc/<tid>/syscall
+ * when the thread is blocked (the file reads "running" otherwise).
+ */
+static void md_thread_info(errcheck_minidump_thread_t *t, uint32_t tid, uint32_t self)
+{
+    char path[48];
+
+    memset(t, 0, sizeof(*t));
+    t->tid = tid;
+    t->state = '?';
+
+    md_task_path(path, tid, "stat");
+    size_t len = md_read_text(path);
+    const char *open = memchr(s_md_text, '(', len);
+    const char *close = NULL;
+    for (size_t i = len; i > 0; i--) {
+        if (s_md_text[i - 1u] == ')') {
+            close = &s_md_text[i - 1u];
+            break;
+        }
+    }
+    if (open != NULL && close != NULL && close > open) {
+        size_t n = (size_t)(close - open - 1);
+        memcpy(t->name, open + 1, (n < sizeof(t->name) - 1u) ? n : sizeof(t->name) - 1u);
+        if (close + 2 < s_md_text + len) {
+            t->state = close[2];
+        }
+    }
+
+    if (tid == self) {
+        return; // Would show the dumper's own read(); the registers stream has the real state
+    }
+    md_task_path(path, tid, "syscall");
+    len = md_read_text(path);
+    if (len == 0 || !((s_md_text[0] >= '0' && s_md_text[0] <= '9') || s_md_text[0] == '-')) {
+        return;
+    }
+    // "nr args... sp pc": the last two fields
+    const char *field[2] = { NULL, NULL };
+    for (size_t i = 0; i < len; i++) {
+        if (s_md_text[i] == ' ') {
+            field[0] = field[1];
+            field[1] = &s_md_text[i + 1u];
+        }
+    }
+    if (field[0] != NULL) {
+        t->sp = md_parse_hex(field[0]);
+        t->pc = md_parse_hex(field[1]);
+        t->blocked = 1;
+    }
+}
+
+static uint32_t md_collect_threads(uint32_t self, uint32_t *flags)
+{
+    uint32_t n = 0;
+    int dir = md_open("/proc/self/task", O_DIRECTORY);
+
+    if (dir < 0) {
+        return 0;
+    }
+    for (;;) {
+        long got = MD_SYS3(SYS_getdents64, dir, s_md_scratch, sizeof(s_md_scratch));
+        if (got <= 0) {
+            break;
+        }
+        // struct linux_dirent64: ino (8), off (8), reclen (2), type (1), name
+        for (long off = 0; off < got; ) {
+            const uint8_t *d = &s_md_scratch[off];
+            const char *name = (const char *)d + 19;
+            uint16_t reclen;
+            memcpy(&reclen, d + 16, sizeof(reclen));
+            off += reclen;
+            if (name[0] < '0' || name[0] > '9') {
+                continue;
+            }
+            if (n == ERRCHECK_MINIDUMP_THREADS) {
+                *flags |= ERRCHECK_MD_TRUNC_THREADS;
+                continue;
+            }
+            uint32_t tid = 0;
+            for (const char *p = name; *p >= '0' && *p <= '9'; p++) {
+                tid = tid * 10u + (uint32_t)(*p - '0');
+            }
+            md_thread_info(&s_md_threads[n++], tid, self);
+        }
+    }
+    MD_SYS1(SYS_close, dir);
+    return n;
+}
+
+/**
+ * @brief Copies the stack upwards from 'base', page by page, until an unmapped page.
+ */
+static uint32_t md_read_stack(uint64_t base, long pid)
+{
+    uint64_t addr = base;
+    uint32_t left = ERRCHECK_MINIDUMP_STACK_BYTES;
+    uint32_t count = 0;
+
+    while (left > 0) {
+        uint32_t chunk = MD_PAGE - (uint32_t)(addr & (MD_PAGE - 1u));
+        chunk = (chunk < left) ? chunk : left;
+        s_md_remote[count].iov_base = (void *)(uintptr_t)addr;
+        s_md_remote[count].iov_len = chunk;
+        count++;
+        addr += chunk;
+        left -= chunk;
+    }
+    struct iovec local = { s_md_stack, sizeof(s_md_stack) };
+    long got = md_sys(SYS_process_vm_readv, pid, (long)&local, 1, (long)s_md_remote, count, 0);
+    return (got > 0) ? (uint32_t)got : 0u;
+}
+
+static bool md_copy_maps(uint32_t *flags)
+{
+    uint32_t total = 0;
+    bool ok = true;
+    int fd = md_open("/proc/self/maps", 0);
+
+    if (fd < 0) {
+        return true;
+    }
+    while (ok && total < ERRCHECK_MINIDUMP_MAPS_BYTES) {
+        uint32_t want = ERRCHECK_MINIDUMP_MAPS_BYTES - total;
+        want = (want < sizeof(s_md_scratch)) ? want : (uint32_t)sizeof(s_md_scratch);
+        long n = MD_SYS3(SYS_read, fd, s_md_scratch, want);
+        if (n <= 0) {
+            break;
+        }
+        ok = md_stream(ERRCHECK_MD_MAPS, s_md_scratch, (uint32_t)n, NULL, 0);
+        total += (uint32_t)n;
+    }
+    if (total >= ERRCHECK_MINIDUMP_MAPS_BYTES) {
+        *flags |= ERRCHECK_MD_TRUNC_MAPS;
+    }
+    MD_SYS1(SYS_close, fd);
+    return ok;
+}
+
+// Only one thread writes; the others give it time to finish
+static bool md_claim(void)
+{
+    int expected = 0;
+
+    if (s_md_fd >= 0 && __atomic_compare_exchange_n(&s_md_state, &expected, 1, false,
+                                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        return true;
+    }
+    for (int i = 0; i < MD_WAIT_MS && __atomic_load_n(&s_md_state, __ATOMIC_ACQUIRE) == 1; i++) {
+        struct timespec ms = { 0, 1000000 };
+        MD_SYS3(SYS_nanosleep, &ms, NULL, 0);
+    }
+    return false;
+}
+
+static void md_dump(int sig, int si_code, uint64_t fault_addr, uint32_t reg_count,
+                    uint32_t reg_flags, uint64_t sp)
+{
+    uint64_t t0 = md_now();
+    long pid = MD_SYS1(SYS_getpid, 0);
+    errcheck_minidump_end_t end = { 0, 0, 0 };
+    errcheck_minidump_header_t hdr = {
+        .magic = ERRCHECK_MINIDUMP_MAGIC,
+        .version = ERRCHECK_MINIDUMP_VERSION,
+        .arch = MD_ARCH,
+        .pid = (uint32_t)pid,
+        .tid = (uint32_t)MD_SYS1(SYS_gettid, 0),
+        .signal = sig,
+        .si_code = si_code,
+        .fault_addr = fault_addr,
+        .timestamp_ns = t0,
+    };
+    errcheck_minidump_context_t ctx;
+    errcheck_minidump_regs_t regs = { reg_count, reg_flags };
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.code = (uint32_t)g_error_context.code;
+    ctx.inner_code = g_error_context.inner_code;
+    ctx.line = g_error_context.line;
+    ctx.logged = g_error_context.logged_to_nvram ? 1u : 0u;
+    for (size_t i = 0; g_error_context.file != NULL && i < sizeof(ctx.file) - 1u &&
+                       g_error_context.file[i] != '\0'; i++) {
+        ctx.file[i] = g_error_context.file[i];
+    }
+
+    bool ok = md_write(&hdr, sizeof(hdr)) &&
+              md_stream(ERRCHECK_MD_CONTEXT, &ctx, sizeof(ctx), NULL, 0) &&
+              md_stream(ERRCHECK_MD_REGISTERS, &regs, sizeof(regs), s_md_regs,
+                        reg_count * (uint32_t)sizeof(uint64_t));
+
+    uint64_t base = sp & ~(uint64_t)15u;
+    uint32_t stack = (ok && sp != 0) ? md_read_stack(base, pid) : 0u;
+    if (stack == 0) {
+        end.flags |= ERRCHECK_MD_NO_STACK;
+    } else {
+        ok = md_stream(ERRCHECK_MD_STACK, &base, sizeof(base), s_md_stack, stack);
+    }
+
+    uint32_t threads = ok ? md_collect_threads(hdr.tid, &end.flags) : 0u;
+    ok = ok && md_stream(ERRCHECK_MD_THREADS, s_md_threads,
+                         threads * (uint32_t)sizeof(s_md_threads[0]), NULL, 0);
+#ifdef ERRCHECK_ENABLE_HISTORY
+    ok = ok && md_stream(ERRCHECK_MD_HISTORY, g_errcheck_history,
+                         (uint32_t)sizeof(*g_errcheck_history), NULL, 0);
+#endif
+    ok = ok && md_copy_maps(&end.flags);
+
+    end.duration_ns = md_now() - t0;
+    if (ok) {
+        (void)md_stream(ERRCHECK_MD_END, &end, sizeof(end), NULL, 0);
+    }
+    __atomic_store_n(&s_md_state, 2, __ATOMIC_RELEASE);
+}
+
+void errcheck_minidump_write(int sig, const void *info, const void *ucontext)
+{
+    const siginfo_t *si = info;
+    uint32_t count = 0;
+    uint64_t sp = 0;
+
+    if (!md_claim()) {
+        return;
+    }
+#if MD_REG_COUNT > 0
+    if (ucontext != NULL) {
+        const uint64_t *mc = (const uint64_t *)(const void *)&((const ucontext_t *)ucontext)->uc_mcontext;
+        memcpy(s_md_regs, mc + MD_REG_FIRST, sizeof(uint64_t) * MD_REG_COUNT);
+        count = MD_REG_COUNT;
+        sp = s_md_regs[MD_REG_SP];
+    }
+#else
+    (void)ucontext;
+#endif
+    md_dump(sig, (si != NULL) ? si->si_code : 0,
+            (si != NULL) ? (uint64_t)(uintptr_t)si->si_addr : 0u, count, 0u, sp);
+}
+
+void errcheck_minidump_fatal(void)
+{
+    volatile uint8_t here = 0;
+
+    if (!md_claim()) {
+        return;
+    }
+    s_md_regs[0] = (uint64_t)(uintptr_t)__builtin_return_address(0);
+    s_md_regs[1] = (uint64_t)(uintptr_t)&here;
+    s_md_regs[2] = (uint64_t)(uintptr_t)__builtin_frame_address(0);
+    md_dump(0, 0, 0, 3u, ERRCHECK_MD_REGS_PARTIAL, s_md_regs[1]);
+}
+
+static void md_on_signal(int sig, siginfo_t *info, void *ucontext)
+{
+    struct sigaction dfl;
+
+    errcheck_minidump_write(sig, info, ucontext);
+
+    // Re-raise with the default action; it is delivered as soon as the handler returns
+    memset(&dfl, 0, sizeof(dfl));
+    dfl.sa_handler = SIG_DFL;
+    sigemptyset(&dfl.sa_mask);
+    sigaction(sig, &dfl, NULL);
+    MD_SYS3(SYS_tgkill, MD_SYS1(SYS_getpid, 0), MD_SYS1(SYS_gettid, 0), sig);
+}
+
+static void md_altstack_release(void *stack)
+{
+    stack_t ss;
+    size_t i = (size_t)((uint8_t *)stack - &s_md_altstacks[0][0]) / ERRCHECK_MINIDUMP_ALTSTACK_BYTES;
+
+    memset(&ss, 0, sizeof(ss));
+    ss.ss_flags = SS_DISABLE;
+    (void)MD_SYS3(SYS_sigaltstack, &ss, NULL, 0);
+    __atomic_fetch_and(&s_md_altstack_used, ~(1ull << i), __ATOMIC_RELEASE);
+}
+
+static void md_altstack_key_create(void)
+{
+    (void)pthread_key_create(&s_md_altstack_key, md_altstack_release);
+}
+
+/**
+ * @brief Gives the calling thread its own alternate signal stack from the pool.
+ */
+int errcheck_minidump_thread_init(void)
+{
+    stack_t ss;
+
+    (void)pthread_once(&s_md_altstack_once, md_altstack_key_create);
+    if (pthread_getspecific(s_md_altstack_key) != NULL) {
+        return 0;   // Already has one
+    }
+    for (uint32_t i = 0; i < ERRCHECK_MINIDUMP_ALTSTACKS; i++) {
+        uint64_t bit = 1ull << i;
+        if ((__atomic_fetch_or(&s_md_altstack_used, bit, __ATOMIC_ACQUIRE) & bit) != 0) {
+            continue;
+        }
+        ss.ss_sp = s_md_altstacks[i];
+        ss.ss_size = sizeof(s_md_altstacks[i]);
+        ss.ss_flags = 0;
+        if (MD_SYS3(SYS_sigaltstack, &ss, NULL, 0) != 0
+            || pthread_setspecific(s_md_altstack_key, s_md_altstacks[i]) != 0) {
+            md_altstack_release(s_md_altstacks[i]);
+            return -1;
+        }
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * @brief Hooks the fatal signals; dumps go to the already open 'fd'.
+ */
+int errcheck_minidump_install(int fd)
+{
+    static const int signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT, SIGTRAP };
+    struct sigaction sa;
+
+    if (fd < 0 || errcheck_minidump_thread_init() != 0) {
+        return -1;
+    }
+    s_md_fd = fd;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = md_on_signal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) {
+        if (sigaction(signals[i], &sa, NULL) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#endif /* ERRCHECK_ENABLE_MINIDUMP */
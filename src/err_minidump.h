@@ -0,0 +1,152 @@
+/**
+ * =============================================================================
+ * err_minidump.h
+ * Minidump writer for fatal failures on Linux hosts.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_MINIDUMP (link err_minidump.c; Linux only)
+ * * A record says where a failure happened. A minidump also says what the
+ * process looked like at that moment:
+ *   - the registers of the failing thread,
+ *   - its stack memory,
+ *   - every thread with its name, state and, if it is blocked, its SP and PC,
+ *   - the memory map,
+ *   - g_error_context,
+ *   - the history region (records, breadcrumbs and attachments) when
+ *     ERRCHECK_ENABLE_HISTORY is on.
+ * errcheck_minidump_install() takes a file descriptor opened at startup and
+ * hooks the fatal signals. The writer runs inside the signal handler, so it
+ * uses no heap, no stdio and no locks. It touches only static buffers and
+ * issues the syscalls itself. Stack memory is read with process_vm_readv(),
+ * so an unmapped page ends the copy instead of faulting again.
+ * * Work is bounded by ERRCHECK_MINIDUMP_THREADS, ERRCHECK_MINIDUMP_STACK_BYTES
+ * and ERRCHECK_MINIDUMP_MAPS_BYTES. The writer stores its own duration in the
+ * dump. tools/errcheck_minidump prints everything, including that duration.
+ * * A stack overflow can only be dumped from a thread that has its own
+ * alternate signal stack. errcheck_minidump_install() gives one to the calling
+ * thread; every other thread calls errcheck_minidump_thread_init() when it
+ * starts. The stacks come from a static pool of ERRCHECK_MINIDUMP_ALTSTACKS and
+ * return to it when their thread exits. A thread without one still gets a
+ * dump for any other fault.
+ * * File layout (host byte order): errcheck_minidump_header_t, then streams.
+ * Each stream is an errcheck_minidump_stream_t followed by 'size' bytes,
+ * padded to 8. ERRCHECK_MD_END closes a complete dump.
+ * =============================================================================
+ */
+
+#ifndef ERR_MINIDUMP_H
+#define ERR_MINIDUMP_H
+
+#include <stdint.h>
+#include "errcheck.h"
+
+/* --- Configuration --- */
+#ifndef ERRCHECK_MINIDUMP_STACK_BYTES
+    #define ERRCHECK_MINIDUMP_STACK_BYTES    16384u   // Copied upwards from the failing SP
+#endif
+#ifndef ERRCHECK_MINIDUMP_THREADS
+    #define ERRCHECK_MINIDUMP_THREADS        64u
+#endif
+#ifndef ERRCHECK_MINIDUMP_MAPS_BYTES
+    #define ERRCHECK_MINIDUMP_MAPS_BYTES     65536u   // /proc/self/maps is cut here
+#endif
+#ifndef ERRCHECK_MINIDUMP_ALTSTACK_BYTES
+    #define ERRCHECK_MINIDUMP_ALTSTACK_BYTES 32768u   // Handler stack (survives stack overflow)
+#endif
+#ifndef ERRCHECK_MINIDUMP_ALTSTACKS
+    #define ERRCHECK_MINIDUMP_ALTSTACKS      16u      // Threads with a handler stack at once
+#endif
+#if ERRCHECK_MINIDUMP_ALTSTACKS < 1u || ERRCHECK_MINIDUMP_ALTSTACKS > 64u
+    #error "ERRCHECK_MINIDUMP_ALTSTACKS must be 1..64"
+#endif
+
+#define ERRCHECK_MINIDUMP_MAGIC   0x444D4345u         // "ECMD" little-endian
+#define ERRCHECK_MINIDUMP_VERSION 1u
+
+typedef enum {
+    ERRCHECK_MD_CONTEXT = 1,    // errcheck_minidump_context_t
+    ERRCHECK_MD_REGISTERS,      // errcheck_minidump_regs_t, then 'count' uint64_t
+    ERRCHECK_MD_STACK,          // uint64_t start address, then the bytes
+    ERRCHECK_MD_THREADS,        // errcheck_minidump_thread_t[]
+    ERRCHECK_MD_HISTORY,        // Raw history region (see err_history.h)
+    ERRCHECK_MD_MAPS,           // /proc/self/maps text; consecutive streams concatenate
+    ERRCHECK_MD_END             // errcheck_minidump_end_t
+} errcheck_minidump_type_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t arch;              // ELF e_machine of the writer: 62 x86-64, 183 AArch64
+    uint32_t pid;
+    uint32_t tid;               // Failing thread
+    int32_t signal;             // 0 if written by errcheck_minidump_fatal()
+    int32_t si_code;
+    uint64_t fault_addr;
+    uint64_t timestamp_ns;      // CLOCK_MONOTONIC, the clock of history timestamps
+} errcheck_minidump_header_t;
+
+typedef struct {
+    uint32_t type;              // errcheck_minidump_type_t
+    uint32_t size;              // Payload bytes, without the padding
+} errcheck_minidump_stream_t;
+
+typedef struct {
+    uint32_t code;
+    uint32_t inner_code;
+    uint32_t line;
+    uint32_t logged;
+    char file[96];
+} errcheck_minidump_context_t;
+
+#define ERRCHECK_MD_REGS_PARTIAL 0x0001u  // Only pc, sp, fp (no signal context)
+
+typedef struct {
+    uint32_t count;             // Registers in the kernel's sigcontext order, see the tool
+    uint32_t flags;             // ERRCHECK_MD_REGS_* bits
+} errcheck_minidump_regs_t;
+
+typedef struct {
+    uint32_t tid;
+    char state;                 // R, S, D, T, ... from /proc/<tid>/stat
+    uint8_t blocked;            // 1 if sp/pc were read from /proc/<tid>/syscall
+    uint16_t reserved;
+    uint64_t sp;
+    uint64_t pc;
+    char name[16];
+} errcheck_minidump_thread_t;
+
+#define ERRCHECK_MD_TRUNC_THREADS 0x0001u // More threads than ERRCHECK_MINIDUMP_THREADS
+#define ERRCHECK_MD_TRUNC_MAPS    0x0002u // Memory map longer than ERRCHECK_MINIDUMP_MAPS_BYTES
+#define ERRCHECK_MD_NO_STACK      0x0004u // Stack could not be read
+
+typedef struct {
+    uint64_t duration_ns;       // Writer entry to this stream
+    uint32_t flags;             // ERRCHECK_MD_TRUNC_* / _NO_STACK bits
+    uint32_t reserved;
+} errcheck_minidump_end_t;
+
+#ifdef ERRCHECK_ENABLE_MINIDUMP
+    #ifndef __linux__
+        #error "ERRCHECK_ENABLE_MINIDUMP is only available on Linux"
+    #endif
+
+    // Writes dumps to 'fd' (opened by the caller, kept open) and hooks SIGSEGV,
+    // SIGBUS, SIGILL, SIGFPE, SIGABRT and SIGTRAP. The calling thread gets an
+    // alternate signal stack. After the dump, the signal's default action runs.
+    // Returns 0 on success.
+    int errcheck_minidump_install(int fd);
+
+    // Gives the calling thread its own alternate signal stack from the pool, so
+    // a stack overflow in it is dumped too. Call at the start of every thread
+    // other than the installing one. Returns 0, or -1 if the pool is exhausted.
+    int errcheck_minidump_thread_init(void);
+
+    // For the application's own fatal path: writes a dump of the calling thread
+    // (registers limited to pc, sp and fp) and returns. Follow with abort() or a
+    // reset. Only the first dump of a process is written.
+    void errcheck_minidump_fatal(void);
+
+    // Entry point for an existing SA_SIGINFO handler ('info' and 'ucontext' as received)
+    void errcheck_minidump_write(int sig, const void *info, const void *ucontext);
+#endif
+
+#endif /* ERR_MINIDUMP_H */
@@ -0,0 +1,220 @@
+/**
+ * =============================================================================
+ * err_retained.c
+ * Retained-RAM failure ring: warm-reset survival and lazy flash migration.
+ * =============================================================================
+ * NOTE: Only the slot array lives in .noinit. The write cursor is ordinary .bss
+ * and is rebuilt from the slot sequence numbers by errcheck_retained_boot().
+ * =============================================================================
+ */
+
+#if defined(ERRCHECK_RETAINED_HOST_EMULATION) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // mmap(), ftruncate(), O_CLOEXEC under strict -std=c99
+#endif
+
+#include "err_retained.h"
+#include "err_crc32c.h"
+#include <string.h>
+
+#ifdef ERRCHECK_RETAINED_HOST_EMULATION
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static errcheck_retained_slot_t *s_slots = NULL; // Set by errcheck_retained_host_attach()
+#else
+static errcheck_retained_slot_t s_noinit_slots[ERRCHECK_RETAINED_DEPTH] ERRCHECK_NOINIT;
+static errcheck_retained_slot_t *const s_slots = s_noinit_slots;
+#endif
+
+// Next sequence number to hand out (0 until errcheck_retained_boot() has run)
+static uint32_t s_next_seq = 0;
+
+
+static uint32_t slot_crc(const errcheck_retained_slot_t *slot)
+{
+    uint32_t crc = errcheck_crc32c(0, &slot->seq, sizeof(slot->seq));
+    return errcheck_crc32c(crc, &slot->rec, sizeof(slot->rec));
+}
+
+/**
+ * @brief Magic + CRC check of a sealed slot image (RAM, flash copy or dump file).
+ */
+bool errcheck_retained_slot_valid(const errcheck_retained_slot_t *slot)
+{
+    return (slot->magic == ERRCHECK_RETAINED_PENDING ||
+            slot->magic == ERRCHECK_RETAINED_MIGRATED) &&
+           slot->seq != 0 && slot->crc == slot_crc(slot);
+}
+
+/**
+ * @brief Validates every slot after a reset and rebuilds the write cursor.
+ * * Slots failing the magic/CRC check (cold-boot garbage, or a record torn by the
+ * reset) are cleared so they cannot be mistaken for data later.
+ */
+uint32_t errcheck_retained_boot(void)
+{
+    uint32_t valid = 0;
+    uint32_t max_seq = 0;
+
+    if (s_slots == NULL) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < ERRCHECK_RETAINED_DEPTH; i++) {
+        if (errcheck_retained_slot_valid(&s_slots[i])) {
+            valid++;
+            if (s_slots[i].seq > max_seq) {
+                max_seq = s_slots[i].seq;
+            }
+        } else {
+            memset(&s_slots[i], 0, sizeof(s_slots[i]));
+        }
+    }
+    s_next_seq = max_seq + 1u;
+    return valid;
+}
+
+/**
+ * @brief Parks a failure record in retained RAM (no flash access).
+ */
+void errcheck_retained_push(const errcheck_record_t *rec)
+{
+    if (s_slots == NULL || s_next_seq == 0) {
+        return; // errcheck_retained_boot() has not run: the slot contents are unknown
+    }
+
+    uint32_t seq = __atomic_fetch_add(&s_next_seq, 1u, __ATOMIC_RELAXED);
+    if (seq == 0) {
+        seq = __atomic_fetch_add(&s_next_seq, 1u, __ATOMIC_RELAXED); // Skip 0 on wrap
+    }
+    errcheck_retained_slot_t *slot = &s_slots[seq % ERRCHECK_RETAINED_DEPTH];
+
+    // A reset anywhere before the final magic store leaves an invalid slot
+    __atomic_store_n(&slot->magic, 0u, __ATOMIC_RELAXED);
+    slot->seq = seq;
+    slot->rec = *rec;
+    slot->rec.seq = seq;
+    slot->crc = slot_crc(slot);
+    slot->reserved = 0;
+    __atomic_store_n(&slot->magic, ERRCHECK_RETAINED_PENDING, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Idle-time migration: writes the oldest pending record to flash.
+ * * Bounded work per call (one flash write) so it can run from an idle hook.
+ */
+bool errcheck_retained_idle(void)
+{
+    errcheck_retained_slot_t copy;
+    int oldest = -1;
+
+    if (s_slots == NULL) {
+        return false;
+    }
+    for (uint32_t i = 0; i < ERRCHECK_RETAINED_DEPTH; i++) {
+        if (s_slots[i].magic == ERRCHECK_RETAINED_PENDING &&
+            (oldest < 0 || s_slots[i].seq < s_slots[oldest].seq)) {
+            oldest = (int)i;
+        }
+    }
+    if (oldest < 0) {
+        return false;
+    }
+
+    // Work on a copy: the failure path may recycle the slot while flash is busy
+    errcheck_retained_slot_t *slot = &s_slots[oldest];
+    memcpy(&copy, slot, sizeof(copy));
+    if (!errcheck_retained_slot_valid(&copy) || copy.magic != ERRCHECK_RETAINED_PENDING) {
+        return false;
+    }
+    if (!errcheck_nvram_write_record(&copy)) {
+        return false;
+    }
+
+    uint32_t expected = ERRCHECK_RETAINED_PENDING;
+    if (slot->seq == copy.seq) {
+        __atomic_compare_exchange_n(&slot->magic, &expected, ERRCHECK_RETAINED_MIGRATED,
+                                    false, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+    return true;
+}
+
+uint32_t errcheck_retained_pending(void)
+{
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; s_slots != NULL && i < ERRCHECK_RETAINED_DEPTH; i++) {
+        if (s_slots[i].magic == ERRCHECK_RETAINED_PENDING) {
+            n++;
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Copies the valid retained records, oldest first.
+ */
+uint32_t errcheck_retained_read(errcheck_record_t *out, uint32_t max)
+{
+    errcheck_record_t found[ERRCHECK_RETAINED_DEPTH];
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; s_slots != NULL && i < ERRCHECK_RETAINED_DEPTH; i++) {
+        errcheck_retained_slot_t copy;
+        memcpy(&copy, &s_slots[i], sizeof(copy));
+        if (!errcheck_retained_slot_valid(&copy)) {
+            continue;
+        }
+        // Insertion sort by sequence; the ring is only a handful of slots deep
+        uint32_t j = n++;
+        while (j > 0 && found[j - 1].seq > copy.rec.seq) {
+            found[j] = found[j - 1];
+            j--;
+        }
+        found[j] = copy.rec;
+    }
+    if (n > max) {
+        n = max;
+    }
+    memcpy(out, found, n * sizeof(out[0]));
+    return n;
+}
+
+
+#ifdef ERRCHECK_RETAINED_HOST_EMULATION
+
+/**
+ * @brief Maps the emulated retained section from a file.
+ */
+int errcheck_retained_host_attach(const char *path)
+{
+    const size_t size = sizeof(errcheck_retained_slot_t) * ERRCHECK_RETAINED_DEPTH;
+    struct stat st;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    bool power_on = ((size_t)st.st_size != size);
+    if (power_on && ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return -1;
+    }
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        return -1;
+    }
+    if (power_on) {
+        memset(p, 0xA5, size); // Emulate undefined RAM contents after power-on
+    }
+    s_slots = (errcheck_retained_slot_t *)p;
+    return 0;
+}
+
+#endif /* ERRCHECK_RETAINED_HOST_EMULATION */
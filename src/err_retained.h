@@ -0,0 +1,76 @@
+/**
+ * =============================================================================
+ * err_retained.h
+ * Retained-RAM (.noinit) failure ring surviving warm resets.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_RETAINED_RING
+ *              (link err_retained.c, err_history.c and err_crc32c.c)
+ * Host test:   -D ERRCHECK_RETAINED_HOST_EMULATION (POSIX hosts only)
+ * * errcheck_log_to_nvram() parks the record in a RAM section the startup code
+ * does not clear, instead of writing flash on the failure path. Every slot carries
+ * a magic, a sequence number and a CRC, so after a reset errcheck_retained_boot()
+ * can tell valid records from cold-boot garbage or a slot torn by the reset.
+ * errcheck_retained_idle() then migrates pending records to flash one at a time.
+ * * LINKER REQUIREMENT (target builds): the '.noinit' output section must be
+ * NOLOAD and excluded from the .bss zeroing loop, e.g.
+ *     .noinit (NOLOAD) : { *(.noinit*) } > RAM
+ * =============================================================================
+ */
+
+#ifndef ERR_RETAINED_H
+#define ERR_RETAINED_H
+
+#include "errcheck.h"
+#include "err_history.h"
+
+/* --- Configuration --- */
+#ifndef ERRCHECK_RETAINED_DEPTH
+    #define ERRCHECK_RETAINED_DEPTH 8u
+#endif
+#ifndef ERRCHECK_NOINIT
+    #define ERRCHECK_NOINIT __attribute__((section(".noinit")))
+#endif
+
+#define ERRCHECK_RETAINED_PENDING  0x444E4550u   // "PEND": not yet in flash
+#define ERRCHECK_RETAINED_MIGRATED 0x5447494Du   // "MIGT": copied to flash, kept as history
+
+/* --- One retained slot; 'crc' is CRC-32C over 'seq' followed by 'rec' --- */
+typedef struct {
+    uint32_t magic;             // ERRCHECK_RETAINED_PENDING / _MIGRATED, anything else is empty
+    uint32_t seq;               // Monotonic across warm resets, never 0 for a valid slot
+    errcheck_record_t rec;
+    uint32_t crc;
+    uint32_t reserved;
+} errcheck_retained_slot_t;
+
+/**
+ * @brief REQUIRED (user): persist one sealed record to flash/EEPROM.
+ * * Called only from errcheck_retained_idle(). Store the slot image as-is so the
+ * record stays verifiable with its CRC (see tools/errcheck_verify.c). Return true
+ * once the write is confirmed; the slot is retried on the next idle call otherwise.
+ */
+extern bool errcheck_nvram_write_record(const errcheck_retained_slot_t *slot);
+
+/* Function prototypes */
+// Validates the ring after any reset; returns the number of records recovered.
+// MUST run before the first failure can be logged.
+uint32_t errcheck_retained_boot(void);
+// Parks a record in retained RAM (failure path; no flash access).
+void errcheck_retained_push(const errcheck_record_t *rec);
+// Migrates at most one pending record to flash; returns true if one was written.
+bool errcheck_retained_idle(void);
+// Number of records still waiting for migration.
+uint32_t errcheck_retained_pending(void);
+// Copies valid records (pending and migrated) oldest first; returns the count copied.
+uint32_t errcheck_retained_read(errcheck_record_t *out, uint32_t max);
+// Checks magic and CRC of a sealed slot image (retained RAM, flash or a dump file).
+bool errcheck_retained_slot_valid(const errcheck_retained_slot_t *slot);
+
+#ifdef ERRCHECK_RETAINED_HOST_EMULATION
+    // Backs the ring with a MAP_SHARED file instead of .noinit so a warm reset can be
+    // emulated by restarting the process. A newly created file is filled with a
+    // garbage pattern, like RAM after power-on. Call before errcheck_retained_boot().
+    int errcheck_retained_host_attach(const char *path);
+#endif
+
+#endif /* ERR_RETAINED_H */
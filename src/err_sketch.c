@@ -0,0 +1,131 @@
+/**
+ * =============================================================================
+ * err_sketch.c
+ * Space-Saving heavy hitters and HyperLogLog distinct count.
+ * =============================================================================
+ * NOTE: The update is a single pass over ERRCHECK_SKETCH_TOPK counters per
+ * summary plus one register store: bounded, branch-light and float-free. The
+ * HyperLogLog estimate is computed in fixed point only when it is read.
+ * =============================================================================
+ */
+
+#include "err_sketch.h"
+#include <string.h>
+
+#ifdef ERRCHECK_ENABLE_SKETCH
+
+static errcheck_sketch_t s_sketch;
+static uint8_t s_sketch_busy = 0;
+
+// 64 * ln(64 / V) for V = 1..64 empty registers (linear counting)
+static const uint16_t s_linear_count[ERRCHECK_SKETCH_HLL_REGS] = {
+    266, 222, 196, 177, 163, 151, 142, 133, 126, 119, 113, 107, 102, 97, 93, 89,
+    85, 81, 78, 74, 71, 68, 65, 63, 60, 58, 55, 53, 51, 48, 46, 44,
+    42, 40, 39, 37, 35, 33, 32, 30, 28, 27, 25, 24, 23, 21, 20, 18,
+    17, 16, 15, 13, 12, 11, 10, 9, 7, 6, 5, 4, 3, 2, 1, 0,
+};
+
+static void space_saving_add(errcheck_sketch_entry_t *e, uint32_t key)
+{
+    uint32_t min = 0;
+
+    for (uint32_t i = 0; i < ERRCHECK_SKETCH_TOPK; i++) {
+        if (e[i].count != 0 && e[i].key == key) {
+            e[i].count++;
+            return;
+        }
+        if (e[i].count < e[min].count) {
+            min = i;
+        }
+    }
+    // Not tracked: take over the smallest counter (an unused one counts as 0)
+    e[min].key = key;
+    e[min].error = e[min].count;
+    e[min].count++;
+}
+
+// Murmur3 finaliser: inner codes are often small and sequential
+static uint32_t sketch_mix(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+void errcheck_sketch_update(uint32_t site, uint32_t inner_code)
+{
+    if (__atomic_test_and_set(&s_sketch_busy, __ATOMIC_ACQUIRE)) {
+        __atomic_fetch_add(&s_sketch.skipped, 1u, __ATOMIC_RELAXED);
+        return;
+    }
+
+    s_sketch.total++;
+    space_saving_add(s_sketch.sites, site);
+    space_saving_add(s_sketch.inner, inner_code);
+
+    uint32_t h = sketch_mix(inner_code);
+    uint32_t reg = h >> 26;                                  // Top 6 bits pick the register
+    uint8_t rank = (uint8_t)(__builtin_clz((h << 6) | (1u << 5)) + 1); // 1..27
+    if (rank > s_sketch.hll[reg]) {
+        s_sketch.hll[reg] = rank;
+    }
+
+    __atomic_clear(&s_sketch_busy, __ATOMIC_RELEASE);
+}
+
+static void sort_entries(errcheck_sketch_entry_t *e)
+{
+    for (uint32_t i = 1; i < ERRCHECK_SKETCH_TOPK; i++) {
+        errcheck_sketch_entry_t t = e[i];
+        uint32_t j = i;
+        while (j > 0 && e[j - 1].count < t.count) {
+            e[j] = e[j - 1];
+            j--;
+        }
+        e[j] = t;
+    }
+}
+
+void errcheck_sketch_snapshot(errcheck_sketch_t *out)
+{
+    while (__atomic_test_and_set(&s_sketch_busy, __ATOMIC_ACQUIRE)) {
+        // Updates hold the lock for a few hundred cycles at most
+    }
+    *out = s_sketch;
+    __atomic_clear(&s_sketch_busy, __ATOMIC_RELEASE);
+
+    out->skipped = __atomic_load_n(&s_sketch.skipped, __ATOMIC_RELAXED);
+    sort_entries(out->sites);
+    sort_entries(out->inner);
+}
+
+void errcheck_sketch_reset(void)
+{
+    while (__atomic_test_and_set(&s_sketch_busy, __ATOMIC_ACQUIRE)) {
+    }
+    memset(&s_sketch, 0, sizeof(s_sketch));
+    __atomic_clear(&s_sketch_busy, __ATOMIC_RELEASE);
+}
+
+uint32_t errcheck_sketch_distinct_inner(const errcheck_sketch_t *s)
+{
+    uint64_t sum = 0;   // Sum of 2^-reg in 32.32 fixed point
+    uint32_t zeros = 0;
+
+    for (uint32_t i = 0; i < ERRCHECK_SKETCH_HLL_REGS; i++) {
+        sum += (1ull << 32) >> s->hll[i];
+        zeros += (s->hll[i] == 0);
+    }
+
+    // Raw estimate alpha * m^2 / sum with alpha_64 = 0.709 (0.709 * 4096 ~= 2904)
+    uint32_t estimate = (uint32_t)((2904ull << 32) / sum);
+    if (estimate <= 5u * ERRCHECK_SKETCH_HLL_REGS / 2u && zeros != 0) {
+        estimate = s_linear_count[zeros - 1u];
+    }
+    return estimate;
+}
+
+#endif /* ERRCHECK_ENABLE_SKETCH */
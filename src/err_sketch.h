@@ -0,0 +1,59 @@
+/**
+ * =============================================================================
+ * err_sketch.h
+ * Fixed-memory streaming summary of failing sites and inner codes.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_SKETCH (link err_sketch.c)
+ * * Every logged failure updates, in bounded time and without allocation:
+ *   - a Space-Saving summary of the ERRCHECK_SKETCH_TOPK most frequent sites,
+ *   - a Space-Saving summary of the most frequent inner codes,
+ *   - a 64-register HyperLogLog estimating the number of distinct inner codes.
+ * Default footprint: 2 x 8 x 12 + 64 + 8 = 264 bytes of RAM.
+ * * Guarantees: every key occurring more than total / TOPK times is in its
+ * summary; an entry's true count lies in [count - error, count]. The distinct
+ * estimate has a standard error of about 13% (linear counting for small sets).
+ * * Updates take a try-lock: a failure logged while another thread updates the
+ * sketch is counted in 'skipped' instead of waiting, so the failure path never
+ * spins.
+ * =============================================================================
+ */
+
+#ifndef ERR_SKETCH_H
+#define ERR_SKETCH_H
+
+#include <stdint.h>
+#include "errcheck.h"
+
+#ifndef ERRCHECK_SKETCH_TOPK
+    #define ERRCHECK_SKETCH_TOPK 8u
+#endif
+#define ERRCHECK_SKETCH_HLL_REGS 64u
+
+/* --- Space-Saving counter --- */
+typedef struct {
+    uint32_t key;               // Site id or inner code
+    uint32_t count;             // Overestimate (0 marks an unused counter)
+    uint32_t error;             // Maximum overestimation inherited on takeover
+} errcheck_sketch_entry_t;
+
+typedef struct {
+    uint32_t total;             // Failures summarised
+    uint32_t skipped;           // Failures not summarised (sketch busy in another thread)
+    errcheck_sketch_entry_t sites[ERRCHECK_SKETCH_TOPK];
+    errcheck_sketch_entry_t inner[ERRCHECK_SKETCH_TOPK];
+    uint8_t hll[ERRCHECK_SKETCH_HLL_REGS];
+} errcheck_sketch_t;
+
+#ifdef ERRCHECK_ENABLE_SKETCH
+    // Called from errcheck_log_to_nvram_commit()
+    void errcheck_sketch_update(uint32_t site, uint32_t inner_code);
+
+    // Consistent copy of the sketch, entries sorted by descending count
+    void errcheck_sketch_snapshot(errcheck_sketch_t *out);
+    void errcheck_sketch_reset(void);
+
+    // Estimated number of distinct inner codes seen
+    uint32_t errcheck_sketch_distinct_inner(const errcheck_sketch_t *s);
+#endif
+
+#endif /* ERR_SKETCH_H */
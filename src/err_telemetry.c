@@ -0,0 +1,297 @@
+/**
+ * =============================================================================
+ * err_telemetry.c
+ * Bit-packed telemetry frame encoder and decoder.
+ * =============================================================================
+ * NOTE: The encoder is greedy in record order (entries are delta coded against
+ * each other, so records are never reordered): it stops at the first entry that
+ * no longer fits, or when the per-frame site dictionary is full. Coalescing
+ * keeps only the first timestamp of a run of identical records.
+ * =============================================================================
+ */
+
+#include "err_telemetry.h"
+#include "err_crc32c.h"
+#include <string.h>
+
+#define TLM_NS_PER_MS    1000000u
+#define TLM_DICT_SIZE    (1u << ERRCHECK_TLM_DICT_BITS)
+
+/* --- Bit stream (LSB-first within each byte) --- */
+typedef struct {
+    uint8_t *buf;
+    const uint8_t *rbuf;
+    uint32_t cap;               // Capacity in bits
+    uint32_t pos;               // Next bit
+} tlm_bits_t;
+
+static unsigned tlm_log2(uint64_t n)
+{
+    return 63u - (unsigned)__builtin_clzll(n);
+}
+
+// Size of the Elias-gamma code of n (n >= 1)
+static uint32_t tlm_gamma_bits(uint64_t n)
+{
+    return 2u * tlm_log2(n) + 1u;
+}
+
+static uint64_t tlm_zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t tlm_unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1u);
+}
+
+// The buffer is zeroed up front, so only set bits are written
+static void tlm_put(tlm_bits_t *b, uint64_t v, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++, b->pos++) {
+        if ((v >> i) & 1u) {
+            b->buf[b->pos >> 3] |= (uint8_t)(1u << (b->pos & 7u));
+        }
+    }
+}
+
+static void tlm_put_gamma(tlm_bits_t *b, uint64_t n)
+{
+    unsigned len = tlm_log2(n);
+
+    b->pos += len;  // 'len' zero bits
+    for (unsigned i = len + 1; i-- > 0; b->pos++) {
+        if ((n >> i) & 1u) {
+            b->buf[b->pos >> 3] |= (uint8_t)(1u << (b->pos & 7u));
+        }
+    }
+}
+
+static int tlm_get_bit(tlm_bits_t *b, unsigned *bit)
+{
+    if (b->pos >= b->cap) {
+        return 0;
+    }
+    *bit = (b->rbuf[b->pos >> 3] >> (b->pos & 7u)) & 1u;
+    b->pos++;
+    return 1;
+}
+
+static int tlm_get(tlm_bits_t *b, unsigned n, uint64_t *v)
+{
+    unsigned bit;
+
+    *v = 0;
+    for (unsigned i = 0; i < n; i++) {
+        if (!tlm_get_bit(b, &bit)) {
+            return 0;
+        }
+        *v |= (uint64_t)bit << i;
+    }
+    return 1;
+}
+
+static int tlm_get_gamma(tlm_bits_t *b, uint64_t *n)
+{
+    unsigned len = 0, bit = 0;
+
+    while (tlm_get_bit(b, &bit) && bit == 0) {
+        if (++len > 63u) {
+            return 0;
+        }
+    }
+    if (bit == 0) {
+        return 0;   // Ran off the end
+    }
+    *n = 1;
+    for (unsigned i = 0; i < len; i++) {
+        if (!tlm_get_bit(b, &bit)) {
+            return 0;
+        }
+        *n = (*n << 1) | bit;
+    }
+    return 1;
+}
+
+static void tlm_put_le(uint8_t *p, uint64_t v, unsigned bytes)
+{
+    for (unsigned i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(v >> (8u * i));
+    }
+}
+
+static uint64_t tlm_get_le(const uint8_t *p, unsigned bytes)
+{
+    uint64_t v = 0;
+    for (unsigned i = 0; i < bytes; i++) {
+        v |= (uint64_t)p[i] << (8u * i);
+    }
+    return v;
+}
+
+static bool tlm_same(const errcheck_record_t *a, const errcheck_record_t *b)
+{
+    return a->code == b->code && a->site == b->site && a->inner_code == b->inner_code;
+}
+
+/* ========================================================================= */
+/* Encoder                                                                   */
+/* ========================================================================= */
+size_t errcheck_tlm_encode(errcheck_tlm_encoder_t *enc, const errcheck_record_t *recs,
+                           size_t n, uint8_t *frame, size_t mtu, size_t *consumed)
+{
+    uint32_t dict[TLM_DICT_SIZE];
+    unsigned dict_n = 0, entries = 0;
+    size_t i = 0;
+
+    *consumed = 0;
+    if (mtu < ERRCHECK_TLM_MIN_FRAME || mtu > ERRCHECK_TLM_MAX_FRAME || n == 0) {
+        return 0;
+    }
+    memset(frame, 0, mtu);
+
+    tlm_bits_t bits = { frame + ERRCHECK_TLM_HEADER_SIZE, NULL,
+                        (uint32_t)(mtu - ERRCHECK_TLM_HEADER_SIZE - ERRCHECK_TLM_CRC_SIZE) * 8u, 0 };
+    uint64_t base_ms = recs[0].timestamp_ns / TLM_NS_PER_MS;
+    uint64_t prev_ms = base_ms;
+
+    while (i < n && entries < ERRCHECK_TLM_MAX_ENTRIES) {
+        const errcheck_record_t *r = &recs[i];
+        uint64_t ms = r->timestamp_ns / TLM_NS_PER_MS;
+        uint64_t dt = tlm_zigzag((int64_t)(ms - prev_ms));
+        size_t run = 1;
+        unsigned slot = 0;
+
+        while (i + run < n && run < UINT32_MAX && tlm_same(r, &recs[i + run])) {
+            run++;
+        }
+        while (slot < dict_n && dict[slot] != r->site) {
+            slot++;
+        }
+        bool literal = (slot == dict_n);
+        if (literal && dict_n == TLM_DICT_SIZE) {
+            break;  // Dictionary full: the site goes into the next frame
+        }
+
+        uint32_t fixed = ERRCHECK_TLM_CODE_BITS + 1u + (literal ? 32u : ERRCHECK_TLM_DICT_BITS)
+                       + tlm_gamma_bits((uint64_t)r->inner_code + 1u) + tlm_gamma_bits(dt + 1u);
+        if (entries == 0) {
+            // The first entry must always fit, or a long run would stall every
+            // frame: split the count (lossless, the rest opens the next frame)
+            while (run > 1 && bits.pos + fixed + tlm_gamma_bits(run) > bits.cap) {
+                run /= 2u;
+            }
+        }
+        uint32_t need = fixed + tlm_gamma_bits(run);
+        if (bits.pos + need > bits.cap) {
+            break;
+        }
+
+        tlm_put(&bits, r->code, ERRCHECK_TLM_CODE_BITS);
+        tlm_put(&bits, literal ? 1u : 0u, 1);
+        if (literal) {
+            tlm_put(&bits, r->site, 32);
+            dict[dict_n++] = r->site;
+        } else {
+            tlm_put(&bits, slot, ERRCHECK_TLM_DICT_BITS);
+        }
+        tlm_put_gamma(&bits, (uint64_t)r->inner_code + 1u);
+        tlm_put_gamma(&bits, dt + 1u);
+        tlm_put_gamma(&bits, run);
+
+        prev_ms = ms;
+        i += run;
+        entries++;
+    }
+
+    frame[0] = ERRCHECK_TLM_SYNC0;
+    frame[1] = ERRCHECK_TLM_SYNC1;
+    frame[2] = (uint8_t)mtu;
+    frame[3] = (uint8_t)(ERRCHECK_TLM_VERSION << 4);
+    frame[4] = (uint8_t)entries;
+    tlm_put_le(&frame[5], enc->next_seq, 2);
+    tlm_put_le(&frame[7], enc->device_id, 2);
+    tlm_put_le(&frame[9], base_ms, 6);
+    tlm_put_le(&frame[mtu - ERRCHECK_TLM_CRC_SIZE],
+               errcheck_crc32c(0, &frame[2], mtu - 2u - ERRCHECK_TLM_CRC_SIZE), 4);
+
+    enc->next_seq++;
+    *consumed = i;
+    return mtu;
+}
+
+/* ========================================================================= */
+/* Decoder                                                                   */
+/* ========================================================================= */
+size_t errcheck_tlm_frame_len(const uint8_t *buf, size_t avail)
+{
+    if (avail < 3u || buf[0] != ERRCHECK_TLM_SYNC0 || buf[1] != ERRCHECK_TLM_SYNC1) {
+        return 0;
+    }
+    return buf[2];
+}
+
+int errcheck_tlm_decode(const uint8_t *frame, size_t len, errcheck_tlm_header_t *hdr,
+                        errcheck_tlm_entry_t *out, size_t max)
+{
+    uint32_t dict[TLM_DICT_SIZE];
+    unsigned dict_n = 0;
+    size_t written = 0;
+
+    if (len < ERRCHECK_TLM_MIN_FRAME || len > ERRCHECK_TLM_MAX_FRAME
+        || errcheck_tlm_frame_len(frame, len) != len) {
+        return -1;
+    }
+    uint32_t crc = (uint32_t)tlm_get_le(&frame[len - ERRCHECK_TLM_CRC_SIZE], 4);
+    if (crc != errcheck_crc32c(0, &frame[2], len - 2u - ERRCHECK_TLM_CRC_SIZE)
+        || (frame[3] >> 4) != ERRCHECK_TLM_VERSION) {
+        return -1;
+    }
+
+    hdr->length = frame[2];
+    hdr->version = (uint8_t)(frame[3] >> 4);
+    hdr->flags = (uint8_t)(frame[3] & 0x0Fu);
+    hdr->count = frame[4];
+    hdr->seq = (uint16_t)tlm_get_le(&frame[5], 2);
+    hdr->device_id = (uint16_t)tlm_get_le(&frame[7], 2);
+    hdr->base_ms = tlm_get_le(&frame[9], 6);
+
+    tlm_bits_t bits = { NULL, frame + ERRCHECK_TLM_HEADER_SIZE,
+                        (uint32_t)(len - ERRCHECK_TLM_HEADER_SIZE - ERRCHECK_TLM_CRC_SIZE) * 8u, 0 };
+    uint64_t ms = hdr->base_ms;
+
+    for (unsigned e = 0; e < hdr->count; e++) {
+        uint64_t code, literal, site, inner, dt, run;
+
+        if (!tlm_get(&bits, ERRCHECK_TLM_CODE_BITS, &code) || !tlm_get(&bits, 1, &literal)) {
+            return -1;
+        }
+        if (literal) {
+            if (!tlm_get(&bits, 32, &site) || dict_n == TLM_DICT_SIZE) {
+                return -1;
+            }
+            dict[dict_n++] = (uint32_t)site;
+        } else {
+            if (!tlm_get(&bits, ERRCHECK_TLM_DICT_BITS, &site) || site >= dict_n) {
+                return -1;
+            }
+            site = dict[site];
+        }
+        if (!tlm_get_gamma(&bits, &inner) || inner > (uint64_t)UINT32_MAX + 1u
+            || !tlm_get_gamma(&bits, &dt) || !tlm_get_gamma(&bits, &run) || run > UINT32_MAX) {
+            return -1;
+        }
+        ms += (uint64_t)tlm_unzigzag(dt - 1u);
+
+        if (written < max) {
+            out[written].code = (uint32_t)code;
+            out[written].site = (uint32_t)site;
+            out[written].inner_code = (uint32_t)(inner - 1u);
+            out[written].count = (uint32_t)run;
+            out[written].timestamp_ms = ms;
+            written++;
+        }
+    }
+    return (int)written;
+}
@@ -0,0 +1,99 @@
+/**
+ * =============================================================================
+ * err_telemetry.h
+ * Bit-packed, fixed-size telemetry frames for failure records.
+ * =============================================================================
+ * Link err_telemetry.c, err_crc32c.c (and err_history.c for the record type).
+ * * Frame layout (multi-byte header fields little-endian):
+ *
+ *   off size field
+ *     0    2 sync            0xEC 0x7E
+ *     2    1 frame length    total bytes including CRC (= downlink MTU)
+ *     3    1 version:4 | flags:4
+ *     4    1 entry count
+ *     5    2 frame sequence
+ *     7    2 device id
+ *     9    6 base timestamp  ms, 48 bit (timestamp of the first entry)
+ *    15    n bit-packed entries, zero padded up to the CRC
+ *   L-4    4 CRC-32C over bytes 2 .. L-5
+ *
+ * Entry bits (LSB-first bit stream):
+ *   code        ERRCHECK_TLM_CODE_BITS
+ *   site        1 + 32 (literal, appended to the per-frame dictionary) or
+ *               0 + ERRCHECK_TLM_DICT_BITS (index of an earlier literal)
+ *   inner code  Elias-gamma(inner + 1)
+ *   time delta  Elias-gamma(zigzag(ms since previous entry) + 1)
+ *   occurrences Elias-gamma(count)  (consecutive identical records coalesced)
+ *
+ * A repeated site with a small inner code costs 3-6 bytes instead of a 32-byte
+ * record. Codes wider than ERRCHECK_TLM_CODE_BITS are truncated.
+ * =============================================================================
+ */
+
+#ifndef ERR_TELEMETRY_H
+#define ERR_TELEMETRY_H
+
+#include <stddef.h>
+#include "errcheck.h"
+#include "err_history.h"
+
+#ifndef ERRCHECK_TLM_CODE_BITS
+    #define ERRCHECK_TLM_CODE_BITS 8u
+#endif
+#ifndef ERRCHECK_TLM_DICT_BITS
+    #define ERRCHECK_TLM_DICT_BITS 3u       // Up to 8 distinct sites per frame
+#endif
+
+#define ERRCHECK_TLM_SYNC0       0xECu
+#define ERRCHECK_TLM_SYNC1       0x7Eu
+#define ERRCHECK_TLM_VERSION     1u
+#define ERRCHECK_TLM_HEADER_SIZE 15u
+#define ERRCHECK_TLM_CRC_SIZE    4u
+// Smallest frame that still fits one worst-case entry (32-bit code, literal site,
+// inner code 0xFFFFFFFF, one occurrence), so every call makes progress. The
+// encoder splits a longer run of the first entry to fit.
+#define ERRCHECK_TLM_MIN_FRAME   (ERRCHECK_TLM_HEADER_SIZE + ERRCHECK_TLM_CRC_SIZE + 17u)
+#define ERRCHECK_TLM_MAX_FRAME   255u
+#define ERRCHECK_TLM_MAX_ENTRIES 255u     // Entry count is one header byte
+
+/* --- Encoder state (one per downlink) --- */
+typedef struct {
+    uint16_t device_id;
+    uint16_t next_seq;          // Sequence number of the next frame
+} errcheck_tlm_encoder_t;
+
+/* --- Decoded frame header and entries --- */
+typedef struct {
+    uint8_t  length;
+    uint8_t  version;
+    uint8_t  flags;
+    uint8_t  count;
+    uint16_t seq;
+    uint16_t device_id;
+    uint64_t base_ms;
+} errcheck_tlm_header_t;
+
+typedef struct {
+    uint32_t code;
+    uint32_t site;
+    uint32_t inner_code;
+    uint32_t count;             // Occurrences coalesced into this entry (>= 1)
+    uint64_t timestamp_ms;      // First occurrence
+} errcheck_tlm_entry_t;
+
+/* Function prototypes */
+// Packs as many leading records of 'recs' (oldest first) as fit into one frame of
+// exactly 'mtu' bytes. '*consumed' receives the number of records packed. Returns
+// the frame length ('mtu'), or 0 if 'mtu' is out of range or 'n' is 0.
+size_t errcheck_tlm_encode(errcheck_tlm_encoder_t *enc, const errcheck_record_t *recs,
+                           size_t n, uint8_t *frame, size_t mtu, size_t *consumed);
+
+// Length a frame starting at 'buf' claims (0 if no sync or fewer than 3 bytes).
+size_t errcheck_tlm_frame_len(const uint8_t *buf, size_t avail);
+
+// Validates and unpacks one frame. Returns the number of entries written to 'out',
+// or -1 if the sync, length, version or CRC is wrong, or the bit stream is corrupt.
+int errcheck_tlm_decode(const uint8_t *frame, size_t len, errcheck_tlm_header_t *hdr,
+                        errcheck_tlm_entry_t *out, size_t max);
+
+#endif /* ERR_TELEMETRY_H */
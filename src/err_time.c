@@ -0,0 +1,51 @@
+/**
+ * =============================================================================
+ * err_time.c
+ * Time source registration and the virtual clock.
+ * =============================================================================
+ * NOTE: The virtual clock is a single 64-bit counter updated with atomic adds,
+ * so threads that sleep on it concurrently each advance it by their own
+ * duration and no reader ever sees time go backwards.
+ * =============================================================================
+ */
+
+#include "err_time.h"
+#include <stddef.h>
+
+#ifdef ERRCHECK_ENABLE_TIME_SOURCE
+
+const errcheck_time_source_t *g_errcheck_time_source = NULL;
+
+void errcheck_time_set_source(const errcheck_time_source_t *source)
+{
+    __atomic_store_n(&g_errcheck_time_source, source, __ATOMIC_RELEASE);
+}
+
+static uint64_t vclock_now(void *ctx)
+{
+    const errcheck_vclock_t *vc = ctx;
+    return __atomic_load_n(&vc->now_ns, __ATOMIC_ACQUIRE);
+}
+
+static void vclock_sleep(void *ctx, uint64_t ns)
+{
+    errcheck_vclock_advance(ctx, ns);
+}
+
+/**
+ * @brief Starts the clock at 'start_ns'; it does not move until advanced or slept on.
+ */
+void errcheck_vclock_init(errcheck_vclock_t *vc, uint64_t start_ns)
+{
+    vc->now_ns = start_ns;
+    vc->source.now_ns = vclock_now;
+    vc->source.sleep_ns = vclock_sleep;
+    vc->source.ctx = vc;
+}
+
+void errcheck_vclock_advance(errcheck_vclock_t *vc, uint64_t ns)
+{
+    __atomic_fetch_add(&vc->now_ns, ns, __ATOMIC_ACQ_REL);
+}
+
+#endif /* ERRCHECK_ENABLE_TIME_SOURCE */
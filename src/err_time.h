@@ -0,0 +1,51 @@
+/**
+ * =============================================================================
+ * err_time.h
+ * Pluggable time source, and a virtual clock that tests advance explicitly.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_TIME_SOURCE (link err_time.c)
+ * * Every time-dependent part of errcheck reads time through errcheck_now_ns()
+ * and waits through errcheck_sleep_ns(): record and breadcrumb timestamps (and
+ * so telemetry deltas and upload ordering), watchdog entry stamps and hang
+ * durations, injected latency. Application code that implements retries,
+ * backoff, deadlines or rate limits on the same two calls follows the same
+ * source. With the define, both calls go to the installed source, if any;
+ * without one they keep the built-in monotonic clock.
+ * * errcheck_vclock_t is a source whose time only moves when the test calls
+ * errcheck_vclock_advance(), or when someone sleeps on it: a sleep advances the
+ * clock and returns at once. A scenario with minutes of backoff therefore runs
+ * in microseconds, with identical timestamps on every run. The watchdog's scan
+ * thread still sleeps in real time: tests call errcheck_watchdog_scan().
+ * * Install a source before the threads that use it start (or with them
+ * quiescent) and keep it alive until it is replaced.
+ * =============================================================================
+ */
+
+#ifndef ERR_TIME_H
+#define ERR_TIME_H
+
+#include <stdint.h>
+#include "errcheck.h"
+
+typedef struct {
+    uint64_t (*now_ns)(void *ctx);              // Monotonic, never decreasing
+    void (*sleep_ns)(void *ctx, uint64_t ns);   // NULL: busy-wait on now_ns
+    void *ctx;
+} errcheck_time_source_t;
+
+typedef struct {
+    uint64_t now_ns;
+    errcheck_time_source_t source;  // Install with errcheck_time_set_source(&vc->source)
+} errcheck_vclock_t;
+
+#ifdef ERRCHECK_ENABLE_TIME_SOURCE
+    // Installed source, or NULL for the built-in clock
+    extern const errcheck_time_source_t *g_errcheck_time_source;
+
+    void errcheck_time_set_source(const errcheck_time_source_t *source);
+
+    void errcheck_vclock_init(errcheck_vclock_t *vc, uint64_t start_ns);
+    void errcheck_vclock_advance(errcheck_vclock_t *vc, uint64_t ns);
+#endif
+
+#endif /* ERR_TIME_H */
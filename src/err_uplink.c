@@ -0,0 +1,237 @@
+/**
+ * =============================================================================
+ * err_uplink.c
+ * Severity-aware upload scheduler (fixed-size priority queue).
+ * =============================================================================
+ * NOTE: Novelty can only go from "new" to "already uploaded", so keys only ever
+ * decrease. The drain re-keys lazily: an item popped with a stale novelty bit is
+ * pushed back with its corrected key instead of being sent ahead of its turn.
+ * * The uploaded-site set is direct-mapped on the site hash; a collision forgets
+ * the older site, which then simply counts as new once more.
+ * =============================================================================
+ */
+
+#include "err_uplink.h"
+#include <string.h>
+
+#define UPLINK_NOVEL_BIT  (1ull << 61)
+#define UPLINK_TS_MASK    (UPLINK_NOVEL_BIT - 1u)
+// Smallest entry: code, dictionary site and three one-bit gamma codes
+#define UPLINK_MIN_ENTRY_BITS (ERRCHECK_TLM_CODE_BITS + 1u + ERRCHECK_TLM_DICT_BITS + 3u)
+
+static bool uplink_site_sent(const errcheck_uplink_t *q, uint32_t site)
+{
+    return site != 0 && q->sent_sites[site & (ERRCHECK_UPLINK_SITE_SLOTS - 1u)] == site;
+}
+
+static uint64_t uplink_key(const errcheck_record_t *rec, bool novel)
+{
+    uint64_t sev = (uint64_t)app_error_severity((err_t)rec->code);
+
+    if (sev > ERRCHECK_SEV_CRITICAL) {
+        sev = ERRCHECK_SEV_CRITICAL;
+    }
+    return (sev << 62) | (novel ? UPLINK_NOVEL_BIT : 0u) | (rec->timestamp_ns & UPLINK_TS_MASK);
+}
+
+static void uplink_swap(errcheck_uplink_item_t *a, errcheck_uplink_item_t *b)
+{
+    errcheck_uplink_item_t t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void uplink_sift_up(errcheck_uplink_t *q, uint32_t i)
+{
+    while (i > 0 && q->heap[(i - 1u) / 2u].key < q->heap[i].key) {
+        uplink_swap(&q->heap[(i - 1u) / 2u], &q->heap[i]);
+        i = (i - 1u) / 2u;
+    }
+}
+
+static void uplink_sift_down(errcheck_uplink_t *q, uint32_t i)
+{
+    for (;;) {
+        uint32_t l = 2u * i + 1u, r = l + 1u, best = i;
+        if (l < q->count && q->heap[l].key > q->heap[best].key) {
+            best = l;
+        }
+        if (r < q->count && q->heap[r].key > q->heap[best].key) {
+            best = r;
+        }
+        if (best == i) {
+            return;
+        }
+        uplink_swap(&q->heap[i], &q->heap[best]);
+        i = best;
+    }
+}
+
+static void uplink_pop(errcheck_uplink_t *q, errcheck_uplink_item_t *out)
+{
+    *out = q->heap[0];
+    q->heap[0] = q->heap[--q->count];
+    uplink_sift_down(q, 0);
+}
+
+// Caller guarantees a free slot
+static void uplink_insert(errcheck_uplink_t *q, const errcheck_record_t *rec)
+{
+    q->heap[q->count].key = uplink_key(rec, !uplink_site_sent(q, rec->site));
+    q->heap[q->count].rec = *rec;
+    uplink_sift_up(q, q->count++);
+}
+
+void errcheck_uplink_init(errcheck_uplink_t *q, uint16_t device_id)
+{
+    memset(q, 0, sizeof(*q));
+    q->enc.device_id = device_id;
+}
+
+bool errcheck_uplink_push(errcheck_uplink_t *q, const errcheck_record_t *rec)
+{
+    if (q->count < ERRCHECK_UPLINK_DEPTH) {
+        uplink_insert(q, rec);
+        return true;
+    }
+
+    // Full: the minimum of a max-heap is one of the leaves
+    uint32_t min = q->count / 2u;
+    for (uint32_t i = min + 1u; i < q->count; i++) {
+        if (q->heap[i].key < q->heap[min].key) {
+            min = i;
+        }
+    }
+    q->dropped++;
+    uint64_t key = uplink_key(rec, !uplink_site_sent(q, rec->site));
+    if (key <= q->heap[min].key) {
+        return false;
+    }
+    q->heap[min].key = key;
+    q->heap[min].rec = *rec;
+    uplink_sift_up(q, min);
+    return true;
+}
+
+uint32_t errcheck_uplink_collect(errcheck_uplink_t *q, const errcheck_history_header_t *hdr)
+{
+    errcheck_record_t recs[ERRCHECK_HISTORY_DEPTH];
+    uint32_t n = errcheck_history_read(hdr, recs, ERRCHECK_HISTORY_DEPTH);
+    uint32_t queued = 0;
+
+    for (uint32_t i = 0; i < n; i++) {
+        if ((int32_t)(recs[i].seq - q->last_seq) <= 0) {
+            continue;   // Already collected
+        }
+        q->last_seq = recs[i].seq;
+        queued += errcheck_uplink_push(q, &recs[i]) ? 1u : 0u;
+    }
+    return queued;
+}
+
+// Moves the best remaining record into q->pick[n]. Sites already picked count as
+// uploaded, so a second record from a new site ranks behind other new sites.
+static bool uplink_pick(errcheck_uplink_t *q, uint32_t n)
+{
+    errcheck_uplink_item_t top;
+
+    while (q->count > 0) {
+        uplink_pop(q, &top);
+
+        bool sent = uplink_site_sent(q, top.rec.site);
+        for (uint32_t i = 0; i < n && !sent; i++) {
+            sent = (q->pick[i].rec.site == top.rec.site);
+        }
+        if ((top.key & UPLINK_NOVEL_BIT) && sent) {
+            top.key &= ~UPLINK_NOVEL_BIT;   // Stale: retry with the corrected key
+            q->heap[q->count] = top;
+            uplink_sift_up(q, q->count++);
+            continue;
+        }
+        q->pick[n] = top;
+        return true;
+    }
+    return false;
+}
+
+// Encodes the first n picks into 'frame', oldest first (the encoder's time deltas
+// are only small in that order). Returns how many of them fit.
+static uint32_t uplink_trial(errcheck_uplink_t *q, uint32_t n, uint8_t *frame, size_t mtu,
+                             uint16_t seq)
+{
+    size_t used = 0;
+
+    // Insertion sort into q->batch: n is at most ERRCHECK_UPLINK_DEPTH
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t j = i;
+        while (j > 0 && q->batch[j - 1u].timestamp_ns > q->pick[i].rec.timestamp_ns) {
+            q->batch[j] = q->batch[j - 1u];
+            j--;
+        }
+        q->batch[j] = q->pick[i].rec;
+    }
+    q->enc.next_seq = seq;  // Every trial encodes the same frame
+    (void)errcheck_tlm_encode(&q->enc, q->batch, n, frame, mtu, &used);
+    return (uint32_t)used;
+}
+
+// Fills one frame with the best records that fit and returns how many it carries
+// (they stay in q->batch[0..n)). Picks grow by the most entries a frame could hold
+// while everything fits. After an overflow only as many of the best picks as fitted
+// are kept, the rest are re-queued, and the frame is topped up one pick at a time.
+static uint32_t uplink_frame(errcheck_uplink_t *q, uint8_t *frame, size_t mtu)
+{
+    uint32_t chunk = (uint32_t)(mtu - ERRCHECK_TLM_HEADER_SIZE - ERRCHECK_TLM_CRC_SIZE) * 8u
+                   / UPLINK_MIN_ENTRY_BITS;
+    uint16_t seq = q->enc.next_seq;
+    uint32_t n = 0, used = 0, grown;
+
+    do {
+        grown = n;
+        while (n < grown + chunk && uplink_pick(q, n)) {
+            n++;
+        }
+        if (n == grown) {
+            break;  // Queue empty and the last trial fit
+        }
+        used = uplink_trial(q, n, frame, mtu, seq);
+    } while (used == n);
+
+    // The first entry always fits, so 'used' >= 1 and this terminates
+    while (used < n) {
+        while (n > used) {
+            uplink_insert(q, &q->pick[--n].rec);
+        }
+        used = uplink_trial(q, n, frame, mtu, seq);
+    }
+    // A smaller record further down may still fit in what is left
+    while (uplink_pick(q, n)) {
+        if (uplink_trial(q, n + 1u, frame, mtu, seq) == n + 1u) {
+            n++;
+            continue;
+        }
+        uplink_insert(q, &q->pick[n].rec);
+        (void)uplink_trial(q, n, frame, mtu, seq);
+        break;
+    }
+    return n;
+}
+
+size_t errcheck_uplink_drain(errcheck_uplink_t *q, uint8_t *out, size_t budget, size_t mtu)
+{
+    size_t written = 0;
+
+    if (mtu < ERRCHECK_TLM_MIN_FRAME || mtu > ERRCHECK_TLM_MAX_FRAME) {
+        return 0;
+    }
+    while (q->count > 0 && budget - written >= mtu) {
+        uint32_t n = uplink_frame(q, out + written, mtu);
+
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t site = q->batch[i].site;
+            q->sent_sites[site & (ERRCHECK_UPLINK_SITE_SLOTS - 1u)] = site;
+        }
+        written += mtu;
+    }
+    return written;
+}
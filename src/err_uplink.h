@@ -0,0 +1,68 @@
+/**
+ * =============================================================================
+ * err_uplink.h
+ * Severity-aware upload scheduler for short comms windows.
+ * =============================================================================
+ * Link err_uplink.c, err_telemetry.c, err_crc32c.c and err_history.c.
+ * * Pending records wait in a fixed-size priority queue (binary max-heap of
+ * ERRCHECK_UPLINK_DEPTH items). Priority, highest first:
+ *   1. severity      app_error_severity(code)
+ *   2. novelty       sites not uploaded yet before sites already seen on the ground
+ *   3. recency       newer records before older ones
+ * When the queue is full, a new record evicts the lowest-priority item (or is
+ * dropped if it ranks lower itself); both count as 'dropped'.
+ * * The queue is owned by the comms task and is not thread-safe: fill it from
+ * the history ring with errcheck_uplink_collect() when the window opens, then
+ * spend the window's byte budget with errcheck_uplink_drain(). The severity of
+ * each code comes from app_error_severity() (see errcheck.h).
+ * =============================================================================
+ */
+
+#ifndef ERR_UPLINK_H
+#define ERR_UPLINK_H
+
+#include "errcheck.h"
+#include "err_history.h"
+#include "err_telemetry.h"
+
+#ifndef ERRCHECK_UPLINK_DEPTH
+    #define ERRCHECK_UPLINK_DEPTH      32u
+#endif
+#ifndef ERRCHECK_UPLINK_SITE_SLOTS
+    #define ERRCHECK_UPLINK_SITE_SLOTS 64u  // Power of two; direct-mapped "uploaded" set
+#endif
+
+typedef struct {
+    uint64_t key;               // severity:2 | novel:1 | timestamp_ns:61
+    errcheck_record_t rec;
+} errcheck_uplink_item_t;
+
+typedef struct {
+    errcheck_uplink_item_t heap[ERRCHECK_UPLINK_DEPTH];
+    uint32_t count;
+    uint32_t dropped;           // Evicted or rejected while the queue was full
+    uint32_t last_seq;          // Newest history sequence collected so far
+    uint32_t sent_sites[ERRCHECK_UPLINK_SITE_SLOTS]; // 0 marks an empty slot
+    errcheck_uplink_item_t pick[ERRCHECK_UPLINK_DEPTH]; // Drain scratch: frame candidates, best first
+    errcheck_record_t batch[ERRCHECK_UPLINK_DEPTH];  // Drain scratch: the same records, oldest first
+    errcheck_tlm_encoder_t enc;
+} errcheck_uplink_t;
+
+/* Function prototypes */
+void errcheck_uplink_init(errcheck_uplink_t *q, uint16_t device_id);
+
+// Queues one record. Returns false if it was dropped because the queue is full of
+// higher-priority records.
+bool errcheck_uplink_push(errcheck_uplink_t *q, const errcheck_record_t *rec);
+
+// Queues every record of a history ring newer than the last one collected.
+// Returns the number of records queued.
+uint32_t errcheck_uplink_collect(errcheck_uplink_t *q, const errcheck_history_header_t *hdr);
+
+// Fills 'out' with frames of 'mtu' bytes, highest priority first, while at least
+// one more frame fits in 'budget' bytes. Each frame carries the best records that
+// fit, encoded oldest first. Records that made it into a frame leave the
+// queue and mark their site as uploaded. Returns the number of bytes written.
+size_t errcheck_uplink_drain(errcheck_uplink_t *q, uint8_t *out, size_t budget, size_t mtu);
+
+#endif /* ERR_UPLINK_H */
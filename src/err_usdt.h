@@ -0,0 +1,79 @@
+/**
+ * =============================================================================
+ * err_usdt.h
+ * USDT (SystemTap SDT v3) static probes for tracing errcheck in production.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_USDT (GCC/Clang, ELF, x86-64 or AArch64)
+ * * Each probe is a single nop in the code plus a .note.stapsdt entry that
+ * tells the tracer where the nop is and where each argument lives (register,
+ * stack slot or constant). Nothing is called and no sys/sdt.h is needed; the
+ * probe costs a nop until perf, bpftrace or SystemTap patches it.
+ * * Probes (provider "errcheck"; every argument is a 64-bit unsigned value,
+ * 'file' is a char pointer):
+ *   check_fail(code, inner_code, file, line)  CHECK() / GOTO_CHECK() failure branch
+ *   log(code, inner_code, file, line)         context committed by errcheck_log_to_nvram()
+ *   inject(code, file, line)                  an injection decision fired
+ * * e.g.  bpftrace -e 'usdt:./app:errcheck:check_fail
+ *             { printf("%s:%d code %d\n", str(arg2), arg3, arg0); }'
+ *         perf probe -x ./app sdt_errcheck:log && perf record -e sdt_errcheck:log
+ * * Other targets and compilers: the macros expand to nothing.
+ * =============================================================================
+ */
+
+#ifndef ERR_USDT_H
+#define ERR_USDT_H
+
+#include <stdint.h>
+
+#if defined(ERRCHECK_ENABLE_USDT) && defined(__GNUC__) && defined(__ELF__) \
+    && (defined(__x86_64__) || defined(__aarch64__))
+
+#define ERRCHECK_USDT_STR_(x) #x
+#define ERRCHECK_USDT_STR(x)  ERRCHECK_USDT_STR_(x)
+
+// Note layout: n_namesz, n_descsz, n_type 3, "stapsdt", then the probe address,
+// the address of _.stapsdt.base (lets the tracer correct for prelink/PIE
+// relocation), the semaphore address (none), provider, name and argument string.
+// The weak, hidden _.stapsdt.base is emitted once per object in a COMDAT group.
+#define ERRCHECK_USDT_ASM_(name, args)                                          \
+    "990:\tnop\n"                                                               \
+    "\t.pushsection .note.stapsdt,\"?\",\"note\"\n"                             \
+    "\t.balign 4\n"                                                             \
+    "\t.4byte 992f-991f, 994f-993f, 3\n"                                        \
+    "991:\t.asciz \"stapsdt\"\n"                                                \
+    "992:\t.balign 4\n"                                                         \
+    "993:\t.8byte 990b\n"                                                       \
+    "\t.8byte _.stapsdt.base\n"                                                 \
+    "\t.8byte 0\n"                                                              \
+    "\t.asciz \"errcheck\"\n"                                                   \
+    "\t.asciz \"" ERRCHECK_USDT_STR(name) "\"\n"                                \
+    "\t.asciz \"" args "\"\n"                                                   \
+    "994:\t.balign 4\n"                                                         \
+    "\t.popsection\n"                                                           \
+    "\t.ifndef _.stapsdt.base\n"                                                \
+    "\t.pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"   \
+    "\t.weak _.stapsdt.base\n"                                                  \
+    "\t.hidden _.stapsdt.base\n"                                                \
+    "_.stapsdt.base:\t.space 1\n"                                               \
+    "\t.size _.stapsdt.base, 1\n"                                               \
+    "\t.popsection\n"                                                           \
+    "\t.endif\n"
+
+// "nor": the tracer reads the value wherever the compiler already has it
+#define ERRCHECK_USDT_ARG_(x) "nor"((uint64_t)(uintptr_t)(x))
+
+#define ERRCHECK_USDT3(name, a0, a1, a2)                                        \
+    __asm__ __volatile__(ERRCHECK_USDT_ASM_(name, "8@%0 8@%1 8@%2")             \
+                         :: ERRCHECK_USDT_ARG_(a0), ERRCHECK_USDT_ARG_(a1),     \
+                            ERRCHECK_USDT_ARG_(a2))
+#define ERRCHECK_USDT4(name, a0, a1, a2, a3)                                    \
+    __asm__ __volatile__(ERRCHECK_USDT_ASM_(name, "8@%0 8@%1 8@%2 8@%3")        \
+                         :: ERRCHECK_USDT_ARG_(a0), ERRCHECK_USDT_ARG_(a1),     \
+                            ERRCHECK_USDT_ARG_(a2), ERRCHECK_USDT_ARG_(a3))
+
+#else
+    #define ERRCHECK_USDT3(name, a0, a1, a2)      do { } while (0)
+    #define ERRCHECK_USDT4(name, a0, a1, a2, a3)  do { } while (0)
+#endif
+
+#endif /* ERR_USDT_H */
@@ -0,0 +1,237 @@
+/**
+ * =============================================================================
+ * err_watchdog.c
+ * Per-thread in-flight slots and the hang scan.
+ * =============================================================================
+ * NOTE: Each slot is a sequence lock with a single writer, its own thread. The
+ * owner makes the counter odd, updates the slot and makes it even again; the
+ * scan retries nothing and simply skips a slot it caught mid-update, because
+ * the same call will still be in flight at the next scan if it is stuck.
+ * The scan itself must run from one task at a time.
+ * =============================================================================
+ */
+
+#if defined(__unix__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // nanosleep() under strict -std=c99
+#endif
+
+#include "err_watchdog.h"
+#include <stddef.h>
+
+#ifdef ERRCHECK_ENABLE_WATCHDOG
+
+#include "err_history.h"    // errcheck_record_t, errcheck_sinks_emit()
+#if defined(__unix__)
+#include <time.h>
+#endif
+#ifdef ERRCHECK_ENABLE_TIME_SOURCE
+#include "err_time.h"
+#endif
+#ifdef ERRCHECK_ENABLE_WATCHDOG_THREAD
+#include <errno.h>
+#include <pthread.h>
+#endif
+
+typedef struct {
+    uint32_t gen;               // Odd while the owner is updating the slot
+    uint32_t line;
+    const char *file;           // NULL when no guarded call is in flight
+    uint64_t enter_ns;
+    uint64_t reported_ns;       // enter_ns of the last call reported (scan only)
+} wd_slot_t;
+
+static wd_slot_t s_wd_slots[ERRCHECK_WATCHDOG_MAX_THREADS];
+static wd_slot_t s_wd_unwatched;    // Shared by threads beyond the limit, never scanned
+static uint32_t s_wd_claimed = 0;
+static uint32_t s_wd_limit_ms = ERRCHECK_WATCHDOG_LIMIT_MS;
+static uint32_t s_wd_hangs = 0;
+static errcheck_watchdog_hook_t s_wd_hook = NULL;
+static ERRCHECK_THREAD_LOCAL wd_slot_t *t_wd_slot = NULL;
+
+// Entry stamps only need the resolution of the limit (ms). On Linux the coarse
+// clock is read from the vDSO without touching the hardware counter, which
+// keeps the per-call cost a few ns. An installed time source takes precedence.
+static uint64_t wd_now_ns(void)
+{
+#ifdef ERRCHECK_ENABLE_TIME_SOURCE
+    if (__atomic_load_n(&g_errcheck_time_source, __ATOMIC_RELAXED) != NULL) {
+        return errcheck_now_ns();
+    }
+#endif
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC_COARSE, &ts) == 0) {
+        return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+    }
+#endif
+    return errcheck_now_ns();
+}
+
+static wd_slot_t *wd_thread_slot(void)
+{
+    if (t_wd_slot == NULL) {
+        uint32_t idx = __atomic_fetch_add(&s_wd_claimed, 1u, __ATOMIC_RELAXED);
+        t_wd_slot = (idx < ERRCHECK_WATCHDOG_MAX_THREADS) ? &s_wd_slots[idx] : &s_wd_unwatched;
+    }
+    return t_wd_slot;
+}
+
+static void wd_publish(wd_slot_t *s, const char *file, uint32_t line, uint64_t enter_ns)
+{
+    uint32_t gen = __atomic_load_n(&s->gen, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&s->gen, gen + 1u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&s->file, file, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->line, line, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->enter_ns, enter_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->gen, gen + 2u, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Publishes a guarded call as in flight; saves the enclosing one in 'outer'.
+ */
+void errcheck_call_enter(errcheck_call_frame_t *outer, const char *file, uint32_t line)
+{
+    wd_slot_t *s = wd_thread_slot();
+
+    outer->file = __atomic_load_n(&s->file, __ATOMIC_RELAXED);
+    outer->line = __atomic_load_n(&s->line, __ATOMIC_RELAXED);
+    outer->enter_ns = __atomic_load_n(&s->enter_ns, __ATOMIC_RELAXED);
+    wd_publish(s, file, line, wd_now_ns());
+}
+
+/**
+ * @brief Guarded call returned: the enclosing call (if any) is in flight again.
+ */
+void errcheck_call_exit(const errcheck_call_frame_t *outer)
+{
+    wd_publish(wd_thread_slot(), outer->file, outer->line, outer->enter_ns);
+}
+
+static void wd_report(uint32_t thread, const char *file, uint32_t line, uint64_t duration_ns)
+{
+    errcheck_hang_t hang = {
+        .thread = thread,
+        .site = errcheck_site_id(file, line),
+        .file = file,
+        .line = line,
+        .duration_ns = duration_ns,
+    };
+    uint64_t ms = duration_ns / 1000000u;
+    errcheck_record_t rec = {
+        .site = hang.site,
+        .inner_code = (thread << 24) | (uint32_t)(ms > 0xFFFFFFu ? 0xFFFFFFu : ms),
+        .line = line,
+        .timestamp_ns = errcheck_now_ns(),
+        .code = ERRCHECK_ERR_HANG,
+    };
+
+    errcheck_sinks_emit(&rec);
+
+    __atomic_fetch_add(&s_wd_hangs, 1u, __ATOMIC_RELAXED);
+    errcheck_watchdog_hook_t hook = __atomic_load_n(&s_wd_hook, __ATOMIC_ACQUIRE);
+    if (hook != NULL) {
+        hook(&hang);
+    }
+}
+
+uint32_t errcheck_watchdog_scan(void)
+{
+    uint32_t claimed = __atomic_load_n(&s_wd_claimed, __ATOMIC_RELAXED);
+    uint32_t slots = claimed < ERRCHECK_WATCHDOG_MAX_THREADS ? claimed : ERRCHECK_WATCHDOG_MAX_THREADS;
+    uint64_t limit_ns = (uint64_t)__atomic_load_n(&s_wd_limit_ms, __ATOMIC_RELAXED) * 1000000u;
+    uint64_t now = wd_now_ns();
+    uint32_t found = 0;
+
+    for (uint32_t i = 0; i < slots; i++) {
+        wd_slot_t *s = &s_wd_slots[i];
+        uint32_t gen = __atomic_load_n(&s->gen, __ATOMIC_ACQUIRE);
+        const char *file = __atomic_load_n(&s->file, __ATOMIC_RELAXED);
+        uint32_t line = __atomic_load_n(&s->line, __ATOMIC_RELAXED);
+        uint64_t enter_ns = __atomic_load_n(&s->enter_ns, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if ((gen & 1u) != 0 || gen != __atomic_load_n(&s->gen, __ATOMIC_RELAXED)) {
+            continue;   // Caught mid-update: the call just started or returned
+        }
+        if (file == NULL || enter_ns == s->reported_ns || now < enter_ns
+            || now - enter_ns <= limit_ns) {
+            continue;
+        }
+        s->reported_ns = enter_ns;
+        wd_report(i, file, line, now - enter_ns);
+        found++;
+    }
+    return found;
+}
+
+void errcheck_watchdog_set_limit_ms(uint32_t limit_ms)
+{
+    __atomic_store_n(&s_wd_limit_ms, limit_ms, __ATOMIC_RELAXED);
+}
+
+void errcheck_watchdog_set_hook(errcheck_watchdog_hook_t hook)
+{
+    __atomic_store_n(&s_wd_hook, hook, __ATOMIC_RELEASE);
+}
+
+uint32_t errcheck_watchdog_thread_index(void)
+{
+    wd_slot_t *s = wd_thread_slot();
+    return (s == &s_wd_unwatched) ? ERRCHECK_WATCHDOG_MAX_THREADS : (uint32_t)(s - s_wd_slots);
+}
+
+uint32_t errcheck_watchdog_hangs(void)
+{
+    return __atomic_load_n(&s_wd_hangs, __ATOMIC_RELAXED);
+}
+
+#ifdef ERRCHECK_ENABLE_WATCHDOG_THREAD
+static pthread_t s_wd_thread;
+static uint32_t s_wd_period_ms = 0;
+static int s_wd_running = 0;
+
+static void *wd_thread_main(void *arg)
+{
+    struct timespec period = {
+        .tv_sec = (time_t)(s_wd_period_ms / 1000u),
+        .tv_nsec = (long)(s_wd_period_ms % 1000u) * 1000000L,
+    };
+
+    (void)arg;
+    while (__atomic_load_n(&s_wd_running, __ATOMIC_ACQUIRE)) {
+        nanosleep(&period, NULL);
+        errcheck_watchdog_scan();
+    }
+    return NULL;
+}
+
+/**
+ * @brief Starts the scan thread. Stop it with errcheck_watchdog_stop().
+ */
+int errcheck_watchdog_start(uint32_t period_ms)
+{
+    if (period_ms == 0) {
+        return EINVAL;
+    }
+    if (__atomic_exchange_n(&s_wd_running, 1, __ATOMIC_ACQ_REL)) {
+        return EBUSY;
+    }
+    s_wd_period_ms = period_ms;
+    int rc = pthread_create(&s_wd_thread, NULL, wd_thread_main, NULL);
+    if (rc != 0) {
+        __atomic_store_n(&s_wd_running, 0, __ATOMIC_RELEASE);
+    }
+    return rc;
+}
+
+void errcheck_watchdog_stop(void)
+{
+    if (__atomic_exchange_n(&s_wd_running, 0, __ATOMIC_ACQ_REL)) {
+        pthread_join(s_wd_thread, NULL);
+    }
+}
+#endif /* ERRCHECK_ENABLE_WATCHDOG_THREAD */
+
+#endif /* ERRCHECK_ENABLE_WATCHDOG */
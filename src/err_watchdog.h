@@ -0,0 +1,80 @@
+/**
+ * =============================================================================
+ * err_watchdog.h
+ * In-flight registry of guarded calls and a watchdog for calls that hang.
+ * =============================================================================
+ * Enable with: -D ERRCHECK_ENABLE_WATCHDOG (link err_watchdog.c)
+ * Optional:    -D ERRCHECK_ENABLE_WATCHDOG_THREAD (POSIX hosts only, -pthread)
+ * * A CHECK()/GOTO_CHECK() whose call never returns (stuck bus, lost interrupt)
+ * is otherwise invisible: context is only captured on return. With the define,
+ * both macros publish the site and entry time of the call in a per-thread slot
+ * before making it and restore the enclosing call's entry afterwards, so
+ * nested guarded calls are tracked innermost first.
+ * * errcheck_watchdog_scan() compares every slot with the limit. A call in
+ * flight for longer is logged once as an ERRCHECK_ERR_HANG record (site, line,
+ * thread, duration) to the enabled sinks (history, sketch, anomaly, retained),
+ * then the escalation hook runs (reset, kill the thread, degrade the mode).
+ * Call the scan from a periodic timer or supervisor task, or let
+ * errcheck_watchdog_start() run it on its own thread.
+ * * Cost per guarded call: one clock read (CLOCK_MONOTONIC_COARSE on Linux,
+ * errcheck_now_ns() elsewhere) and a few stores to a slot only the calling
+ * thread writes (a sequence counter keeps the scan from seeing half-written
+ * slots). Slots are claimed on first use and never recycled;
+ * threads beyond ERRCHECK_WATCHDOG_MAX_THREADS are not watched.
+ * =============================================================================
+ */
+
+#ifndef ERR_WATCHDOG_H
+#define ERR_WATCHDOG_H
+
+#include <stdint.h>
+#include "errcheck.h"
+
+#ifndef ERRCHECK_WATCHDOG_MAX_THREADS
+    #define ERRCHECK_WATCHDOG_MAX_THREADS 16u
+#endif
+#ifndef ERRCHECK_WATCHDOG_LIMIT_MS
+    #define ERRCHECK_WATCHDOG_LIMIT_MS    1000u  // Default; see errcheck_watchdog_set_limit_ms()
+#endif
+
+// Failure code of hang records. Its inner code holds the thread index in the
+// top 8 bits and the duration in ms (saturating at 0xFFFFFF) in the low 24 bits.
+#ifndef ERRCHECK_ERR_HANG
+    #define ERRCHECK_ERR_HANG ((err_t)0xFE)
+#endif
+
+typedef struct {
+    uint32_t thread;            // Registry index (errcheck_watchdog_thread_index())
+    uint32_t site;              // errcheck_site_id(file, line)
+    const char *file;
+    uint32_t line;
+    uint64_t duration_ns;       // Time in flight when detected
+} errcheck_hang_t;
+
+// Runs on the thread that calls errcheck_watchdog_scan(), after the hang
+// record has been logged.
+typedef void (*errcheck_watchdog_hook_t)(const errcheck_hang_t *hang);
+
+#ifdef ERRCHECK_ENABLE_WATCHDOG
+    // Logs every call in flight longer than the limit (once per call) and runs
+    // the hook for each; returns the number of new hangs.
+    uint32_t errcheck_watchdog_scan(void);
+
+    void errcheck_watchdog_set_limit_ms(uint32_t limit_ms);
+    void errcheck_watchdog_set_hook(errcheck_watchdog_hook_t hook);
+
+    // Registry index of the calling thread (claims a slot if needed), or
+    // ERRCHECK_WATCHDOG_MAX_THREADS if it is not watched.
+    uint32_t errcheck_watchdog_thread_index(void);
+
+    // Hangs logged so far
+    uint32_t errcheck_watchdog_hangs(void);
+
+    #ifdef ERRCHECK_ENABLE_WATCHDOG_THREAD
+        // Scans every 'period_ms' on a dedicated thread; returns 0 or an errno value.
+        int errcheck_watchdog_start(uint32_t period_ms);
+        void errcheck_watchdog_stop(void);
+    #endif
+#endif
+
+#endif /* ERR_WATCHDOG_H */
@@ -4,59 +4,260 @@
  * Global definitions and Non-Volatile Logging stub implementation.
  * =============================================================================
  * NOTE: The NVRAM function here is a stub. Replace the printf calls with 
- * actual hardware write access (Flash/EEPROM).
+ * actual hardware write access (Flash/EEPROM). Host simulations and benchmarks
+ * can compile with -D ERRCHECK_NVRAM_STUB_SILENT to drop the console output.
  * =============================================================================
  */
 
+#if defined(__unix__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // clock_gettime(), nanosleep() under strict -std=c99
+#endif
+
 #include "errcheck.h"
+#include "err_acct.h"
 #include <stdio.h> // Used only for the stub implementation
+#if defined(__unix__)
+#include <errno.h>
+#include <time.h>
+#endif
+#ifdef ERRCHECK_ENABLE_TIME_SOURCE
+#include "err_time.h"
+#endif
 
-// Initialize the global context structure
-failure_context_t g_error_context = {
-    .code = ERR_SUCCESS,
-    .inner_code = 0,
-    .file = NULL,
-    .line = 0,
-    .logged_to_nvram = false
+#include "err_history.h"    // errcheck_record_t, also without the history ring
+#ifdef ERRCHECK_ENABLE_RETAINED_RING
+#include "err_retained.h"
+#endif
+#ifdef ERRCHECK_ENABLE_SKETCH
+#include "err_sketch.h"
+#endif
+#ifdef ERRCHECK_ENABLE_ANOMALY
+#include "err_anomaly.h"
+#endif
+#ifdef ERRCHECK_ENABLE_PERSIST_COUNTERS
+#include "err_counters.h"
+#endif
+
+#define ERRCHECK_CONTEXT_INIT {                               \
+    .code = ERR_SUCCESS,                                     \
+    .inner_code = 0,                                         \
+    .file = NULL,                                            \
+    .line = 0,                                               \
+    .logged_to_nvram = false                                 \
+}
+
+#ifdef ERRCHECK_ENABLE_PER_CORE
+// One context per core, each on its own cache line (see err_core.h)
+errcheck_core_context_t g_errcheck_core_context[ERRCHECK_CORES] = {
+    [0 ... ERRCHECK_CORES - 1] = { .ctx = ERRCHECK_CONTEXT_INIT }
 };
+#else
+// Initialize the global context structure
+failure_context_t g_error_context = ERRCHECK_CONTEXT_INIT;
+#endif
 
 #ifdef ERRCHECK_ENABLE_RUNTIME_INJECTION
 // Global variable for debugger-controlled fault injection
 volatile uint8_t g_inject_error_flag = 0;
 #endif
 
+#if defined(__unix__) && defined(__ELF__)
+// Defined only by tools/errcheck_preload.so when it is preloaded: it credits the
+// libc failure it injected to the CHECK site that logged it. Null otherwise.
+extern void errcheck_preload_observed(uint32_t code, const char *file, uint32_t line)
+    __attribute__((weak));
+#endif
+
+
+/**
+ * @brief Hashes a call site into a stable 32-bit identifier (FNV-1a over the file
+ * name, then the line number). Only evaluated on failure paths.
+ */
+uint32_t errcheck_site_id(const char *file, uint32_t line)
+{
+    uint32_t h = 2166136261u;
+
+    if (file != NULL) {
+        while (*file != '\0') {
+            h ^= (uint8_t)*file++;
+            h *= 16777619u;
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        h ^= (uint8_t)(line >> (8 * i));
+        h *= 16777619u;
+    }
+    return h;
+}
 
+/**
+ * @brief Monotonic time in nanoseconds for record timestamps.
+ * * On bare-metal targets replace the fallback with a free-running timer read.
+ */
+uint64_t errcheck_now_ns(void)
+{
+#ifdef ERRCHECK_ENABLE_TIME_SOURCE
+    const errcheck_time_source_t *src = __atomic_load_n(&g_errcheck_time_source, __ATOMIC_ACQUIRE);
+    if (src != NULL) {
+        return src->now_ns(src->ctx);
+    }
+#endif
+#if defined(__unix__)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+        return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+    }
+#endif
+    return 0;
+}
+
+#if defined(ERRCHECK_ENABLE_TIME_SOURCE) || !defined(__unix__)
+// Busy-wait; bare-metal targets without a clock get no delay
+static void errcheck_spin_ns(uint64_t ns)
+{
+    uint64_t until = errcheck_now_ns() + ns;
+
+    while (errcheck_now_ns() < until) {
+    }
+}
+#endif
+
+/**
+ * @brief Waits 'ns' on the same clock (a virtual source just advances).
+ */
+void errcheck_sleep_ns(uint64_t ns)
+{
+#ifdef ERRCHECK_ENABLE_TIME_SOURCE
+    const errcheck_time_source_t *src = __atomic_load_n(&g_errcheck_time_source, __ATOMIC_ACQUIRE);
+    if (src != NULL) {
+        if (src->sleep_ns != NULL) {
+            src->sleep_ns(src->ctx, ns);
+        } else {
+            errcheck_spin_ns(ns);
+        }
+        return;
+    }
+#endif
+#if defined(__unix__)
+    struct timespec ts = {
+        .tv_sec = (time_t)(ns / 1000000000u),
+        .tv_nsec = (long)(ns % 1000000000u),
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        // Interrupted by a signal: sleep the remainder
+    }
+#else
+    errcheck_spin_ns(ns);
+#endif
+}
+
+/**
+ * @brief Hands one record to every enabled sink. Shared by the logging path and
+ * the watchdog's hang records, so both reach the same sinks.
+ */
+void errcheck_sinks_emit(const errcheck_record_t *rec)
+{
+#ifdef ERRCHECK_ENABLE_HISTORY
+    // Append to the history ring first: with the shared-memory flight recorder this
+    // store is the only thing that survives a SIGKILL between here and the NVRAM write.
+    errcheck_history_append(rec);
+#endif
+#ifdef ERRCHECK_ENABLE_SKETCH
+    errcheck_sketch_update(rec->site, rec->inner_code);
+#endif
+#ifdef ERRCHECK_ENABLE_ANOMALY
+    errcheck_anomaly_record(rec->code);
+#endif
+#ifdef ERRCHECK_ENABLE_PERSIST_COUNTERS
+    errcheck_counters_record(rec->code);
+#endif
+#ifdef ERRCHECK_ENABLE_RETAINED_RING
+    // Park the record in retained RAM; errcheck_retained_idle() writes it to flash
+    // later, so the failure path never waits for a flash program/erase cycle.
+    errcheck_retained_push(rec);
+#endif
+    (void)rec;
+}
+
+#ifndef ERRCHECK_HEADER_ONLY
 /**
  * @brief CRITICAL: Logs the current g_error_context to Non-Volatile Memory (NVRAM).
- * * This function MUST be implemented by the user to store the error context persistently
- * before any system reset or halt.
+ * * Filters redundant calls, then hands the context to errcheck_log_to_nvram_commit().
+ * (In the header-only build this function is an inline in errcheck.h.)
  */
 void errcheck_log_to_nvram(void)
 {
+    const failure_context_t *ctx = &g_error_context;
+
     // Prevent double-logging, especially during rollback cleanup sequences
-    if (g_error_context.logged_to_nvram) {
+    if (ctx->logged_to_nvram) {
         return;
     }
     
     // Only log if an actual failure code is present
-    if (g_error_context.code == ERR_SUCCESS) {
+    if (ctx->code == ERR_SUCCESS) {
         return;
     }
 
+    errcheck_log_to_nvram_commit();
+}
+#endif
+
+/**
+ * @brief CRITICAL: Writes the current g_error_context to Non-Volatile Memory (NVRAM).
+ * * This function MUST be implemented by the user to store the error context persistently
+ * before any system reset or halt. Only called by errcheck_log_to_nvram() for a context
+ * that has not been logged yet.
+ */
+void errcheck_log_to_nvram_commit(void)
+{
+    failure_context_t *ctx = &g_error_context; // Resolved once (per-core builds)
+    ERRCHECK_ACCT_START(acct_t);
+    ERRCHECK_USDT4(log, ctx->code, ctx->inner_code, ctx->file, ctx->line);
+#if defined(__unix__) && defined(__ELF__)
+    if (errcheck_preload_observed != NULL) {
+        errcheck_preload_observed(ctx->code, ctx->file, ctx->line);
+    }
+#endif
+
+    errcheck_record_t rec;
+#if defined(ERRCHECK_ENABLE_HISTORY) || defined(ERRCHECK_ENABLE_RETAINED_RING)
+    errcheck_record_from_context(&rec, ctx);
+#else
+    // No record is persisted: the summarising sinks need no timestamp
+    rec = (errcheck_record_t){
+        .site = errcheck_site_id(ctx->file, ctx->line),
+        .inner_code = ctx->inner_code,
+        .line = ctx->line,
+        .code = (uint32_t)ctx->code,
+    };
+#endif
+    ERRCHECK_ACCT_LAP(acct_t, ERRCHECK_ACCT_CAPTURE);
+
+    errcheck_sinks_emit(&rec);
+    ERRCHECK_ACCT_LAP(acct_t, ERRCHECK_ACCT_SINK);
+
+#if defined(ERRCHECK_ENABLE_RETAINED_RING)
+    // The retained ring (a sink) replaces the synchronous NVRAM write below
+#elif defined(ERRCHECK_NVRAM_STUB_SILENT)
+    // Host simulations and benchmarks: keep the logging semantics without console I/O
+#else
     // --- USER REPLACEMENT REQUIRED HERE (NVRAM Write) ---
     // This stub demonstrates the data being captured and written.
     
     printf("\n--- [HARDWARE STUB] NVRAM Logging Triggered! ---\n");
     printf("FAILURE LOGGED: Code=%d, Inner=0x%lX\n",
-           g_error_context.code, 
-           (unsigned long)g_error_context.inner_code);
+           ctx->code, 
+           (unsigned long)ctx->inner_code);
     printf("Source: %s:%lu\n",
-           g_error_context.file ? g_error_context.file : "N/A", 
-           g_error_context.line);
+           ctx->file ? ctx->file : "N/A", 
+           ctx->line);
     // Actual implementation would write the g_error_context struct to hardware.
     // --------------------------------------------------------------------
+#endif
     
-    g_error_context.logged_to_nvram = true;
+    ctx->logged_to_nvram = true;
+    ERRCHECK_ACCT_LAP(acct_t, ERRCHECK_ACCT_LOG);
 }
 
 /* * NOTE: errcheck_print_last_error() is placed in a separate file (err_log.c) 
@@ -14,6 +14,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "err_usdt.h"
 
 /* --- User-defined types and constants --- */
 #ifndef ERR_T
@@ -28,6 +29,17 @@
     #define ERR_SUCCESS ((err_t)0x00)
 #endif
 
+/* --- Thread-local storage qualifier (define empty on single-threaded targets without TLS) --- */
+#ifndef ERRCHECK_THREAD_LOCAL
+    #if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+        #define ERRCHECK_THREAD_LOCAL _Thread_local
+    #elif defined(__GNUC__)
+        #define ERRCHECK_THREAD_LOCAL __thread
+    #else
+        #define ERRCHECK_THREAD_LOCAL
+    #endif
+#endif
+
 /* --- Rich Error Context Structure --- */
 typedef struct {
     err_t code;
@@ -37,32 +49,167 @@ typedef struct {
     bool logged_to_nvram;       // Flag: has this error been written to persistent storage?
 } failure_context_t;
 
-extern failure_context_t g_error_context;
+/* --- Per-core failure state on SMP targets without TLS (see err_core.h) --- */
+#ifdef ERRCHECK_ENABLE_PER_CORE
+    #ifndef ERRCHECK_CORES
+        #define ERRCHECK_CORES      2u
+    #endif
+    #ifndef ERRCHECK_CACHE_LINE
+        #define ERRCHECK_CACHE_LINE 64u
+    #endif
+    // Starts a type on its own cache line and pads it to whole lines
+    #define ERRCHECK_CORE_ALIGNED __attribute__((aligned(ERRCHECK_CACHE_LINE)))
+
+    // REQUIRED (user): index of the calling core, 0 .. ERRCHECK_CORES-1. Called on
+    // failure paths only; a core-ID register read (MPIDR, mhartid, SIO CPUID) suffices.
+    extern uint32_t errcheck_core_id(void);
+
+    typedef struct {
+        failure_context_t ctx;
+    } ERRCHECK_CORE_ALIGNED errcheck_core_context_t;
+
+    extern errcheck_core_context_t g_errcheck_core_context[ERRCHECK_CORES];
+    // Every use of g_error_context names the calling core's context
+    #define g_error_context (g_errcheck_core_context[errcheck_core_id()].ctx)
+#else
+    #define ERRCHECK_CORE_ALIGNED
+    extern failure_context_t g_error_context;
+#endif
+
 extern const char* app_error_to_string(err_t code);
 
+/* --- Severity metadata for error codes (used by err_uplink.c) --- */
+typedef enum {
+    ERRCHECK_SEV_INFO = 0,
+    ERRCHECK_SEV_WARNING,
+    ERRCHECK_SEV_ERROR,
+    ERRCHECK_SEV_CRITICAL       // Mission or safety impact: always uploaded first
+} errcheck_severity_t;
+
+// Implemented by applications that link err_uplink.c (see app/app_error_strings.c)
+extern errcheck_severity_t app_error_severity(err_t code);
+
 /* Function prototypes */
-void errcheck_log_to_nvram(void);
+void errcheck_log_to_nvram_commit(void); // Persists g_error_context (called once per failure)
 void errcheck_print_last_error(void); // For console debugging (implementation in err_log.c)
+void errcheck_print_metrics(void);    // Library health/metrics block (implementation in err_log.c)
+
+// Compact 32-bit identifier of a guarded call site (hash of file name and line).
+// Persisted records carry this instead of the __FILE__ pointer, which is meaningless
+// outside the running image.
+uint32_t errcheck_site_id(const char *file, uint32_t line);
+
+// Monotonic timestamp in nanoseconds used to stamp persisted records (0 if no clock).
+uint64_t errcheck_now_ns(void);
+// Waits on the same clock. Both follow the installed time source (see err_time.h).
+void errcheck_sleep_ns(uint64_t ns);
+
+// Logs g_error_context once: skips contexts already logged or holding ERR_SUCCESS.
+// The header-only build (errcheck_single.h) inlines these checks into every call
+// site, so a redundant call from a cleanup label costs a load and a branch.
+#ifdef ERRCHECK_HEADER_ONLY
+static inline void errcheck_log_to_nvram(void)
+{
+    const failure_context_t *ctx = &g_error_context;
+
+    if (ctx->logged_to_nvram || ctx->code == ERR_SUCCESS) {
+        return;
+    }
+    errcheck_log_to_nvram_commit();
+}
+#else
+void errcheck_log_to_nvram(void);
+#endif
+
+
+/* --- In-flight registry around guarded calls (see err_watchdog.h) --- */
+#ifdef ERRCHECK_ENABLE_WATCHDOG
+    // Call that was in flight on this thread before the current one (nesting)
+    typedef struct {
+        const char *file;
+        uint32_t line;
+        uint64_t enter_ns;
+    } errcheck_call_frame_t;
+
+    void errcheck_call_enter(errcheck_call_frame_t *outer, const char *file, uint32_t line);
+    void errcheck_call_exit(const errcheck_call_frame_t *outer);
+
+    #define ERRCHECK_CALL_ENTER()                                          \
+        errcheck_call_frame_t __call_frame;                                \
+        errcheck_call_enter(&__call_frame, __FILE__, __LINE__)
+    #define ERRCHECK_CALL_EXIT()  errcheck_call_exit(&__call_frame)
+#else
+    #define ERRCHECK_CALL_ENTER() do { } while (0)
+    #define ERRCHECK_CALL_EXIT()  do { } while (0)
+#endif
+
+/* --- Rule-based injection point after each guarded call (see err_inject.h) --- */
+#ifdef ERRCHECK_ENABLE_INJECT
+    extern uint32_t g_errcheck_inject_armed;
+    int errcheck_inject_eval(uint32_t code, const char *file, uint32_t line, int result);
+
+    #define ERRCHECK_INJECT_POINT(err_flag, result) do {                   \
+        if (__atomic_load_n(&g_errcheck_inject_armed, __ATOMIC_RELAXED)) { \
+            (result) = errcheck_inject_eval((uint32_t)(err_flag),          \
+                                            __FILE__, __LINE__, (result)); \
+        }                                                                  \
+    } while (0)
+#else
+    #define ERRCHECK_INJECT_POINT(err_flag, result) do { } while (0)
+#endif
+
+/* --- Static table of guarded call sites (read by tools/errcheck_campaign) --- */
+#if defined(ERRCHECK_ENABLE_SITE_TABLE) && defined(__GNUC__)
+    // One record per CHECK()/GOTO_CHECK() in section "errcheck_sites"; err_flag
+    // must be a constant expression. Costs only image size, no code.
+    typedef struct {
+        const char *file;
+        const char *func;           // Enclosing function (__func__)
+        uint32_t line;
+        uint32_t code;
+    } errcheck_site_t;
+
+    #define ERRCHECK_SITE_RECORD(err_flag)                                 \
+        static const errcheck_site_t __errcheck_site                       \
+            __attribute__((used, section("errcheck_sites"), aligned(8))) = \
+            { __FILE__, __func__, __LINE__, (uint32_t)(err_flag) }
+#else
+    #define ERRCHECK_SITE_RECORD(err_flag) do { } while (0)
+#endif
 
 
 /* ========================================================================= */
 /* Core Macros (Captures Context and Triggers Logging)                       */
 /* ========================================================================= */
 
+// Captures the failing site into g_error_context (resolved once, so a per-core
+// build reads the core ID once for all five fields)
+#define ERRCHECK_SET_CONTEXT(err_flag, inner_val) do {       \
+    failure_context_t *__ctx = &g_error_context;             \
+    __ctx->code = (err_flag);                                \
+    __ctx->inner_code = (inner_val);                         \
+    __ctx->file = __FILE__;                                  \
+    __ctx->line = __LINE__;                                  \
+    __ctx->logged_to_nvram = false;                          \
+} while (0)
+
 // Macro to set context and return ERR_FAILURE immediately (Simple Fail-Fast)
 // CRITICAL: This helper ensures NVRAM logging and context capture occur on return.
 #define RETURN_ERR_AND_CONTEXT(err_flag, inner_val) do {     \
-    g_error_context.code = (err_flag);                       \
-    g_error_context.inner_code = (inner_val);                \
-    g_error_context.file = __FILE__;                         \
-    g_error_context.line = __LINE__;                         \
+    ERRCHECK_SET_CONTEXT((err_flag), (inner_val));           \
+    ERRCHECK_USDT4(check_fail, (err_flag), (inner_val),      \
+                   __FILE__, __LINE__);                      \
     errcheck_log_to_nvram();                                 \
     return ERR_FAILURE;                                      \
 } while (0)
 
 // 1. STANDARD CHECK: Fail-Fast (for functions NOT needing rollback cleanup)
 #define CHECK(call, err_flag) do {                           \
+    ERRCHECK_SITE_RECORD(err_flag);                          \
+    ERRCHECK_CALL_ENTER();                                   \
     int __result = (call);                                   \
+    ERRCHECK_INJECT_POINT((err_flag), __result);             \
+    ERRCHECK_CALL_EXIT();                                    \
     if (__result == 0) {                                     \
         RETURN_ERR_AND_CONTEXT((err_flag), 0);               \
     }                                                        \
@@ -72,12 +219,15 @@ void errcheck_print_last_error(void); // For console debugging (implementation i
 // On failure, sets context, DOES NOT return, and jumps to a specific cleanup label.
 // NOTE: NVRAM logging must be called manually at the 'exit' or 'cleanup' label.
 #define GOTO_CHECK(call, err_flag, label) do {               \
+    ERRCHECK_SITE_RECORD(err_flag);                          \
+    ERRCHECK_CALL_ENTER();                                   \
     int __result = (call);                                   \
+    ERRCHECK_INJECT_POINT((err_flag), __result);             \
+    ERRCHECK_CALL_EXIT();                                    \
     if (__result == 0) {                                     \
-        g_error_context.code = (err_flag);                   \
-        g_error_context.inner_code = 0;                      \
-        g_error_context.file = __FILE__;                     \
-        g_error_context.line = __LINE__;                     \
+        ERRCHECK_SET_CONTEXT((err_flag), 0);                 \
+        ERRCHECK_USDT4(check_fail, (err_flag), 0,            \
+                       __FILE__, __LINE__);                  \
         goto label;                                          \
     }                                                        \
 } while (0)
@@ -93,8 +243,15 @@ void errcheck_print_last_error(void); // For console debugging (implementation i
     
     // Redefined CHECK for runtime injection
     #define CHECK(call, err_flag) do {                                    \
+        ERRCHECK_SITE_RECORD(err_flag);                                   \
+        ERRCHECK_CALL_ENTER();                                            \
         int __result = (call);                                            \
+        ERRCHECK_INJECT_POINT((err_flag), __result);                      \
+        ERRCHECK_CALL_EXIT();                                             \
         if (__result == 0 || g_inject_error_flag == (err_flag)) {         \
+            if (g_inject_error_flag == (err_flag)) {                      \
+                ERRCHECK_USDT3(inject, (err_flag), __FILE__, __LINE__);   \
+            }                                                             \
             g_inject_error_flag = 0;                                      \
             RETURN_ERR_AND_CONTEXT((err_flag), (uint32_t)__result);       \
         }                                                                 \
@@ -102,12 +259,18 @@ void errcheck_print_last_error(void); // For console debugging (implementation i
 
     // Redefined GOTO_CHECK for runtime injection
     #define GOTO_CHECK(call, err_flag, label) do {                        \
+        ERRCHECK_SITE_RECORD(err_flag);                                   \
+        ERRCHECK_CALL_ENTER();                                            \
         int __result = (call);                                            \
+        ERRCHECK_INJECT_POINT((err_flag), __result);                      \
+        ERRCHECK_CALL_EXIT();                                             \
         if (__result == 0 || g_inject_error_flag == (err_flag)) {         \
-            g_error_context.code = (err_flag);                            \
-            g_error_context.inner_code = (uint32_t)__result;              \
-            g_error_context.file = __FILE__;                              \
-            g_error_context.line = __LINE__;                              \
+            if (g_inject_error_flag == (err_flag)) {                      \
+                ERRCHECK_USDT3(inject, (err_flag), __FILE__, __LINE__);   \
+            }                                                             \
+            ERRCHECK_SET_CONTEXT((err_flag), (uint32_t)__result);         \
+            ERRCHECK_USDT4(check_fail, (err_flag), (uint32_t)__result,    \
+                           __FILE__, __LINE__);                           \
             g_inject_error_flag = 0;                                      \
             goto label;                                                   \
         }                                                                 \
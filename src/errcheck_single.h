@@ -0,0 +1,146 @@
+/**
+ * =============================================================================
+ * errcheck_single.h
+ * Amalgamated, header-only configuration of errcheck.
+ * =============================================================================
+ * Usage: include this header everywhere instead of errcheck.h, and in exactly
+ * one translation unit define the implementation first:
+ *
+ *     #define ERRCHECK_IMPLEMENTATION
+ *     #include "errcheck_single.h"
+ *
+ * Do not also compile or link the .c files in src/ in this configuration. Feature
+ * flags (ERRCHECK_ENABLE_*) must be identical in every translation unit. The
+ * telemetry encoder and upload scheduler, which are not logging sinks, are
+ * pulled in with ERRCHECK_ENABLE_TELEMETRY (the scheduler needs the
+ * application's app_error_severity()).
+ * * What it buys: errcheck_log_to_nvram() becomes an inline in errcheck.h, so the
+ * "already logged?" / "success code?" checks are folded into each failing site
+ * (RETURN_ERR_AND_CONTEXT() makes both compile-time known) and a redundant call
+ * from a cleanup label no longer costs an out-of-line call. The implementation
+ * TU also sees the whole library, so the compiler can inline the record
+ * helpers into errcheck_log_to_nvram_commit(). See bench/bench_amalgamation.c.
+ * * NOTE: With strict -std=c99/-std=c11 on POSIX hosts, pass
+ * -D_POSIX_C_SOURCE=200809L on the command line: the implementation sources
+ * are included after your own system headers.
+ * =============================================================================
+ */
+
+#ifndef ERRCHECK_SINGLE_H
+#define ERRCHECK_SINGLE_H
+
+#ifndef ERRCHECK_HEADER_ONLY
+    #define ERRCHECK_HEADER_ONLY 1
+#endif
+
+#include "errcheck.h"
+#include "err_acct.h"
+#ifdef ERRCHECK_ENABLE_TIME_SOURCE
+    #include "err_time.h"
+#endif
+#ifdef ERRCHECK_ENABLE_PER_CORE
+    #include "err_core.h"
+#endif
+#if defined(ERRCHECK_ENABLE_HISTORY) || defined(ERRCHECK_ENABLE_RETAINED_RING) \
+    || defined(ERRCHECK_ENABLE_TELEMETRY)
+    #include "err_attach.h"
+    #include "err_history.h"
+#endif
+#ifdef ERRCHECK_ENABLE_RETAINED_RING
+    #include "err_retained.h"
+#endif
+#ifdef ERRCHECK_ENABLE_SKETCH
+    #include "err_sketch.h"
+#endif
+#ifdef ERRCHECK_ENABLE_ANOMALY
+    #include "err_anomaly.h"
+#endif
+#ifdef ERRCHECK_ENABLE_PERSIST_COUNTERS
+    #include "err_counters.h"
+#endif
+#ifdef ERRCHECK_ENABLE_MINIDUMP
+    #include "err_minidump.h"
+#endif
+#ifdef ERRCHECK_ENABLE_WATCHDOG
+    #include "err_watchdog.h"
+#endif
+#ifdef ERRCHECK_ENABLE_INJECT
+    #include "err_inject.h"
+#endif
+#ifdef ERRCHECK_ENABLE_ALLOC
+    #include "err_alloc.h"
+#endif
+#ifdef ERRCHECK_ENABLE_CTL
+    #include "err_ctl.h"
+#endif
+#ifdef ERRCHECK_ENABLE_TELEMETRY
+    #include "err_telemetry.h"
+    #include "err_uplink.h"
+#endif
+#if defined(ERRCHECK_ENABLE_RETAINED_RING) || defined(ERRCHECK_ENABLE_TELEMETRY) \
+    || defined(ERRCHECK_ENABLE_PERSIST_COUNTERS)
+    #include "err_crc32c.h"
+#endif
+
+#endif /* ERRCHECK_SINGLE_H */
+
+
+/* ========================================================================= */
+/* Implementation (exactly one translation unit)                             */
+/* ========================================================================= */
+#if defined(ERRCHECK_IMPLEMENTATION) && !defined(ERRCHECK_SINGLE_IMPLEMENTED)
+#define ERRCHECK_SINGLE_IMPLEMENTED
+
+#include "errcheck.c"
+#include "err_log.c"
+#ifdef ERRCHECK_ENABLE_SELF_ACCOUNTING
+    #include "err_acct.c"
+#endif
+#ifdef ERRCHECK_ENABLE_TIME_SOURCE
+    #include "err_time.c"
+#endif
+#ifdef ERRCHECK_ENABLE_PER_CORE
+    #include "err_core.c"
+#endif
+#if defined(ERRCHECK_ENABLE_HISTORY) || defined(ERRCHECK_ENABLE_RETAINED_RING) \
+    || defined(ERRCHECK_ENABLE_TELEMETRY)
+    #include "err_attach.c"
+    #include "err_history.c"
+#endif
+#ifdef ERRCHECK_ENABLE_RETAINED_RING
+    #include "err_retained.c"
+#endif
+#ifdef ERRCHECK_ENABLE_SKETCH
+    #include "err_sketch.c"
+#endif
+#ifdef ERRCHECK_ENABLE_ANOMALY
+    #include "err_anomaly.c"
+#endif
+#ifdef ERRCHECK_ENABLE_PERSIST_COUNTERS
+    #include "err_counters.c"
+#endif
+#ifdef ERRCHECK_ENABLE_MINIDUMP
+    #include "err_minidump.c"
+#endif
+#ifdef ERRCHECK_ENABLE_WATCHDOG
+    #include "err_watchdog.c"
+#endif
+#ifdef ERRCHECK_ENABLE_INJECT
+    #include "err_inject.c"
+#endif
+#ifdef ERRCHECK_ENABLE_ALLOC
+    #include "err_alloc.c"
+#endif
+#ifdef ERRCHECK_ENABLE_CTL
+    #include "err_ctl.c"
+#endif
+#ifdef ERRCHECK_ENABLE_TELEMETRY
+    #include "err_telemetry.c"
+    #include "err_uplink.c"
+#endif
+#if defined(ERRCHECK_ENABLE_RETAINED_RING) || defined(ERRCHECK_ENABLE_TELEMETRY) \
+    || defined(ERRCHECK_ENABLE_PERSIST_COUNTERS)
+    #include "err_crc32c.c"
+#endif
+
+#endif /* ERRCHECK_IMPLEMENTATION */
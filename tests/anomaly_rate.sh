@@ -0,0 +1,51 @@
+#!/bin/sh
+# =============================================================================
+# tests/anomaly_rate.sh
+# * Trains the anomaly detector on a high, noisy baseline (about 490 failures
+# * per tick, sigma about 300) and checks that a 20000-failure burst still
+# * raises an alarm: sigma must not saturate once it passes 256 per tick.
+# * Usage: sh tests/anomaly_rate.sh   (from the repository root; needs gcc)
+# =============================================================================
+set -eu
+
+CC=${CC:-gcc}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+cat > "$dir/rate.c" <<'SRC'
+#include <stdio.h>
+#include "err_anomaly.h"
+
+#define CODE 5u
+
+int main(void)
+{
+    static const uint32_t baseline[4] = { 190u, 790u, 190u, 790u };
+    errcheck_anomaly_slot_t st;
+
+    for (uint32_t t = 0; t < 200u; t++) {
+        for (uint32_t i = 0; i < baseline[t % 4u]; i++) {
+            errcheck_anomaly_record(CODE);
+        }
+        errcheck_anomaly_tick();
+    }
+    errcheck_anomaly_get(CODE, &st);
+    uint32_t before = st.alarms;
+    for (uint32_t i = 0; i < 20000u; i++) {
+        errcheck_anomaly_record(CODE);
+    }
+    errcheck_anomaly_get(CODE, &st);
+    printf("mean %u sigma %u fire_at %u burst alarms %u\n", (unsigned)(st.mean_q16 >> 16),
+           (unsigned)(errcheck_anomaly_sigma_q16(&st) >> 16), (unsigned)st.fire_at,
+           (unsigned)(st.alarms - before));
+    return (st.alarms - before == 1u && st.fire_at < 20000u) ? 0 : 1;
+}
+SRC
+
+$CC -D ERRCHECK_ENABLE_ANOMALY -I src "$dir/rate.c" src/err_anomaly.c -o "$dir/rate"
+if "$dir/rate"; then
+    echo "PASS: anomaly_rate"
+else
+    echo "FAIL: a burst over a high-rate baseline raised no alarm"
+    exit 1
+fi
@@ -0,0 +1,66 @@
+#!/bin/sh
+# =============================================================================
+# tests/decode_noise.sh
+# * Feeds tools/errcheck_decode a capture that opens with a false frame start
+# * (sync bytes followed by a large length byte) and checks that every real
+# * frame behind it is still decoded: from a file, and in follow mode while the
+# * link stays open with no further bytes.
+# * Usage: sh tests/decode_noise.sh   (from the repository root; needs gcc)
+# =============================================================================
+set -eu
+
+CC=${CC:-gcc}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+cat > "$dir/gen.c" <<'SRC'
+#include <stdio.h>
+#include "err_telemetry.h"
+
+// Three frames of one entry each, behind "EC 7E F0": a sync claiming 240 bytes
+int main(void)
+{
+    static const uint8_t noise[] = { ERRCHECK_TLM_SYNC0, ERRCHECK_TLM_SYNC1, 0xF0u };
+    errcheck_tlm_encoder_t enc = { 7, 0 };
+    uint8_t frame[ERRCHECK_TLM_MIN_FRAME];
+
+    fwrite(noise, 1, sizeof(noise), stdout);
+    for (uint32_t i = 0; i < 3u; i++) {
+        errcheck_record_t rec = { .site = 0x1234u + i, .inner_code = i, .line = 10u,
+                                  .timestamp_ns = (uint64_t)(i + 1u) * 1000000u, .code = 3u };
+        size_t consumed;
+        size_t len = errcheck_tlm_encode(&enc, &rec, 1, frame, sizeof(frame), &consumed);
+        fwrite(frame, 1, len, stdout);
+    }
+    return 0;
+}
+SRC
+
+$CC -I src "$dir/gen.c" src/err_telemetry.c src/err_crc32c.c -o "$dir/gen"
+$CC -I src tools/errcheck_decode.c tools/errcheck_ecol.c src/err_telemetry.c \
+    src/err_crc32c.c -o "$dir/errcheck_decode"
+"$dir/gen" > "$dir/capture.bin"
+
+status=0
+frames=$("$dir/errcheck_decode" "$dir/capture.bin" 2>/dev/null | grep -c '^frame' || true)
+if [ "$frames" != 3 ]; then
+    echo "FAIL: decoded $frames frame(s) behind the noise, expected 3"
+    status=1
+fi
+# Follow a pipe that stays open: the frames must show up without more input
+mkfifo "$dir/link"
+"$dir/errcheck_decode" -f < "$dir/link" > "$dir/follow.txt" 2>/dev/null &
+pid=$!
+exec 3> "$dir/link"
+cat "$dir/capture.bin" >&3
+sleep 1
+frames=$(grep -c '^frame' "$dir/follow.txt" || true)
+kill -INT $pid 2>/dev/null || true
+exec 3>&-
+wait $pid || true
+if [ "$frames" != 3 ]; then
+    echo "FAIL: follow mode showed $frames frame(s) behind the noise, expected 3"
+    status=1
+fi
+[ $status -eq 0 ] && echo "PASS: decode_noise"
+exit $status
@@ -0,0 +1,29 @@
+#!/bin/sh
+# =============================================================================
+# tests/minidump_overflow.sh
+# * Overflows the stack of a worker thread (not the one that installed the
+# * writer) in examples/minidump_crash.c and checks that a complete SIGSEGV
+# * dump was still written: each thread needs its own alternate signal stack.
+# * Usage: sh tests/minidump_overflow.sh   (from the repository root; Linux, gcc)
+# =============================================================================
+set -eu
+
+CC=${CC:-gcc}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+$CC -g -pthread -D ERRCHECK_ENABLE_MINIDUMP -D ERRCHECK_ENABLE_HISTORY \
+    -D ERRCHECK_NVRAM_STUB_SILENT examples/minidump_crash.c src/errcheck.c \
+    src/err_minidump.c src/err_history.c app/app_error_strings.c -o "$dir/minidump_crash"
+$CC -O2 -I src tools/errcheck_minidump.c src/err_history.c src/err_attach.c \
+    src/errcheck.c -o "$dir/errcheck_minidump"
+
+(ulimit -c 0; "$dir/minidump_crash" "$dir/gw.dmp" overflow) > /dev/null 2>&1 || true
+if "$dir/errcheck_minidump" "$dir/gw.dmp" > "$dir/report.txt" 2>&1 \
+   && grep -q 'SIGSEGV' "$dir/report.txt" && grep -q '^dump written' "$dir/report.txt"; then
+    echo "PASS: minidump_overflow"
+else
+    echo "FAIL: no complete dump of a worker's stack overflow"
+    cat "$dir/report.txt"
+    exit 1
+fi
@@ -0,0 +1,54 @@
+#!/bin/sh
+# =============================================================================
+# tests/preload_report.sh
+# * Runs one injected CHECK() with and without tools/errcheck_preload.so loaded
+# * and checks that ERRCHECK_INJECT_REPORT says "fired 1" both times: the shim's
+# * own copy of err_inject.c must neither arm the rules nor rewrite the report.
+# * Usage: sh tests/preload_report.sh   (from the repository root; needs gcc)
+# =============================================================================
+set -eu
+
+CC=${CC:-gcc}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+cat > "$dir/target.c" <<'SRC'
+#include <stdio.h>
+#include "errcheck.h"
+
+static int sensor_ready(void) { return 1; }
+
+static err_t probe(void)
+{
+    CHECK(sensor_ready(), 7);
+    return ERR_SUCCESS;
+}
+
+int main(void)
+{
+    return probe() == ERR_FAILURE ? 0 : 1;
+}
+SRC
+
+$CC -D ERRCHECK_ENABLE_INJECT -D ERRCHECK_NVRAM_STUB_SILENT -I src "$dir/target.c" \
+    src/err_inject.c src/errcheck.c -o "$dir/target" 2>/dev/null
+$CC -shared -fPIC -fvisibility=hidden -O2 -D ERRCHECK_ENABLE_INJECT -D ERRCHECK_INJECT_NO_ENV \
+    -D ERRCHECK_NVRAM_STUB_SILENT -I src tools/errcheck_preload.c src/err_inject.c \
+    src/errcheck.c -ldl -o "$dir/errcheck_preload.so" 2>/dev/null
+
+status=0
+for preload in "" "$dir/errcheck_preload.so"; do
+    rm -f "$dir/report"
+    if ! ERRCHECK_INJECT="code=7" ERRCHECK_INJECT_REPORT="$dir/report" \
+         ERRCHECK_PRELOAD_LOG=/dev/null LD_PRELOAD="$preload" "$dir/target"; then
+        echo "FAIL: injection did not fail the check (preload='${preload}')"
+        status=1
+    fi
+    got=$(cat "$dir/report" 2>/dev/null || echo "no report")
+    if [ "$got" != "fired 1" ]; then
+        echo "FAIL: report '$got', expected 'fired 1' (preload='${preload}')"
+        status=1
+    fi
+done
+[ $status -eq 0 ] && echo "PASS: preload_report"
+exit $status
@@ -0,0 +1,1017 @@
+/**
+ * =============================================================================
+ * tools/errcheck_campaign.c
+ * * Host tool: incremental fault-injection campaign. Forces each CHECK() site of
+ * * a program to fail once, in its own run, and records the outcome per site
+ * * together with a hash of the object code that can influence it. Later runs
+ * * only re-explore the sites whose hash changed.
+ * * Sites come from the "errcheck_sites" section the program is built with
+ * * (-D ERRCHECK_ENABLE_SITE_TABLE -D ERRCHECK_ENABLE_INJECT). Each run gets
+ * * ERRCHECK_INJECT="site=0x... once" (see err_inject.h) in its environment.
+ * * Code hash of a site: the enclosing function (and its .part/.cold clones)
+ * * plus every function it transitively calls, hashed from the linked image
+ * * with relocated fields masked out. Targets are hashed by name, and data
+ * * targets by content, so code that merely moved does not count as changed.
+ * * This needs the link-time relocations: compile with -ffunction-sections (so
+ * * calls between functions of one file are relocated too) and link with
+ * * -Wl,--emit-relocs. Without them the whole text is hashed and any code
+ * * change re-explores every site.
+ * * Outcomes:  exit:N  signal:N  timeout  unreached (the site never executed)
+ * * Cache: a text file, one "site hash outcome" line per site, replaced
+ * * atomically. It is discarded when the command line or timeout changes.
+ * * Build: gcc -O2 -I src tools/errcheck_campaign.c src/errcheck.c \
+ * *        -D ERRCHECK_NVRAM_STUB_SILENT -o errcheck_campaign
+ * * Usage: errcheck_campaign [-c cache] [-t seconds] [-e elf] [-f] [-v] \
+ * *        program [args...]
+ * *   -c  cache file (default errcheck_campaign.cache)
+ * *   -t  per-run timeout, default 10 s
+ * *   -e  image to analyse when 'program' is a wrapper (emulator, script)
+ * *   -f  ignore the cache and explore every site
+ * *   -v  keep the program's stdout/stderr
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L // nanosleep(), setenv(), mkstemp()
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "errcheck.h"
+
+#define CAMPAIGN_MAGIC      "errcheck-campaign 1"
+#define DATA_WINDOW         64u         // Bytes hashed at an anonymous data target
+#define OBJECT_MAX          4096u       // Bytes hashed of a named data object
+
+typedef struct {
+    const char *name;
+    uint32_t type, link, info;
+    uint64_t flags, addr, off, size, entsize;
+} sec_t;
+
+typedef struct {
+    const char *name;
+    uint64_t value, size;
+    uint16_t shndx;
+    uint8_t type, bind;
+} sym_t;
+
+typedef struct {
+    uint64_t off;               // Virtual address of the relocated field
+    uint32_t type, sym;
+    int64_t addend;
+    bool rela;
+} rel_t;
+
+typedef struct {
+    const char *name;
+    const char *file;           // STT_FILE of a local symbol, NULL for globals
+    uint64_t addr, size, own, full;
+    uint32_t *callees, ncallees, cap;
+    uint32_t visit;
+} func_t;
+
+typedef struct {
+    uint32_t id, line, code;
+    const char *file, *func;
+    uint64_t hash;              // 0: enclosing code unknown, always explored
+} site_t;
+
+typedef struct {
+    uint32_t id;
+    uint64_t hash;
+    char outcome[24];
+} entry_t;
+
+// Image being analysed
+static uint8_t *s_img;
+static size_t s_img_size;
+static bool s_elf64;
+static uint16_t s_machine;
+static sec_t *s_secs;
+static uint32_t s_nsecs;
+static sym_t *s_syms;
+static uint32_t s_nsyms;
+static rel_t *s_code_rels, *s_dyn_rels;
+static size_t s_ncode_rels, s_ndyn_rels;
+static func_t *s_funcs;
+static uint32_t s_nfuncs, s_visit;
+
+/* ========================================================================= */
+/* Hashing                                                                   */
+/* ========================================================================= */
+static uint64_t fnv64(uint64_t h, const void *p, size_t n)
+{
+    const uint8_t *b = p;
+
+    while (n-- > 0) {
+        h ^= *b++;
+        h *= 0x100000001B3ull;
+    }
+    return h;
+}
+
+static uint64_t fnv64_u64(uint64_t h, uint64_t v)
+{
+    return fnv64(h, &v, sizeof(v));
+}
+
+static uint64_t fnv64_str(uint64_t h, const char *s)
+{
+    return fnv64(h, s, strlen(s) + 1u);
+}
+
+#define FNV64_INIT 0xCBF29CE484222325ull
+
+/* ========================================================================= */
+/* ELF image                                                                 */
+/* ========================================================================= */
+static bool in_image(uint64_t off, uint64_t len)
+{
+    return off <= s_img_size && len <= s_img_size - off;
+}
+
+static uint64_t rd(uint64_t off, unsigned width)
+{
+    uint64_t v = 0;
+
+    memcpy(&v, s_img + off, width);     // Little-endian host and image
+    return v;
+}
+
+// File bytes behind [addr, addr + len), or NULL if not all of them are in the file
+static const uint8_t *vaddr_ptr(uint64_t addr, uint64_t len)
+{
+    for (uint32_t i = 1; i < s_nsecs; i++) {
+        const sec_t *s = &s_secs[i];
+        if ((s->flags & SHF_ALLOC) == 0 || s->type == SHT_NOBITS
+            || addr < s->addr || addr - s->addr >= s->size) {
+            continue;
+        }
+        uint64_t rel = addr - s->addr;
+        return (len <= s->size - rel) ? s_img + s->off + rel : NULL;
+    }
+    return NULL;
+}
+
+static const char *vaddr_str(uint64_t addr)
+{
+    for (uint32_t i = 1; i < s_nsecs; i++) {
+        const sec_t *s = &s_secs[i];
+        if ((s->flags & SHF_ALLOC) != 0 && s->type != SHT_NOBITS
+            && addr >= s->addr && addr - s->addr < s->size) {
+            const char *p = (const char *)s_img + s->off + (addr - s->addr);
+            return memchr(p, '\0', s->size - (addr - s->addr)) != NULL ? p : NULL;
+        }
+    }
+    return NULL;
+}
+
+static const sec_t *find_section(const char *name)
+{
+    for (uint32_t i = 1; i < s_nsecs; i++) {
+        if (strcmp(s_secs[i].name, name) == 0) {
+            return &s_secs[i];
+        }
+    }
+    return NULL;
+}
+
+static int load_sections(void)
+{
+    uint64_t shoff;
+    uint32_t shentsize, shstrndx;
+
+    if (s_elf64) {
+        Elf64_Ehdr eh;
+        memcpy(&eh, s_img, sizeof(eh));
+        s_machine = eh.e_machine;
+        shoff = eh.e_shoff;
+        shentsize = eh.e_shentsize;
+        s_nsecs = eh.e_shnum;
+        shstrndx = eh.e_shstrndx;
+    } else {
+        Elf32_Ehdr eh;
+        memcpy(&eh, s_img, sizeof(eh));
+        s_machine = eh.e_machine;
+        shoff = eh.e_shoff;
+        shentsize = eh.e_shentsize;
+        s_nsecs = eh.e_shnum;
+        shstrndx = eh.e_shstrndx;
+    }
+    if (s_nsecs == 0 || shstrndx >= s_nsecs || !in_image(shoff, (uint64_t)s_nsecs * shentsize)
+        || shentsize < (s_elf64 ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr))) {
+        return -1;
+    }
+    s_secs = calloc(s_nsecs, sizeof(*s_secs));
+    if (s_secs == NULL) {
+        return -1;
+    }
+    uint32_t name_off[s_nsecs];
+    for (uint32_t i = 0; i < s_nsecs; i++) {
+        const uint8_t *p = s_img + shoff + (uint64_t)i * shentsize;
+        sec_t *s = &s_secs[i];
+        if (s_elf64) {
+            Elf64_Shdr sh;
+            memcpy(&sh, p, sizeof(sh));
+            *s = (sec_t){ NULL, sh.sh_type, sh.sh_link, sh.sh_info, sh.sh_flags, sh.sh_addr,
+                          sh.sh_offset, sh.sh_size, sh.sh_entsize };
+            name_off[i] = sh.sh_name;
+        } else {
+            Elf32_Shdr sh;
+            memcpy(&sh, p, sizeof(sh));
+            *s = (sec_t){ NULL, sh.sh_type, sh.sh_link, sh.sh_info, sh.sh_flags, sh.sh_addr,
+                          sh.sh_offset, sh.sh_size, sh.sh_entsize };
+            name_off[i] = sh.sh_name;
+        }
+        if (s->type != SHT_NOBITS && !in_image(s->off, s->size)) {
+            return -1;
+        }
+    }
+    const sec_t *strs = &s_secs[shstrndx];
+    for (uint32_t i = 0; i < s_nsecs; i++) {
+        const char *n = (const char *)s_img + strs->off + name_off[i];
+        bool ok = name_off[i] < strs->size && memchr(n, '\0', strs->size - name_off[i]) != NULL;
+        s_secs[i].name = ok ? n : "";
+    }
+    return 0;
+}
+
+static const char *strtab_name(const sec_t *strtab, uint32_t off)
+{
+    const char *n = (const char *)s_img + strtab->off + off;
+
+    return (off < strtab->size && memchr(n, '\0', strtab->size - off) != NULL) ? n : "";
+}
+
+static int load_symbols(void)
+{
+    const sec_t *symtab = find_section(".symtab");
+
+    if (symtab == NULL || symtab->link >= s_nsecs || symtab->entsize == 0) {
+        return -1;
+    }
+    const sec_t *strtab = &s_secs[symtab->link];
+    s_nsyms = (uint32_t)(symtab->size / symtab->entsize);
+    s_syms = calloc(s_nsyms, sizeof(*s_syms));
+    s_funcs = calloc(s_nsyms, sizeof(*s_funcs));
+    if (s_syms == NULL || s_funcs == NULL) {
+        return -1;
+    }
+
+    // Local symbols follow the STT_FILE symbol of their translation unit
+    const char *file = NULL;
+    for (uint32_t i = 0; i < s_nsyms; i++) {
+        const uint8_t *p = s_img + symtab->off + (uint64_t)i * symtab->entsize;
+        sym_t *y = &s_syms[i];
+        uint32_t name;
+        uint8_t info;
+        if (s_elf64) {
+            Elf64_Sym st;
+            memcpy(&st, p, sizeof(st));
+            name = st.st_name, info = st.st_info;
+            y->value = st.st_value, y->size = st.st_size, y->shndx = st.st_shndx;
+        } else {
+            Elf32_Sym st;
+            memcpy(&st, p, sizeof(st));
+            name = st.st_name, info = st.st_info;
+            y->value = st.st_value, y->size = st.st_size, y->shndx = st.st_shndx;
+        }
+        y->name = strtab_name(strtab, name);
+        y->type = (uint8_t)(info & 0xFu);
+        y->bind = (uint8_t)(info >> 4);
+        if (y->type == STT_SECTION && y->shndx < s_nsecs) {
+            y->name = s_secs[y->shndx].name;
+        }
+        if (y->type == STT_FILE) {
+            file = y->name;
+        } else if (y->type == STT_FUNC && y->size > 0 && y->shndx != SHN_UNDEF
+                   && y->shndx < s_nsecs) {
+            func_t *f = &s_funcs[s_nfuncs++];
+            f->name = y->name;
+            f->file = (y->bind == STB_LOCAL) ? file : NULL;
+            f->addr = (s_machine == EM_ARM) ? (y->value & ~1ull) : y->value;   // Thumb bit
+            f->size = y->size;
+        }
+    }
+    return 0;
+}
+
+static int cmp_func_addr(const void *a, const void *b)
+{
+    const func_t *x = a, *y = b;
+
+    return (x->addr > y->addr) - (x->addr < y->addr);
+}
+
+static int cmp_rel_off(const void *a, const void *b)
+{
+    const rel_t *x = a, *y = b;
+
+    return (x->off > y->off) - (x->off < y->off);
+}
+
+// Function starting exactly at 'addr' (after sorting by address)
+static func_t *func_at(uint64_t addr)
+{
+    size_t lo = 0, hi = s_nfuncs;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2u;
+        if (s_funcs[mid].addr < addr) {
+            lo = mid + 1u;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo < s_nfuncs && s_funcs[lo].addr == addr) ? &s_funcs[lo] : NULL;
+}
+
+static int append_rels(const sec_t *s, rel_t **out, size_t *n)
+{
+    bool rela = (s->type == SHT_RELA);
+    size_t count = (size_t)(s->size / s->entsize);
+    rel_t *grown = realloc(*out, (*n + count) * sizeof(**out));
+
+    if (grown == NULL) {
+        return -1;
+    }
+    *out = grown;
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = s_img + s->off + i * s->entsize;
+        rel_t *r = &grown[(*n)++];
+        r->rela = rela;
+        r->addend = 0;
+        if (s_elf64) {
+            Elf64_Rela e = { 0, 0, 0 };
+            memcpy(&e, p, rela ? sizeof(Elf64_Rela) : sizeof(Elf64_Rel));
+            r->off = e.r_offset;
+            r->type = (uint32_t)ELF64_R_TYPE(e.r_info);
+            r->sym = (uint32_t)ELF64_R_SYM(e.r_info);
+            r->addend = rela ? e.r_addend : 0;
+        } else {
+            Elf32_Rela e = { 0, 0, 0 };
+            memcpy(&e, p, rela ? sizeof(Elf32_Rela) : sizeof(Elf32_Rel));
+            r->off = e.r_offset;
+            r->type = ELF32_R_TYPE(e.r_info);
+            r->sym = ELF32_R_SYM(e.r_info);
+            r->addend = rela ? e.r_addend : 0;
+        }
+    }
+    return 0;
+}
+
+// Relocations kept by --emit-relocs for code sections, and the dynamic ones
+static int load_relocations(void)
+{
+    for (uint32_t i = 1; i < s_nsecs; i++) {
+        const sec_t *s = &s_secs[i];
+        if ((s->type != SHT_RELA && s->type != SHT_REL) || s->entsize == 0) {
+            continue;
+        }
+        if ((s->flags & SHF_ALLOC) != 0) {
+            if (append_rels(s, &s_dyn_rels, &s_ndyn_rels) != 0) {
+                return -1;
+            }
+        } else if (s->info < s_nsecs && (s_secs[s->info].flags & SHF_EXECINSTR) != 0
+                   && &s_secs[s->link] == find_section(".symtab")) {
+            if (append_rels(s, &s_code_rels, &s_ncode_rels) != 0) {
+                return -1;
+            }
+        }
+    }
+    qsort(s_code_rels, s_ncode_rels, sizeof(*s_code_rels), cmp_rel_off);
+    qsort(s_dyn_rels, s_ndyn_rels, sizeof(*s_dyn_rels), cmp_rel_off);
+    return 0;
+}
+
+// Pointer stored at 'addr': a RELATIVE addend in position-independent images
+static uint64_t read_pointer(uint64_t addr)
+{
+    unsigned width = s_elf64 ? 8u : 4u;
+    uint32_t relative = (s_machine == EM_AARCH64) ? R_AARCH64_RELATIVE : R_X86_64_RELATIVE;
+    size_t lo = 0, hi = s_ndyn_rels;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2u;
+        if (s_dyn_rels[mid].off < addr) {
+            lo = mid + 1u;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < s_ndyn_rels && s_dyn_rels[lo].off == addr && s_dyn_rels[lo].rela
+        && s_dyn_rels[lo].type == relative) {
+        return (uint64_t)s_dyn_rels[lo].addend;
+    }
+    const uint8_t *p = vaddr_ptr(addr, width);
+    return (p != NULL) ? rd((uint64_t)(p - s_img), width) : 0;
+}
+
+// Bytes of a code field the linker patched; REL fields hold their addend, so keep them
+static unsigned reloc_width(const rel_t *r)
+{
+    if (!r->rela || r->type == 0) {
+        return 0;
+    }
+    if (s_machine == EM_X86_64) {
+        return (r->type == R_X86_64_64 || r->type == R_X86_64_PC64
+                || r->type == R_X86_64_GOTOFF64) ? 8u : 4u;
+    }
+    if (s_machine == EM_AARCH64) {
+        return (r->type == R_AARCH64_ABS64 || r->type == R_AARCH64_PREL64) ? 8u : 4u;
+    }
+    return 4u;
+}
+
+/* ========================================================================= */
+/* Code hashes                                                               */
+/* ========================================================================= */
+static int add_callee(func_t *f, uint32_t callee)
+{
+    for (uint32_t i = 0; i < f->ncallees; i++) {
+        if (f->callees[i] == callee) {
+            return 0;
+        }
+    }
+    if (f->ncallees == f->cap) {
+        uint32_t cap = f->cap ? f->cap * 2u : 8u;
+        uint32_t *grown = realloc(f->callees, cap * sizeof(*grown));
+        if (grown == NULL) {
+            return -1;
+        }
+        f->callees = grown;
+        f->cap = cap;
+    }
+    f->callees[f->ncallees++] = callee;
+    return 0;
+}
+
+// What a relocation points at, independent of where the linker placed it
+static uint64_t target_hash(const rel_t *r, func_t *from)
+{
+    uint64_t h = fnv64_u64(FNV64_INIT, r->type);
+
+    if (r->sym >= s_nsyms) {
+        return h;
+    }
+    const sym_t *y = &s_syms[r->sym];
+    func_t *callee = NULL;
+    if (y->type == STT_FUNC) {
+        callee = func_at((s_machine == EM_ARM) ? (y->value & ~1ull) : y->value);
+    } else if (y->type == STT_SECTION && y->shndx < s_nsecs
+               && (s_secs[y->shndx].flags & SHF_EXECINSTR) != 0) {
+        // Calls to static functions are relocated against .text + offset
+        uint64_t addr = y->value + (uint64_t)r->addend;
+        callee = func_at(addr);
+        callee = (callee != NULL) ? callee : func_at(addr + 4u);
+    }
+    if (callee != NULL) {
+        if (callee != from) {
+            (void)add_callee(from, (uint32_t)(callee - s_funcs));
+        }
+        return fnv64_str(h, callee->name);
+    }
+    h = fnv64_str(h, y->name);
+    h = fnv64_u64(h, (uint64_t)r->addend);
+    if (y->type == STT_OBJECT && y->size > 0) {
+        uint64_t n = y->size < OBJECT_MAX ? y->size : OBJECT_MAX;
+        const uint8_t *p = vaddr_ptr(y->value, n);
+        h = (p != NULL) ? fnv64(h, p, (size_t)n) : h;
+    } else if (y->type == STT_SECTION || y->name[0] == '\0') {
+        // String literals and anonymous constants: hash the bytes around the target
+        uint64_t addr = y->value + (uint64_t)r->addend;
+        for (uint64_t n = DATA_WINDOW; n > 0; n /= 2u) {
+            const uint8_t *p = vaddr_ptr(addr, n);
+            if (p != NULL) {
+                h = fnv64(h, p, (size_t)n);
+                break;
+            }
+        }
+    }
+    return h;
+}
+
+// Direct calls the assembler resolved itself (callee in the same section)
+static void scan_direct_calls(func_t *f, const uint8_t *code)
+{
+    for (uint64_t j = 0; j < f->size; j++) {
+        uint64_t target;
+        if ((s_machine == EM_X86_64 || s_machine == EM_386) && code[j] == 0xE8u
+            && j + 5u <= f->size) {
+            int32_t rel;
+            memcpy(&rel, code + j + 1u, sizeof(rel));
+            target = f->addr + j + 5u + (uint64_t)(int64_t)rel;
+        } else if (s_machine == EM_AARCH64 && j % 4u == 0 && j + 4u <= f->size
+                   && (rd((uint64_t)(code + j - s_img), 4u) & 0xFC000000u) == 0x94000000u) {
+            uint32_t insn = (uint32_t)rd((uint64_t)(code + j - s_img), 4u);
+            int64_t imm = (int64_t)((insn & 0x03FFFFFFu) ^ 0x02000000u) - 0x02000000;
+            target = f->addr + j + (uint64_t)(imm * 4);
+        } else {
+            continue;
+        }
+        func_t *callee = func_at(target);
+        if (callee != NULL && callee != f) {
+            (void)add_callee(f, (uint32_t)(callee - s_funcs));
+        }
+    }
+}
+
+static int hash_functions(void)
+{
+    uint8_t *buf = NULL;
+    size_t cap = 0, ri = 0;
+
+    for (uint32_t i = 0; i < s_nfuncs; i++) {
+        func_t *f = &s_funcs[i];
+        const uint8_t *code = vaddr_ptr(f->addr, f->size);
+        if (code == NULL) {
+            continue;
+        }
+        if (f->size > cap) {
+            cap = (size_t)f->size;
+            free(buf);
+            if ((buf = malloc(cap)) == NULL) {
+                return -1;
+            }
+        }
+        memcpy(buf, code, (size_t)f->size);
+
+        uint64_t h = fnv64_u64(FNV64_INIT, f->size);
+        while (ri < s_ncode_rels && s_code_rels[ri].off < f->addr) {
+            ri++;
+        }
+        for (size_t j = ri; j < s_ncode_rels && s_code_rels[j].off < f->addr + f->size; j++) {
+            const rel_t *r = &s_code_rels[j];
+            uint64_t at = r->off - f->addr;
+            unsigned w = reloc_width(r);
+            if (at + w <= f->size) {
+                memset(buf + at, 0, w);
+            }
+            h = fnv64_u64(h, at);
+            h = fnv64_u64(h, target_hash(r, f));
+        }
+        f->own = fnv64(h, buf, (size_t)f->size);
+        scan_direct_calls(f, code);
+    }
+    free(buf);
+    return 0;
+}
+
+// Own hash combined with the own hashes of every function reachable by calls
+static uint64_t closure_hash(func_t *root)
+{
+    if (root->full != 0) {
+        return root->full;
+    }
+    uint32_t *stack = malloc((size_t)s_nfuncs * sizeof(*stack));
+    uint32_t top = 0;
+    uint64_t h = FNV64_INIT;
+
+    if (stack == NULL) {
+        return 0;
+    }
+    s_visit++;
+    root->visit = s_visit;
+    stack[top++] = (uint32_t)(root - s_funcs);
+    while (top > 0) {
+        func_t *f = &s_funcs[stack[--top]];
+        h = fnv64_u64(h, f->own);
+        for (uint32_t i = 0; i < f->ncallees; i++) {
+            func_t *c = &s_funcs[f->callees[i]];
+            if (c->visit != s_visit) {
+                c->visit = s_visit;
+                stack[top++] = f->callees[i];
+            }
+        }
+    }
+    free(stack);
+    root->full = h | 1u;        // Never 0: 0 marks "unknown"
+    return root->full;
+}
+
+static const char *base_name(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+
+    return slash ? slash + 1 : path;
+}
+
+// 'sym' is 'func' or one of its compiler clones (func.part.0, func.cold, ...)
+static bool is_clone_of(const char *sym, const char *func)
+{
+    size_t n = strlen(func);
+
+    return strncmp(sym, func, n) == 0 && (sym[n] == '\0' || sym[n] == '.');
+}
+
+// Function whose code contains 'addr'
+static func_t *func_containing(uint64_t addr)
+{
+    size_t lo = 0, hi = s_nfuncs;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2u;
+        if (s_funcs[mid].addr <= addr) {
+            lo = mid + 1u;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo > 0 && addr - s_funcs[lo - 1u].addr < s_funcs[lo - 1u].size) ? &s_funcs[lo - 1u]
+                                                                           : NULL;
+}
+
+static uint64_t site_code_hash(const site_t *s, uint64_t file_addr)
+{
+    uint64_t h = FNV64_INIT;
+    bool any = false;
+
+    // The enclosing function: a static of the site's own file or a global first
+    for (uint32_t pass = 0; pass < 2u && !any; pass++) {
+        for (uint32_t i = 0; i < s_nfuncs; i++) {
+            func_t *f = &s_funcs[i];
+            if (!is_clone_of(f->name, s->func)
+                || (pass == 0 && f->file != NULL && strcmp(f->file, base_name(s->file)) != 0)) {
+                continue;
+            }
+            h = fnv64_u64(h, closure_hash(f));
+            any = true;
+        }
+    }
+
+    // Inlined away: every function that loads the site's __FILE__ string (its
+    // callers within the translation unit). PC-relative fields point 4 bytes early.
+    for (size_t i = 0; i < s_ncode_rels && !any; i++) {
+        const rel_t *r = &s_code_rels[i];
+        func_t *f;
+        if (r->sym >= s_nsyms || (f = func_containing(r->off)) == NULL) {
+            continue;
+        }
+        uint64_t target = s_syms[r->sym].value + (uint64_t)r->addend;
+        if (target == file_addr || target + 4u == file_addr) {
+            h = fnv64_u64(h, closure_hash(f));
+            any = true;
+        }
+    }
+    return any ? (h | 1u) : 0;
+}
+
+// Without code relocations the only safe hash is one over all executable bytes
+static uint64_t whole_text_hash(void)
+{
+    uint64_t h = FNV64_INIT;
+
+    for (uint32_t i = 1; i < s_nsecs; i++) {
+        const sec_t *s = &s_secs[i];
+        if ((s->flags & SHF_EXECINSTR) != 0 && s->type != SHT_NOBITS) {
+            h = fnv64(h, s_img + s->off, (size_t)s->size);
+        }
+    }
+    return h | 1u;
+}
+
+static int cmp_site(const void *a, const void *b)
+{
+    const site_t *x = a, *y = b;
+
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+// Reads and de-duplicates the site table; returns the number of sites or -1
+static long load_sites(site_t **out)
+{
+    const sec_t *tab = find_section("errcheck_sites");
+    unsigned ptr = s_elf64 ? 8u : 4u, stride = s_elf64 ? 24u : 16u;
+
+    if (tab == NULL) {
+        return -1;
+    }
+    size_t n = (size_t)(tab->size / stride);
+    site_t *sites = calloc(n ? n : 1u, sizeof(*sites));
+    if (sites == NULL) {
+        return -1;
+    }
+    bool relocs = s_ncode_rels > 0;
+    uint64_t text = relocs ? 0 : whole_text_hash();
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t rec = tab->addr + i * stride;
+        const uint8_t *p = vaddr_ptr(rec + 2u * ptr, 8u);
+        site_t *s = &sites[m];
+        uint64_t file_addr = read_pointer(rec);
+        s->file = vaddr_str(file_addr);
+        s->func = vaddr_str(read_pointer(rec + ptr));
+        if (p == NULL || s->file == NULL || s->func == NULL) {
+            continue;
+        }
+        s->line = (uint32_t)rd((uint64_t)(p - s_img), 4u);
+        s->code = (uint32_t)rd((uint64_t)(p - s_img) + 4u, 4u);
+        s->id = errcheck_site_id(s->file, s->line);
+        s->hash = relocs ? site_code_hash(s, file_addr) : text;
+        m++;
+    }
+
+    // The same file:line can appear several times (header inlined into many TUs)
+    qsort(sites, m, sizeof(*sites), cmp_site);
+    size_t u = 0;
+    for (size_t i = 0; i < m; i++) {
+        if (u > 0 && sites[u - 1u].id == sites[i].id) {
+            site_t *d = &sites[u - 1u];
+            d->hash = (d->hash == 0 || sites[i].hash == 0) ? 0 : (fnv64_u64(d->hash, sites[i].hash) | 1u);
+        } else {
+            sites[u++] = sites[i];
+        }
+    }
+    *out = sites;
+    return (long)u;
+}
+
+static int load_image(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    struct stat sb;
+
+    if (f == NULL || fstat(fileno(f), &sb) != 0) {
+        return -1;
+    }
+    s_img_size = (size_t)sb.st_size;
+    s_img = malloc(s_img_size ? s_img_size : 1u);
+    if (s_img == NULL || fread(s_img, 1, s_img_size, f) != s_img_size) {
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    if (s_img_size < sizeof(Elf32_Ehdr) || memcmp(s_img, ELFMAG, SELFMAG) != 0
+        || s_img[EI_DATA] != ELFDATA2LSB
+        || (s_img[EI_CLASS] != ELFCLASS32 && s_img[EI_CLASS] != ELFCLASS64)) {
+        return -1;
+    }
+    s_elf64 = (s_img[EI_CLASS] == ELFCLASS64);
+    if (s_elf64 && s_img_size < sizeof(Elf64_Ehdr)) {
+        return -1;
+    }
+    if (load_sections() != 0 || load_symbols() != 0 || load_relocations() != 0) {
+        return -1;
+    }
+    qsort(s_funcs, s_nfuncs, sizeof(*s_funcs), cmp_func_addr);
+    return hash_functions();
+}
+
+/* ========================================================================= */
+/* Cache                                                                     */
+/* ========================================================================= */
+static int cmp_entry(const void *a, const void *b)
+{
+    const entry_t *x = a, *y = b;
+
+    return (x->id > y->id) - (x->id < y->id);
+}
+
+// Entries recorded under the same command hash, sorted by site
+static entry_t *cache_load(const char *path, uint64_t cmd, size_t *n)
+{
+    FILE *f = fopen(path, "r");
+    entry_t *e = NULL;
+    size_t cap = 0;
+    char line[128], magic[64];
+    uint64_t stored;
+
+    *n = 0;
+    if (f == NULL) {
+        return NULL;
+    }
+    snprintf(magic, sizeof(magic), CAMPAIGN_MAGIC " cmd=%016" PRIx64 "\n", cmd);
+    if (fgets(line, sizeof(line), f) == NULL || strcmp(line, magic) != 0) {
+        if (sscanf(line, CAMPAIGN_MAGIC " cmd=%" SCNx64, &stored) == 1) {
+            fprintf(stderr, "%s: recorded for another command line, ignored\n", path);
+        }
+        fclose(f);
+        return NULL;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        entry_t ent;
+        if (sscanf(line, "%" SCNx32 " %" SCNx64 " %23s", &ent.id, &ent.hash, ent.outcome) != 3) {
+            continue;
+        }
+        if (*n == cap) {
+            cap = cap ? cap * 2u : 256u;
+            entry_t *grown = realloc(e, cap * sizeof(*e));
+            if (grown == NULL) {
+                break;
+            }
+            e = grown;
+        }
+        e[(*n)++] = ent;
+    }
+    fclose(f);
+    if (e != NULL) {
+        qsort(e, *n, sizeof(*e), cmp_entry);
+    }
+    return e;
+}
+
+static int cache_store(const char *path, uint64_t cmd, const entry_t *e, size_t n)
+{
+    char tmp[4096];
+    FILE *f;
+
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)
+        || (f = fopen(tmp, "w")) == NULL) {
+        return -1;
+    }
+    fprintf(f, CAMPAIGN_MAGIC " cmd=%016" PRIx64 "\n", cmd);
+    for (size_t i = 0; i < n; i++) {
+        fprintf(f, "%08" PRIx32 " %016" PRIx64 " %s\n", e[i].id, e[i].hash, e[i].outcome);
+    }
+    int rc = (fflush(f) == 0 && fsync(fileno(f)) == 0) ? 0 : -1;
+    if (fclose(f) != 0 || rc != 0 || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/* ========================================================================= */
+/* Runs                                                                      */
+/* ========================================================================= */
+static uint64_t mono_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+// Runs the program with the site forced to fail once; fills 'outcome'
+static void explore(char **argv, uint32_t site, const char *report, unsigned timeout_s,
+                    bool verbose, char *outcome, size_t len)
+{
+    char rule[64];
+    int status = 0;
+
+    snprintf(rule, sizeof(rule), "site=0x%08" PRIX32 " once", site);
+    (void)unlink(report);
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid < 0) {
+        snprintf(outcome, len, "error:%d", errno);
+        return;
+    }
+    if (pid == 0) {
+        setpgid(0, 0);              // Timeouts kill the whole process group
+        setenv("ERRCHECK_INJECT", rule, 1);
+        setenv("ERRCHECK_INJECT_REPORT", report, 1);
+        if (!verbose) {
+            int null = open("/dev/null", O_WRONLY);
+            dup2(null, STDOUT_FILENO);
+            dup2(null, STDERR_FILENO);
+        }
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+
+    uint64_t deadline = mono_ms() + (uint64_t)timeout_s * 1000u;
+    bool timed_out = false;
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+        if (mono_ms() >= deadline) {
+            kill(-pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            timed_out = true;
+            break;
+        }
+        struct timespec nap = { 0, 5 * 1000000L };
+        nanosleep(&nap, NULL);
+    }
+
+    unsigned long fired = 0;
+    FILE *f = fopen(report, "r");
+    bool reported = f != NULL && fscanf(f, "fired %lu", &fired) == 1;
+    if (f != NULL) {
+        fclose(f);
+    }
+    if (timed_out) {
+        snprintf(outcome, len, "timeout");
+    } else if (WIFSIGNALED(status)) {
+        snprintf(outcome, len, "signal:%d", WTERMSIG(status));
+    } else if (reported && fired == 0) {
+        snprintf(outcome, len, "unreached");
+    } else {
+        snprintf(outcome, len, "exit:%d", WEXITSTATUS(status));
+    }
+}
+
+static void usage(const char *self)
+{
+    fprintf(stderr, "usage: %s [-c cache] [-t seconds] [-e elf] [-f] [-v] program [args...]\n",
+            self);
+}
+
+int main(int argc, char **argv)
+{
+    const char *cache = "errcheck_campaign.cache", *elf = NULL;
+    unsigned timeout_s = 10;
+    bool full = false, verbose = false;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        char opt = argv[i][1];
+        if (opt == 'f' || opt == 'v') {
+            full |= (opt == 'f');
+            verbose |= (opt == 'v');
+        } else if ((opt == 'c' || opt == 't' || opt == 'e') && i + 1 < argc) {
+            const char *val = argv[++i];
+            if (opt == 'c') {
+                cache = val;
+            } else if (opt == 'e') {
+                elf = val;
+            } else {
+                timeout_s = (unsigned)strtoul(val, NULL, 10);
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (i >= argc || timeout_s == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    char **cmd = &argv[i];
+    elf = elf ? elf : cmd[0];
+
+    site_t *sites = NULL;
+    long nsites;
+    if (load_image(elf) != 0) {
+        fprintf(stderr, "%s: not a readable little-endian ELF image with a symbol table\n", elf);
+        return 1;
+    }
+    if ((nsites = load_sites(&sites)) < 0) {
+        fprintf(stderr, "%s: no errcheck_sites section (build with -D ERRCHECK_ENABLE_SITE_TABLE)\n",
+                elf);
+        return 1;
+    }
+    if (s_ncode_rels == 0) {
+        fprintf(stderr, "%s: no code relocations (build with -ffunction-sections "
+                "-Wl,--emit-relocs); "
+                "any code change re-explores every site\n", elf);
+    }
+
+    uint64_t cmd_hash = fnv64_u64(FNV64_INIT, timeout_s);
+    for (char **a = cmd; *a != NULL; a++) {
+        cmd_hash = fnv64_str(cmd_hash, *a);
+    }
+    size_t ncached = 0;
+    entry_t *cached = full ? NULL : cache_load(cache, cmd_hash, &ncached);
+    entry_t *result = calloc((size_t)nsites + 1u, sizeof(*result));
+    char report[] = "/tmp/errcheck_campaign.XXXXXX";
+    int rfd = mkstemp(report);
+    if (result == NULL || rfd < 0) {
+        fprintf(stderr, "out of memory or no temporary file\n");
+        return 1;
+    }
+    close(rfd);
+
+    unsigned long explored = 0, reused = 0, unreached = 0, failed = 0;
+    for (long k = 0; k < nsites; k++) {
+        const site_t *s = &sites[k];
+        entry_t key = { .id = s->id }, *hit = NULL;
+        entry_t *r = &result[k];
+        if (cached != NULL) {
+            hit = bsearch(&key, cached, ncached, sizeof(*cached), cmp_entry);
+        }
+        r->id = s->id;
+        r->hash = s->hash;
+        bool reuse = hit != NULL && s->hash != 0 && hit->hash == s->hash;
+        if (reuse) {
+            memcpy(r->outcome, hit->outcome, sizeof(r->outcome));
+            reused++;
+        } else {
+            explore(cmd, s->id, report, timeout_s, verbose, r->outcome, sizeof(r->outcome));
+            explored++;
+        }
+        unreached += (strcmp(r->outcome, "unreached") == 0);
+        failed += (strncmp(r->outcome, "exit:", 5) != 0 && strcmp(r->outcome, "unreached") != 0);
+        printf("0x%08" PRIX32 "  %s:%" PRIu32 "  %s()  code %" PRIu32 "  %-10s%s\n", s->id,
+               s->file, s->line, s->func, s->code, r->outcome, reuse ? "  (cached)" : "");
+        fflush(stdout);
+    }
+    (void)unlink(report);
+
+    if (cache_store(cache, cmd_hash, result, (size_t)nsites) != 0) {
+        fprintf(stderr, "%s: cannot write cache\n", cache);
+    }
+    fprintf(stderr, "%ld site(s): %lu explored, %lu from cache, %lu unreached, "
+            "%lu crashed or timed out\n", nsites, explored, reused, unreached, failed);
+    free(result);
+    free(cached);
+    free(sites);
+    return 0;
+}
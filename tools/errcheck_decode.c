@@ -0,0 +1,288 @@
+/**
+ * =============================================================================
+ * tools/errcheck_decode.c
+ * * Host tool: decodes a downlink capture of telemetry frames (err_telemetry.h)
+ * * into one line per entry. Frames may be separated by line noise or partial
+ * * frames: the scanner resynchronises on the sync bytes and checks every CRC.
+ * * With -o, entries go to a columnar archive (errcheck_ecol.h) for
+ * * tools/errcheck_query instead of stdout.
+ * * With -f, keeps decoding bytes as they are appended (like tail -f) until
+ * * Ctrl-C: a growing capture file is watched with inotify, a UART tty or a
+ * * pipe is read as data arrives. Memory use is constant.
+ * * Build: gcc -I src tools/errcheck_decode.c tools/errcheck_ecol.c \
+ * *        src/err_telemetry.c src/err_crc32c.c -o errcheck_decode
+ * * Usage: errcheck_decode [-f] [-o archive.ecol] [capture-file]   (stdin when omitted)
+ * * e.g.  stty -F /dev/ttyUSB0 115200 raw && errcheck_decode -f /dev/ttyUSB0
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L // getopt(), sigaction()
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#include "err_telemetry.h"
+#include "errcheck_ecol.h"
+
+typedef struct {
+    uint64_t frames;
+    uint64_t entries;
+    uint64_t occurrences;
+    uint64_t bad_frames;        // Sync found but length/CRC/bit stream wrong
+    uint64_t skipped_bytes;
+} decode_stats_t;
+
+static errcheck_ecol_writer_t g_archive;
+static int g_archive_open = 0;
+
+// True if a frame with a valid CRC starts somewhere in buf[0..len)
+static bool frame_follows(const uint8_t *buf, size_t len)
+{
+    errcheck_tlm_header_t hdr;
+
+    for (size_t off = 0; off < len; off++) {
+        size_t flen = errcheck_tlm_frame_len(buf + off, len - off);
+        if (flen >= ERRCHECK_TLM_MIN_FRAME && flen <= len - off
+            && errcheck_tlm_decode(buf + off, flen, &hdr, NULL, 0) >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Decodes every complete frame in buf[0..len). Returns the number of bytes consumed;
+// a trailing partial frame is left for the caller. With 'final' no more bytes will
+// come: a frame start that runs past the end is a false sync and is skipped.
+static size_t decode_buffer(const uint8_t *buf, size_t len, bool final, decode_stats_t *st)
+{
+    errcheck_tlm_entry_t entries[ERRCHECK_TLM_MAX_ENTRIES];
+    errcheck_tlm_header_t hdr;
+    size_t off = 0;
+
+    while (off < len) {
+        size_t flen = errcheck_tlm_frame_len(buf + off, len - off);
+        if (!final && flen == 0 && len - off < 3u && buf[off] == ERRCHECK_TLM_SYNC0) {
+            break;  // Possibly the start of a frame
+        }
+        if (!final && flen != 0 && off + flen > len && flen >= ERRCHECK_TLM_MIN_FRAME
+            && !frame_follows(buf + off + 1, len - off - 1)) {
+            break;  // Incomplete frame; a valid frame behind it means it was a false sync
+        }
+        int n = (flen != 0 && off + flen <= len) ? errcheck_tlm_decode(buf + off, flen, &hdr, entries,
+                                                   sizeof(entries) / sizeof(entries[0])) : -1;
+        if (n < 0) {
+            st->bad_frames += (flen != 0);
+            st->skipped_bytes++;
+            off++;
+            continue;
+        }
+
+        if (!g_archive_open) {
+            printf("frame dev=%" PRIu16 " seq=%" PRIu16 " len=%u entries=%u\n",
+                   hdr.device_id, hdr.seq, (unsigned)hdr.length, (unsigned)hdr.count);
+        }
+        for (int i = 0; i < n; i++) {
+            if (g_archive_open) {
+                uint64_t row[ERRCHECK_ECOL_COLUMNS];
+                row[ERRCHECK_ECOL_TIMESTAMP] = entries[i].timestamp_ms;
+                row[ERRCHECK_ECOL_DEVICE] = hdr.device_id;
+                row[ERRCHECK_ECOL_CODE] = entries[i].code;
+                row[ERRCHECK_ECOL_SITE] = entries[i].site;
+                row[ERRCHECK_ECOL_INNER] = entries[i].inner_code;
+                row[ERRCHECK_ECOL_COUNT] = entries[i].count;
+                if (errcheck_ecol_writer_add(&g_archive, row) != 0) {
+                    perror("archive");
+                    exit(1);
+                }
+            } else {
+                printf("  %15" PRIu64 " ms  code=%-4" PRIu32 " inner=0x%08" PRIX32
+                       " site=0x%08" PRIX32 " x%" PRIu32 "\n",
+                       entries[i].timestamp_ms, entries[i].code, entries[i].inner_code,
+                       entries[i].site, entries[i].count);
+            }
+            st->occurrences += entries[i].count;
+        }
+        st->frames++;
+        st->entries += (uint64_t)n;
+        off += flen;
+    }
+    return off;
+}
+
+// Sliding window of at least two maximum-size frames, so a frame is never split.
+// This is all the memory the decoder needs, however long the capture runs.
+typedef struct {
+    uint8_t buf[ERRCHECK_TLM_MAX_FRAME * 16u];
+    size_t have;
+} window_t;
+
+// Reads what 'fd' has and decodes every complete frame. Returns read()'s result.
+static ssize_t pump(int fd, window_t *w, decode_stats_t *st)
+{
+    ssize_t got = read(fd, w->buf + w->have, sizeof(w->buf) - w->have);
+
+    if (got > 0) {
+        w->have += (size_t)got;
+        size_t used = decode_buffer(w->buf, w->have, false, st);
+        if (used == 0 && w->have == sizeof(w->buf)) {
+            used = 1;   // Cannot happen with a valid length byte; never stall
+        }
+        memmove(w->buf, w->buf + used, w->have - used);
+        w->have -= used;
+    }
+    return got;
+}
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_stop = 1;
+}
+
+// Decodes bytes as they are appended until SIGINT/SIGTERM. Regular files are
+// watched with inotify (woken per write, no polling interval); ttys, pipes and
+// FIFOs simply block in read().
+static int follow(int fd, const char *path, window_t *w, decode_stats_t *st)
+{
+    struct stat sb;
+    ssize_t got;
+
+    if (fstat(fd, &sb) != 0) {
+        return -1;
+    }
+    if (!S_ISREG(sb.st_mode)) {
+        while (!g_stop && ((got = pump(fd, w, st)) > 0 || (got < 0 && errno == EINTR))) {
+            fflush(stdout);
+        }
+        return 0;
+    }
+
+#ifdef __linux__
+    // Watch before the first drain, so an append racing with it still wakes us.
+    // A file redirected to stdin has no path of its own: watch it through /proc.
+    int in = inotify_init1(IN_CLOEXEC);
+    if (in < 0 || inotify_add_watch(in, path != NULL ? path : "/proc/self/fd/0", IN_MODIFY) < 0) {
+        int err = errno;
+        if (in >= 0) {
+            close(in);
+        }
+        errno = err;
+        return -1;
+    }
+
+    union {
+        struct inotify_event ev;
+        char raw[4096];
+    } events;
+    while (!g_stop) {
+        while ((got = pump(fd, w, st)) > 0) {
+        }
+        fflush(stdout);
+        if (got < 0 && errno != EINTR) {
+            break;
+        }
+
+        // Truncated in place (e.g. copytruncate log rotation): start over
+        off_t pos = lseek(fd, 0, SEEK_CUR);
+        if (fstat(fd, &sb) == 0 && sb.st_size < pos) {
+            lseek(fd, 0, SEEK_SET);
+            w->have = 0;
+        }
+        if (read(in, &events, sizeof(events)) < 0 && errno != EINTR) {
+            break;
+        }
+    }
+    close(in);
+    return 0;
+#else
+    (void)path;
+    (void)w;
+    (void)st;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-f] [-o archive.ecol] [capture-file]\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+    static window_t win;
+    decode_stats_t st = {0};
+    const char *archive = NULL;
+    const char *path = NULL;
+    int follow_mode = 0, fd = STDIN_FILENO, opt, rc = 0;
+
+    while ((opt = getopt(argc, argv, "fo:")) != -1) {
+        switch (opt) {
+        case 'f': follow_mode = 1; break;
+        case 'o': archive = optarg; break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - optind > 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (optind < argc) {
+        path = argv[optind];
+        if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) {
+            perror(path);
+            return 1;
+        }
+    }
+    if (archive != NULL) {
+        if (errcheck_ecol_writer_open(&g_archive, archive) != 0) {
+            perror(archive);
+            return 1;
+        }
+        g_archive_open = 1;
+    }
+
+    if (follow_mode) {
+        // No SA_RESTART: the signal must interrupt the blocking read
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = on_signal;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+        if (follow(fd, path, &win, &st) != 0) {
+            perror("follow");
+            rc = 1;
+        }
+    } else {
+        ssize_t got;
+        while ((got = pump(fd, &win, &st)) > 0 || (got < 0 && errno == EINTR)) {
+        }
+    }
+    // End of input: a false sync (noise with a large length byte) may still hold
+    // back real frames behind it; this pass skips it and decodes them
+    (void)decode_buffer(win.buf, win.have, true, &st);
+
+    fprintf(stderr, "%" PRIu64 " frame(s), %" PRIu64 " entries, %" PRIu64 " occurrence(s); "
+            "%" PRIu64 " bad frame(s), %" PRIu64 " byte(s) skipped\n",
+            st.frames, st.entries, st.occurrences, st.bad_frames, st.skipped_bytes);
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    if (g_archive_open && errcheck_ecol_writer_close(&g_archive) != 0) {
+        perror(archive);
+        return 1;
+    }
+    return (rc != 0 || st.bad_frames != 0) ? 1 : 0;
+}
@@ -0,0 +1,381 @@
+/**
+ * =============================================================================
+ * tools/errcheck_ecol.c
+ * * Columnar archive writer and mmap reader (see errcheck_ecol.h).
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L // mmap(), fstat() under strict -std=c99
+#include "errcheck_ecol.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *const s_column_names[ERRCHECK_ECOL_COLUMNS] = {
+    "timestamp", "device", "code", "site", "inner", "count",
+};
+
+const char *errcheck_ecol_column_name(errcheck_ecol_column_t col)
+{
+    return (col < ERRCHECK_ECOL_COLUMNS) ? s_column_names[col] : "?";
+}
+
+int errcheck_ecol_column_by_name(const char *name)
+{
+    for (int c = 0; c < ERRCHECK_ECOL_COLUMNS; c++) {
+        if (strcmp(name, s_column_names[c]) == 0) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+static size_t column_width(unsigned col)
+{
+    return (col == ERRCHECK_ECOL_TIMESTAMP) ? 8u : 4u;
+}
+
+static uint64_t load_le(const uint8_t *p, size_t width)
+{
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; i++) {
+        v |= (uint64_t)p[i] << (8u * i);
+    }
+    return v;
+}
+
+static void store_le(uint8_t *p, uint64_t v, size_t width)
+{
+    for (size_t i = 0; i < width; i++) {
+        p[i] = (uint8_t)(v >> (8u * i));
+    }
+}
+
+static size_t varint_size(uint64_t v)
+{
+    size_t n = 1;
+    while (v >= 0x80u) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static uint64_t zigzag(uint64_t cur, uint64_t prev)
+{
+    int64_t d = (int64_t)(cur - prev);
+    return ((uint64_t)d << 1) ^ (uint64_t)(d >> 63);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* ========================================================================= */
+/* Writer                                                                    */
+/* ========================================================================= */
+// Frees the buffers of a writer (open or half-opened) and clears it
+static void writer_release(errcheck_ecol_writer_t *w)
+{
+    for (int c = 0; c < ERRCHECK_ECOL_COLUMNS; c++) {
+        free(w->col[c]);
+    }
+    free(w->sorted);
+    free(w->scratch);
+    free(w->index);
+    memset(w, 0, sizeof(*w));
+}
+
+int errcheck_ecol_writer_open(errcheck_ecol_writer_t *w, const char *path)
+{
+    errcheck_ecol_header_t hdr = { ERRCHECK_ECOL_MAGIC, ERRCHECK_ECOL_VERSION,
+                                   ERRCHECK_ECOL_COLUMNS, ERRCHECK_ECOL_BLOCK_ROWS, 0 };
+
+    memset(w, 0, sizeof(*w));
+    w->sorted = malloc(ERRCHECK_ECOL_BLOCK_ROWS * sizeof(uint64_t));
+    w->scratch = malloc(ERRCHECK_ECOL_BLOCK_ROWS * 10u + 16u); // Worst case: 10-byte varints
+    bool ok = (w->sorted != NULL && w->scratch != NULL);
+    for (int c = 0; c < ERRCHECK_ECOL_COLUMNS; c++) {
+        w->col[c] = malloc(ERRCHECK_ECOL_BLOCK_ROWS * sizeof(uint64_t));
+        ok = ok && (w->col[c] != NULL);
+    }
+    if (!ok || (w->f = fopen(path, "wb")) == NULL || fwrite(&hdr, sizeof(hdr), 1, w->f) != 1) {
+        if (w->f != NULL) {
+            fclose(w->f);
+        }
+        writer_release(w);
+        return -1;
+    }
+    w->offset = sizeof(hdr);
+    return 0;
+}
+
+// Encodes column 'c' of the pending block into w->scratch; returns the chunk size
+static size_t encode_chunk(errcheck_ecol_writer_t *w, unsigned c, uint8_t *encoding)
+{
+    const uint64_t *v = w->col[c];
+    uint32_t n = w->pending;
+    size_t width = column_width(c);
+    size_t plain = n * width;
+    size_t delta = 0;
+    uint64_t prev = 0;
+
+    for (uint32_t i = 0; i < n; prev = v[i], i++) {
+        delta += varint_size(zigzag(v[i], prev));
+    }
+
+    memcpy(w->sorted, v, n * sizeof(uint64_t));
+    qsort(w->sorted, n, sizeof(uint64_t), cmp_u64);
+    uint32_t nd = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (nd == 0 || w->sorted[nd - 1] != w->sorted[i]) {
+            w->sorted[nd++] = w->sorted[i];
+        }
+    }
+    size_t iw = (nd <= 256u) ? 1u : 2u;
+    size_t dict = (nd <= 65536u) ? 4u + nd * width + n * iw : SIZE_MAX;
+
+    uint8_t *p = w->scratch;
+    if (dict < plain && dict <= delta) {
+        *encoding = ERRCHECK_ECOL_ENC_DICT;
+        store_le(p, nd, 4);
+        p += 4;
+        for (uint32_t i = 0; i < nd; i++, p += width) {
+            store_le(p, w->sorted[i], width);
+        }
+        for (uint32_t i = 0; i < n; i++, p += iw) {
+            const uint64_t *hit = bsearch(&v[i], w->sorted, nd, sizeof(uint64_t), cmp_u64);
+            store_le(p, (uint64_t)(hit - w->sorted), iw);
+        }
+    } else if (delta < plain) {
+        *encoding = ERRCHECK_ECOL_ENC_DELTA;
+        prev = 0;
+        for (uint32_t i = 0; i < n; prev = v[i], i++) {
+            uint64_t z = zigzag(v[i], prev);
+            while (z >= 0x80u) {
+                *p++ = (uint8_t)(z | 0x80u);
+                z >>= 7;
+            }
+            *p++ = (uint8_t)z;
+        }
+    } else {
+        *encoding = ERRCHECK_ECOL_ENC_PLAIN;
+        for (uint32_t i = 0; i < n; i++, p += width) {
+            store_le(p, v[i], width);
+        }
+    }
+    return (size_t)(p - w->scratch);
+}
+
+static int flush_block(errcheck_ecol_writer_t *w)
+{
+    if (w->pending == 0) {
+        return 0;
+    }
+    if (w->blocks == w->index_cap) {
+        uint32_t cap = w->index_cap ? w->index_cap * 2u : 64u;
+        errcheck_ecol_block_t *idx = realloc(w->index, cap * sizeof(*idx));
+        if (idx == NULL) {
+            return -1;
+        }
+        w->index = idx;
+        w->index_cap = cap;
+    }
+
+    errcheck_ecol_block_t *b = &w->index[w->blocks];
+    memset(b, 0, sizeof(*b));
+    b->rows = w->pending;
+    for (unsigned c = 0; c < ERRCHECK_ECOL_COLUMNS; c++) {
+        b->min[c] = UINT64_MAX;
+        for (uint32_t i = 0; i < w->pending; i++) {
+            b->min[c] = (w->col[c][i] < b->min[c]) ? w->col[c][i] : b->min[c];
+            b->max[c] = (w->col[c][i] > b->max[c]) ? w->col[c][i] : b->max[c];
+        }
+        size_t len = encode_chunk(w, c, &b->encoding[c]);
+        if (fwrite(w->scratch, 1, len, w->f) != len) {
+            return -1;
+        }
+        b->offset[c] = w->offset;
+        b->size[c] = (uint32_t)len;
+        w->offset += len;
+    }
+    w->blocks++;
+    w->pending = 0;
+    return 0;
+}
+
+int errcheck_ecol_writer_add(errcheck_ecol_writer_t *w, const uint64_t row[ERRCHECK_ECOL_COLUMNS])
+{
+    for (int c = 0; c < ERRCHECK_ECOL_COLUMNS; c++) {
+        w->col[c][w->pending] = row[c];
+    }
+    w->rows++;
+    if (++w->pending == ERRCHECK_ECOL_BLOCK_ROWS) {
+        return flush_block(w);
+    }
+    return 0;
+}
+
+int errcheck_ecol_writer_close(errcheck_ecol_writer_t *w)
+{
+    int rc = (w->f != NULL) ? flush_block(w) : -1;
+
+    if (rc == 0) {
+        // The index is mapped in place by readers: align it
+        static const uint8_t zeros[8] = {0};
+        size_t pad = (size_t)(-w->offset & 7u);
+        w->offset += pad;
+        errcheck_ecol_trailer_t t = { w->offset, w->rows, w->blocks, ERRCHECK_ECOL_END_MAGIC };
+        if (fwrite(zeros, 1, pad, w->f) != pad
+            || fwrite(w->index, sizeof(*w->index), w->blocks, w->f) != w->blocks
+            || fwrite(&t, sizeof(t), 1, w->f) != 1) {
+            rc = -1;
+        }
+    }
+    if (w->f != NULL && fclose(w->f) != 0) {
+        rc = -1;
+    }
+    writer_release(w);
+    return rc;
+}
+
+/* ========================================================================= */
+/* Reader                                                                    */
+/* ========================================================================= */
+int errcheck_ecol_open(errcheck_ecol_reader_t *r, const char *path)
+{
+    struct stat st;
+    errcheck_ecol_trailer_t t;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    memset(r, 0, sizeof(*r));
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0
+        || (size_t)st.st_size < sizeof(errcheck_ecol_header_t) + sizeof(t)) {
+        close(fd);
+        return -1;
+    }
+    r->size = (size_t)st.st_size;
+    void *map = mmap(NULL, r->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    r->map = map;
+
+    const errcheck_ecol_header_t *hdr = (const errcheck_ecol_header_t *)r->map;
+    memcpy(&t, r->map + r->size - sizeof(t), sizeof(t));
+    if (memcmp(hdr->magic, ERRCHECK_ECOL_MAGIC, 4) != 0 || hdr->version != ERRCHECK_ECOL_VERSION
+        || hdr->columns != ERRCHECK_ECOL_COLUMNS || memcmp(t.magic, ERRCHECK_ECOL_END_MAGIC, 4) != 0
+        || t.index_offset % 8u != 0
+        || t.index_offset + (uint64_t)t.blocks * sizeof(errcheck_ecol_block_t) + sizeof(t) != r->size) {
+        errcheck_ecol_close(r);
+        return -1;
+    }
+    r->index = (const errcheck_ecol_block_t *)(r->map + t.index_offset);
+    r->blocks = t.blocks;
+    r->rows = t.rows;
+
+    // Readers size their buffers by 'rows' and trust the chunk bounds: check every entry
+    for (uint32_t b = 0; b < r->blocks; b++) {
+        const errcheck_ecol_block_t *blk = &r->index[b];
+        bool ok = blk->rows != 0 && blk->rows <= ERRCHECK_ECOL_BLOCK_ROWS;
+        for (int c = 0; ok && c < ERRCHECK_ECOL_COLUMNS; c++) {
+            ok = blk->offset[c] >= sizeof(errcheck_ecol_header_t)
+                 && blk->offset[c] <= t.index_offset
+                 && blk->size[c] <= t.index_offset - blk->offset[c];
+        }
+        if (!ok) {
+            errcheck_ecol_close(r);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void errcheck_ecol_close(errcheck_ecol_reader_t *r)
+{
+    if (r->map != NULL) {
+        munmap((void *)(uintptr_t)r->map, r->size);
+    }
+    memset(r, 0, sizeof(*r));
+}
+
+int errcheck_ecol_read(const errcheck_ecol_reader_t *r, uint32_t block,
+                       errcheck_ecol_column_t col, uint64_t *out)
+{
+    if (block >= r->blocks || col >= ERRCHECK_ECOL_COLUMNS) {
+        return -1;
+    }
+    const errcheck_ecol_block_t *b = &r->index[block];
+    size_t width = column_width(col);
+    uint32_t n = b->rows;
+
+    if (n > ERRCHECK_ECOL_BLOCK_ROWS || b->offset[col] > r->size
+        || b->size[col] > r->size - b->offset[col]) {
+        return -1;
+    }
+    const uint8_t *p = r->map + b->offset[col];
+    const uint8_t *end = p + b->size[col];
+
+    switch (b->encoding[col]) {
+    case ERRCHECK_ECOL_ENC_PLAIN:
+        if (b->size[col] != n * width) {
+            return -1;
+        }
+        for (uint32_t i = 0; i < n; i++, p += width) {
+            out[i] = load_le(p, width);
+        }
+        return 0;
+
+    case ERRCHECK_ECOL_ENC_DICT: {
+        if (b->size[col] < 4u) {
+            return -1;
+        }
+        uint32_t nd = (uint32_t)load_le(p, 4);
+        size_t iw = (nd <= 256u) ? 1u : 2u;
+        if (nd > 65536u || b->size[col] != 4u + nd * width + n * iw) {
+            return -1;
+        }
+        const uint8_t *dict = p + 4;
+        p = dict + nd * width;
+        for (uint32_t i = 0; i < n; i++, p += iw) {
+            uint64_t k = load_le(p, iw);
+            if (k >= nd) {
+                return -1;
+            }
+            out[i] = load_le(dict + k * width, width);
+        }
+        return 0;
+    }
+
+    case ERRCHECK_ECOL_ENC_DELTA: {
+        uint64_t prev = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            uint64_t z = 0;
+            unsigned shift = 0;
+            do {
+                if (p == end || shift > 63u) {
+                    return -1;
+                }
+                z |= (uint64_t)(*p & 0x7Fu) << shift;
+                shift += 7;
+            } while (*p++ & 0x80u);
+            prev += (uint64_t)((int64_t)(z >> 1) ^ -(int64_t)(z & 1u));
+            out[i] = prev;
+        }
+        return (p == end) ? 0 : -1;
+    }
+
+    default:
+        return -1;
+    }
+}
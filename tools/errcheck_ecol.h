@@ -0,0 +1,112 @@
+/**
+ * =============================================================================
+ * tools/errcheck_ecol.h
+ * * Columnar archive (.ecol) of decoded failure records for ground analytics.
+ * * Shared by tools/errcheck_decode.c (writer) and tools/errcheck_query.c (reader).
+ * * File layout (host byte order, little-endian hosts assumed):
+ * *   header   errcheck_ecol_header_t
+ * *   blocks   per block, one chunk per column, each encoded independently
+ * *   index    errcheck_ecol_block_t[blocks]  (chunk offsets/sizes, min/max)
+ * *   trailer  errcheck_ecol_trailer_t        (at the very end of the file)
+ * * Chunk encodings (the writer keeps the smallest per column and block):
+ * *   PLAIN    values, 4 bytes (8 for the timestamp column)
+ * *   DICT     u32 n, n distinct values, then a 1-byte (n <= 256) or 2-byte
+ * *            index per row
+ * *   DELTA    zigzag LEB128 varints of the difference to the previous row
+ * * A reader maps the file and decodes only the chunks of the columns a query
+ * * uses, after ruling out whole blocks with the min/max statistics.
+ * =============================================================================
+ */
+
+#ifndef ERRCHECK_ECOL_H
+#define ERRCHECK_ECOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define ERRCHECK_ECOL_MAGIC      "ECOL"
+#define ERRCHECK_ECOL_END_MAGIC  "LOCE"
+#define ERRCHECK_ECOL_VERSION    1u
+#define ERRCHECK_ECOL_BLOCK_ROWS 16384u
+
+typedef enum {
+    ERRCHECK_ECOL_TIMESTAMP = 0,   // ms (first occurrence)
+    ERRCHECK_ECOL_DEVICE,
+    ERRCHECK_ECOL_CODE,
+    ERRCHECK_ECOL_SITE,
+    ERRCHECK_ECOL_INNER,
+    ERRCHECK_ECOL_COUNT,           // Occurrences coalesced into the entry
+    ERRCHECK_ECOL_COLUMNS
+} errcheck_ecol_column_t;
+
+typedef enum {
+    ERRCHECK_ECOL_ENC_PLAIN = 0,
+    ERRCHECK_ECOL_ENC_DICT,
+    ERRCHECK_ECOL_ENC_DELTA
+} errcheck_ecol_encoding_t;
+
+typedef struct {
+    char     magic[4];
+    uint16_t version;
+    uint16_t columns;
+    uint32_t block_rows;
+    uint32_t reserved;
+} errcheck_ecol_header_t;
+
+typedef struct {
+    uint64_t offset[ERRCHECK_ECOL_COLUMNS];
+    uint32_t size[ERRCHECK_ECOL_COLUMNS];
+    uint8_t  encoding[ERRCHECK_ECOL_COLUMNS];
+    uint8_t  pad[2];
+    uint32_t rows;
+    uint32_t reserved;
+    uint64_t min[ERRCHECK_ECOL_COLUMNS];
+    uint64_t max[ERRCHECK_ECOL_COLUMNS];
+} errcheck_ecol_block_t;
+
+typedef struct {
+    uint64_t index_offset;
+    uint64_t rows;
+    uint32_t blocks;
+    char     magic[4];
+} errcheck_ecol_trailer_t;
+
+/* --- Writer --- */
+typedef struct {
+    FILE *f;
+    uint64_t offset;
+    uint64_t rows;
+    uint32_t pending;                           // Rows buffered for the current block
+    uint64_t *col[ERRCHECK_ECOL_COLUMNS];       // ERRCHECK_ECOL_BLOCK_ROWS values each
+    uint64_t *sorted;                           // Dictionary building
+    uint8_t *scratch;                           // Chunk encoding buffer
+    errcheck_ecol_block_t *index;
+    uint32_t blocks, index_cap;
+} errcheck_ecol_writer_t;
+
+int errcheck_ecol_writer_open(errcheck_ecol_writer_t *w, const char *path);
+int errcheck_ecol_writer_add(errcheck_ecol_writer_t *w, const uint64_t row[ERRCHECK_ECOL_COLUMNS]);
+int errcheck_ecol_writer_close(errcheck_ecol_writer_t *w);  // Flushes; writes index and trailer
+
+/* --- Reader (mmap) --- */
+typedef struct {
+    const uint8_t *map;
+    size_t size;
+    const errcheck_ecol_block_t *index;
+    uint32_t blocks;
+    uint64_t rows;
+} errcheck_ecol_reader_t;
+
+int errcheck_ecol_open(errcheck_ecol_reader_t *r, const char *path);
+void errcheck_ecol_close(errcheck_ecol_reader_t *r);
+
+// Decodes one column of one block into out[0 .. rows). Returns 0, or -1 if the
+// chunk is corrupt.
+int errcheck_ecol_read(const errcheck_ecol_reader_t *r, uint32_t block,
+                       errcheck_ecol_column_t col, uint64_t *out);
+
+const char *errcheck_ecol_column_name(errcheck_ecol_column_t col);
+int errcheck_ecol_column_by_name(const char *name);  // -1 if unknown
+
+#endif /* ERRCHECK_ECOL_H */
@@ -0,0 +1,105 @@
+/**
+ * =============================================================================
+ * tools/errcheck_flight_dump.c
+ * * Host tool: prints the records and breadcrumbs left in a flight recorder file,
+ * * e.g. by a supervisor after a child died from SIGKILL or the OOM killer.
+ * * Build: gcc -D ERRCHECK_ENABLE_SHM_RECORDER -I src tools/errcheck_flight_dump.c \
+ * *        src/err_history.c src/err_attach.c src/errcheck.c -o errcheck_flight_dump
+ * * Usage: errcheck_flight_dump /dev/shm/<name>
+ * =============================================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "err_history.h"
+
+// Prints the attachments of one record, one entry per line
+static void print_attachments(const errcheck_history_header_t *hdr, const errcheck_record_t *rec)
+{
+    uint8_t data[256];
+    uint16_t flags = 0;
+    uint16_t len = errcheck_history_attachments(hdr, rec, data, sizeof(data), &flags);
+    uint16_t pos = 0;
+    errcheck_attach_t att;
+
+    if (len == 0) {
+        if ((rec->flags & ERRCHECK_REC_ATTACHED) != 0) {
+            printf("          (attachments overwritten)\n");
+        }
+        return;
+    }
+    while (errcheck_attach_next(data, len, &pos, &att)) {
+        printf("          key %-3u = ", (unsigned)att.key);
+        switch (att.type) {
+        case ERRCHECK_ATT_I32:
+            printf("%" PRId64 "\n", (int64_t)att.value);
+            break;
+        case ERRCHECK_ATT_HEX32:
+            printf("0x%08" PRIX64 "\n", att.value);
+            break;
+        case ERRCHECK_ATT_BYTES:
+            for (uint8_t i = 0; i < att.size; i++) {
+                printf("%02X%s", att.bytes[i], (i + 1u < att.size) ? " " : "");
+            }
+            printf("\n");
+            break;
+        default:
+            printf("%" PRIu64 "\n", att.value);
+            break;
+        }
+    }
+    if (pos != len) {
+        printf("          (malformed entry at byte %u)\n", (unsigned)pos);
+    }
+    if ((flags & ERRCHECK_ATTACH_TRUNCATED) != 0) {
+        printf("          (truncated: some attachments did not fit)\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = 0;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <flight-recorder-file>\n", argv[0]);
+        return 2;
+    }
+    const errcheck_history_header_t *hdr = errcheck_flight_attach(argv[1], &size);
+    if (hdr == NULL) {
+        fprintf(stderr, "%s: not a flight recorder file\n", argv[1]);
+        return 1;
+    }
+
+    printf("generation %" PRIu32 ", last writer pid %" PRIu32 ", %" PRIu32
+           " records / %" PRIu32 " breadcrumbs written\n",
+           hdr->generation, hdr->owner_pid, hdr->record_head, hdr->breadcrumb_head);
+
+    errcheck_record_t *recs = calloc(hdr->record_depth, sizeof(*recs));
+    errcheck_breadcrumb_t *crumbs = calloc(hdr->breadcrumb_depth, sizeof(*crumbs));
+    if (recs == NULL || crumbs == NULL) {
+        return 1;
+    }
+
+    uint32_t n = errcheck_breadcrumb_read(hdr, crumbs, hdr->breadcrumb_depth);
+    printf("\n--- breadcrumbs (oldest first) ---\n");
+    for (uint32_t i = 0; i < n; i++) {
+        printf("%20" PRIu64 " ns  tag=%-10" PRIu32 " value=0x%08" PRIX32 "\n",
+               crumbs[i].timestamp_ns, crumbs[i].tag, crumbs[i].value);
+    }
+
+    n = errcheck_history_read(hdr, recs, hdr->record_depth);
+    printf("\n--- failures (oldest first) ---\n");
+    for (uint32_t i = 0; i < n; i++) {
+        printf("#%-8" PRIu32 " %20" PRIu64 " ns  code=%-4" PRIu32 " inner=0x%08" PRIX32
+               " site=0x%08" PRIX32 ":%" PRIu32 " flags=0x%04X\n",
+               recs[i].seq, recs[i].timestamp_ns, recs[i].code, recs[i].inner_code,
+               recs[i].site, recs[i].line, recs[i].flags);
+        print_attachments(hdr, &recs[i]);
+    }
+
+    free(recs);
+    free(crumbs);
+    errcheck_flight_detach(hdr, size);
+    return 0;
+}
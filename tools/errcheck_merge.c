@@ -0,0 +1,366 @@
+/**
+ * =============================================================================
+ * tools/errcheck_merge.c
+ * * Host tool: merges many failure/breadcrumb streams, each already in time
+ * * order, into one timestamp-ordered timeline (k-way merge over a min-heap of
+ * * stream heads, O(log k) per event).
+ * * Inputs (detected from their first bytes; a capture may open with up to
+ * * 4 KB of noise before its first valid frame):
+ * *   flight recorder files      records and breadcrumbs (err_history.h)
+ * *   sealed slot dumps          flash images of errcheck_retained_slot_t,
+ * *                              in append order; CRC-checked, bad slots skipped
+ * *   telemetry captures         downlink frames (err_telemetry.h), timestamps in ms
+ * * Memory is bounded by the number of inputs, not their size: dumps and captures
+ * * are streamed through a small per-input buffer, so inputs of tens of GB merge
+ * * in constant memory. Streams that step back in time (clock reset, reboot)
+ * * are still merged; such regressions are counted per input.
+ * * Build: gcc -O2 -I src tools/errcheck_merge.c src/err_history.c src/errcheck.c \
+ * *        src/err_telemetry.c src/err_crc32c.c -o errcheck_merge
+ * * Usage: errcheck_merge input...   (timeline on stdout, summary on stderr)
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L // mmap(), posix_fadvise()
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "err_history.h"
+#include "err_retained.h"
+#include "err_telemetry.h"
+#include "err_crc32c.h"
+
+#define NS_PER_MS 1000000ull
+#define SNIFF_BYTES 4096u   // Noise tolerated before the first frame of a capture
+
+typedef enum { EV_FAILURE, EV_BREADCRUMB } event_kind_t;
+
+typedef struct {
+    uint64_t ts_ns;
+    event_kind_t kind;
+    uint32_t code, inner_code, site, line, count;   // Failures
+    uint32_t tag, value;                            // Breadcrumbs
+    int32_t device;                                 // Telemetry device id, -1 otherwise
+} event_t;
+
+typedef struct stream stream_t;
+struct stream {
+    const char *name;
+    int (*next)(stream_t *s, event_t *ev);          // 1 = event, 0 = end of stream
+    event_t head;
+    uint64_t last_ts;
+    uint64_t events, regressions;
+
+    // Flight recorder: both rings copied out of the mapping
+    errcheck_record_t *recs;
+    errcheck_breadcrumb_t *crumbs;
+    uint32_t nrecs, ncrumbs, rpos, cpos;
+
+    // Slot dumps and telemetry captures: streamed
+    FILE *f;
+    uint64_t bad;
+    uint8_t win[ERRCHECK_TLM_MAX_FRAME * 4u];
+    size_t have, off;
+    int eof;
+    errcheck_tlm_entry_t entries[ERRCHECK_TLM_MAX_ENTRIES];
+    uint32_t nent, epos;
+    uint16_t device;
+};
+
+/* ========================================================================= */
+/* Sources                                                                   */
+/* ========================================================================= */
+static void failure_event(event_t *ev, const errcheck_record_t *r)
+{
+    memset(ev, 0, sizeof(*ev));
+    ev->ts_ns = r->timestamp_ns;
+    ev->kind = EV_FAILURE;
+    ev->code = r->code;
+    ev->inner_code = r->inner_code;
+    ev->site = r->site;
+    ev->line = r->line;
+    ev->count = 1;
+    ev->device = -1;
+}
+
+static int flight_next(stream_t *s, event_t *ev)
+{
+    bool rec_left = s->rpos < s->nrecs, crumb_left = s->cpos < s->ncrumbs;
+
+    if (rec_left && (!crumb_left
+                     || s->recs[s->rpos].timestamp_ns <= s->crumbs[s->cpos].timestamp_ns)) {
+        failure_event(ev, &s->recs[s->rpos++]);
+        return 1;
+    }
+    if (crumb_left) {
+        memset(ev, 0, sizeof(*ev));
+        ev->ts_ns = s->crumbs[s->cpos].timestamp_ns;
+        ev->kind = EV_BREADCRUMB;
+        ev->tag = s->crumbs[s->cpos].tag;
+        ev->value = s->crumbs[s->cpos].value;
+        ev->device = -1;
+        s->cpos++;
+        return 1;
+    }
+    return 0;
+}
+
+static int slots_next(stream_t *s, event_t *ev)
+{
+    errcheck_retained_slot_t slot;
+
+    while (fread(&slot, sizeof(slot), 1, s->f) == 1) {
+        if (slot.magic != ERRCHECK_RETAINED_PENDING && slot.magic != ERRCHECK_RETAINED_MIGRATED) {
+            continue;   // Erased or unused
+        }
+        uint32_t crc = errcheck_crc32c(0, &slot.seq, sizeof(slot.seq));
+        if (slot.seq == 0 || errcheck_crc32c(crc, &slot.rec, sizeof(slot.rec)) != slot.crc) {
+            s->bad++;
+            continue;
+        }
+        failure_event(ev, &slot.rec);
+        return 1;
+    }
+    return 0;
+}
+
+// Decodes the next frame of a capture into s->entries; 0 at end of input
+static int tlm_fill(stream_t *s)
+{
+    errcheck_tlm_header_t hdr;
+
+    for (;;) {
+        while (s->off < s->have) {
+            const uint8_t *p = s->win + s->off;
+            size_t avail = s->have - s->off;
+            size_t flen = errcheck_tlm_frame_len(p, avail);
+
+            if ((flen == 0 && avail < 3u && p[0] == ERRCHECK_TLM_SYNC0)
+                || (flen >= ERRCHECK_TLM_MIN_FRAME && flen > avail)) {
+                if (!s->eof) {
+                    break;  // Needs more bytes
+                }
+            }
+            int n = (flen != 0 && flen <= avail)
+                  ? errcheck_tlm_decode(p, flen, &hdr, s->entries, ERRCHECK_TLM_MAX_ENTRIES) : -1;
+            if (n < 0) {
+                s->bad += (flen != 0);
+                s->off++;   // Resynchronise
+                continue;
+            }
+            s->off += flen;
+            if (n > 0) {
+                s->nent = (uint32_t)n;
+                s->epos = 0;
+                s->device = hdr.device_id;
+                return 1;
+            }
+        }
+        if (s->eof) {
+            return 0;
+        }
+        memmove(s->win, s->win + s->off, s->have - s->off);
+        s->have -= s->off;
+        s->off = 0;
+        size_t got = fread(s->win + s->have, 1, sizeof(s->win) - s->have, s->f);
+        s->have += got;
+        s->eof = (got == 0);
+    }
+}
+
+static int tlm_next(stream_t *s, event_t *ev)
+{
+    if (s->epos == s->nent && !tlm_fill(s)) {
+        return 0;
+    }
+    const errcheck_tlm_entry_t *e = &s->entries[s->epos++];
+    memset(ev, 0, sizeof(*ev));
+    ev->ts_ns = e->timestamp_ms * NS_PER_MS;
+    ev->kind = EV_FAILURE;
+    ev->code = e->code;
+    ev->inner_code = e->inner_code;
+    ev->site = e->site;
+    ev->count = e->count;
+    ev->device = s->device;
+    return 1;
+}
+
+// A capture may open with line noise or a partial frame: it counts as one if a
+// frame with a valid CRC starts within its first SNIFF_BYTES
+static bool sniff_capture(stream_t *s)
+{
+    static uint8_t buf[SNIFF_BYTES + ERRCHECK_TLM_MAX_FRAME];
+    errcheck_tlm_header_t hdr;
+    size_t got = fread(buf, 1, sizeof(buf), s->f);
+
+    rewind(s->f);
+    for (size_t off = 0; off < got && off < SNIFF_BYTES; off++) {
+        size_t flen = errcheck_tlm_frame_len(buf + off, got - off);
+        if (flen != 0 && flen <= got - off
+            && errcheck_tlm_decode(buf + off, flen, &hdr, s->entries, ERRCHECK_TLM_MAX_ENTRIES) >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int open_stream(stream_t *s, const char *path)
+{
+    uint8_t magic[4];
+    struct stat sb;
+
+    memset(s, 0, sizeof(*s));
+    s->name = path;
+    if ((s->f = fopen(path, "rb")) == NULL || fstat(fileno(s->f), &sb) != 0) {
+        return -1;
+    }
+    if (fread(magic, 1, sizeof(magic), s->f) != sizeof(magic)) {
+        return -1;
+    }
+    rewind(s->f);
+    posix_fadvise(fileno(s->f), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    uint32_t m;
+    memcpy(&m, magic, sizeof(m));
+    if (m == ERRCHECK_HISTORY_MAGIC) {
+        size_t size = (size_t)sb.st_size;
+        const void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(s->f), 0);
+        fclose(s->f);
+        s->f = NULL;
+        if (map == MAP_FAILED || !errcheck_history_header_valid(map, size)) {
+            return -1;
+        }
+        const errcheck_history_header_t *hdr = map;
+        s->recs = calloc(hdr->record_depth, sizeof(*s->recs));
+        s->crumbs = calloc(hdr->breadcrumb_depth, sizeof(*s->crumbs));
+        if (s->recs == NULL || s->crumbs == NULL) {
+            return -1;
+        }
+        s->nrecs = errcheck_history_read(hdr, s->recs, hdr->record_depth);
+        s->ncrumbs = errcheck_breadcrumb_read(hdr, s->crumbs, hdr->breadcrumb_depth);
+        munmap((void *)(uintptr_t)map, size);
+        s->next = flight_next;
+    } else if (m == ERRCHECK_RETAINED_PENDING || m == ERRCHECK_RETAINED_MIGRATED) {
+        s->next = slots_next;
+    } else if ((magic[0] == ERRCHECK_TLM_SYNC0 && magic[1] == ERRCHECK_TLM_SYNC1)
+               || sniff_capture(s)) {
+        s->next = tlm_next;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/* ========================================================================= */
+/* Merge                                                                     */
+/* ========================================================================= */
+// Orders by timestamp, then by input position so equal timestamps stay stable
+static bool before(const stream_t *a, const stream_t *b)
+{
+    return a->head.ts_ns < b->head.ts_ns || (a->head.ts_ns == b->head.ts_ns && a < b);
+}
+
+static void sift_down(stream_t **heap, size_t n, size_t i)
+{
+    for (;;) {
+        size_t l = 2u * i + 1u, r = l + 1u, min = i;
+        if (l < n && before(heap[l], heap[min])) {
+            min = l;
+        }
+        if (r < n && before(heap[r], heap[min])) {
+            min = r;
+        }
+        if (min == i) {
+            return;
+        }
+        stream_t *t = heap[i];
+        heap[i] = heap[min];
+        heap[min] = t;
+        i = min;
+    }
+}
+
+static void print_event(const stream_t *s, const event_t *ev)
+{
+    printf("%20" PRIu64 " %-24s ", ev->ts_ns, s->name);
+    if (ev->kind == EV_BREADCRUMB) {
+        printf("crumb   tag=%-10" PRIu32 " value=0x%08" PRIX32 "\n", ev->tag, ev->value);
+        return;
+    }
+    printf("failure code=%-4" PRIu32 " inner=0x%08" PRIX32 " site=0x%08" PRIX32,
+           ev->code, ev->inner_code, ev->site);
+    if (ev->line != 0) {
+        printf(":%" PRIu32, ev->line);
+    }
+    if (ev->device >= 0) {
+        printf(" dev=%" PRId32, ev->device);
+    }
+    if (ev->count > 1) {
+        printf(" x%" PRIu32, ev->count);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s input...\n", argv[0]);
+        return 2;
+    }
+
+    size_t k = (size_t)argc - 1u, n = 0;
+    stream_t *streams = calloc(k, sizeof(*streams));
+    stream_t **heap = calloc(k, sizeof(*heap));
+    if (streams == NULL || heap == NULL) {
+        return 1;
+    }
+    static char outbuf[1u << 20];
+    setvbuf(stdout, outbuf, _IOFBF, sizeof(outbuf));
+
+    for (size_t i = 0; i < k; i++) {
+        stream_t *s = &streams[i];
+        if (open_stream(s, argv[i + 1]) != 0) {
+            fprintf(stderr, "%s: unreadable or unknown format\n", argv[i + 1]);
+            return 1;
+        }
+        if (s->next(s, &s->head)) {
+            heap[n++] = s;
+        }
+    }
+    for (size_t i = n / 2u; i-- > 0;) {
+        sift_down(heap, n, i);
+    }
+
+    while (n > 0) {
+        stream_t *s = heap[0];
+        print_event(s, &s->head);
+        s->events++;
+        s->last_ts = s->head.ts_ns;
+
+        if (s->next(s, &s->head)) {
+            s->regressions += (s->head.ts_ns < s->last_ts);
+        } else {
+            heap[0] = heap[--n];
+        }
+        sift_down(heap, n, 0);
+    }
+    fflush(stdout);
+
+    for (size_t i = 0; i < k; i++) {
+        stream_t *s = &streams[i];
+        fprintf(stderr, "%-24s %12" PRIu64 " events, %" PRIu64 " bad, %" PRIu64
+                " time regression(s)\n", s->name, s->events, s->bad, s->regressions);
+        if (s->f != NULL) {
+            fclose(s->f);
+        }
+        free(s->recs);
+        free(s->crumbs);
+    }
+    free(heap);
+    free(streams);
+    return 0;
+}
@@ -0,0 +1,380 @@
+/**
+ * =============================================================================
+ * tools/errcheck_minidump.c
+ * * Host tool: prints a minidump written by err_minidump.c. It shows the
+ * * failing thread's registers, return address candidates found by scanning its
+ * * stack against the executable mappings, the thread list, the errcheck
+ * * history and how long the writer took.
+ * * Build: gcc -O2 -I src tools/errcheck_minidump.c src/err_history.c \
+ * *        src/err_attach.c src/errcheck.c -o errcheck_minidump
+ * * Usage: errcheck_minidump [-x] [-m] dump-file
+ * *        -x  hex dump of the stack   -m  print the memory map
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L // getopt()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "err_minidump.h"
+#include "err_history.h"
+
+#define SCAN_MAX_FRAMES 32u
+
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    uint64_t offset;
+    const char *path;
+} exec_map_t;
+
+typedef struct {
+    const errcheck_minidump_header_t *hdr;
+    const errcheck_minidump_context_t *ctx;
+    const errcheck_minidump_regs_t *regs;
+    const uint64_t *reg_values;
+    uint64_t stack_base;
+    const uint8_t *stack;
+    uint32_t stack_size;
+    const errcheck_minidump_thread_t *threads;
+    uint32_t thread_count;
+    const uint8_t *history;
+    uint32_t history_size;
+    char *maps;                 // Concatenated MAPS streams, NUL-terminated
+    size_t maps_len;
+    const errcheck_minidump_end_t *end;
+} dump_t;
+
+static const char *const s_x86_64_regs[] = {
+    "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "rdi", "rsi", "rbp", "rbx",
+    "rdx", "rax", "rcx", "rsp", "rip", "eflags", "csgsfs", "err", "trapno", "oldmask", "cr2"
+};
+
+static const char *signal_name(int sig)
+{
+    switch (sig) {
+    case 0:  return "none (errcheck_minidump_fatal)";
+    case 4:  return "SIGILL";
+    case 5:  return "SIGTRAP";
+    case 6:  return "SIGABRT";
+    case 7:  return "SIGBUS";
+    case 8:  return "SIGFPE";
+    case 11: return "SIGSEGV";
+    default: return "signal";
+    }
+}
+
+static const char *reg_name(const dump_t *d, uint32_t i, char *buf, size_t size)
+{
+    if ((d->regs->flags & ERRCHECK_MD_REGS_PARTIAL) != 0) {
+        static const char *const partial[] = { "pc", "sp", "fp" };
+        return (i < 3u) ? partial[i] : "?";
+    }
+    if (d->hdr->arch == 62 && i < sizeof(s_x86_64_regs) / sizeof(s_x86_64_regs[0])) {
+        return s_x86_64_regs[i];
+    }
+    if (d->hdr->arch == 183) {
+        static const char *const tail[] = { "sp", "pc", "pstate" };
+        if (i >= 31u && i < 34u) {
+            return tail[i - 31u];
+        }
+        snprintf(buf, size, "x%u", (unsigned)i);
+        return buf;
+    }
+    snprintf(buf, size, "r%u", (unsigned)i);
+    return buf;
+}
+
+static bool parse(uint8_t *data, size_t size, dump_t *d)
+{
+    size_t pos = sizeof(errcheck_minidump_header_t);
+
+    memset(d, 0, sizeof(*d));
+    d->hdr = (const errcheck_minidump_header_t *)data;
+    if (size < pos || d->hdr->magic != ERRCHECK_MINIDUMP_MAGIC ||
+        d->hdr->version != ERRCHECK_MINIDUMP_VERSION) {
+        return false;
+    }
+    d->maps = calloc(1, size + 1u);
+    if (d->maps == NULL) {
+        return false;
+    }
+
+    while (pos + sizeof(errcheck_minidump_stream_t) <= size) {
+        const errcheck_minidump_stream_t *s = (const errcheck_minidump_stream_t *)&data[pos];
+        const uint8_t *p = &data[pos + sizeof(*s)];
+        if (s->size > size - pos - sizeof(*s)) {
+            break; // Cut short while writing
+        }
+        switch (s->type) {
+        case ERRCHECK_MD_CONTEXT:
+            d->ctx = (s->size >= sizeof(*d->ctx)) ? (const void *)p : NULL;
+            break;
+        case ERRCHECK_MD_REGISTERS:
+            if (s->size >= sizeof(*d->regs)) {
+                d->regs = (const void *)p;
+                d->reg_values = (const uint64_t *)(p + sizeof(*d->regs));
+                if (d->regs->count > (s->size - sizeof(*d->regs)) / sizeof(uint64_t)) {
+                    d->regs = NULL;
+                }
+            }
+            break;
+        case ERRCHECK_MD_STACK:
+            if (s->size >= sizeof(uint64_t)) {
+                memcpy(&d->stack_base, p, sizeof(uint64_t));
+                d->stack = p + sizeof(uint64_t);
+                d->stack_size = s->size - (uint32_t)sizeof(uint64_t);
+            }
+            break;
+        case ERRCHECK_MD_THREADS:
+            d->threads = (const void *)p;
+            d->thread_count = s->size / (uint32_t)sizeof(errcheck_minidump_thread_t);
+            break;
+        case ERRCHECK_MD_HISTORY:
+            d->history = p;
+            d->history_size = s->size;
+            break;
+        case ERRCHECK_MD_MAPS:
+            memcpy(d->maps + d->maps_len, p, s->size);
+            d->maps_len += s->size;
+            break;
+        case ERRCHECK_MD_END:
+            d->end = (s->size >= sizeof(*d->end)) ? (const void *)p : NULL;
+            break;
+        default:
+            break; // Written by a newer version: skip
+        }
+        pos += sizeof(*s) + ((s->size + 7u) & ~7u);
+    }
+    return true;
+}
+
+// Executable file mappings from the dumped /proc/self/maps
+static size_t load_exec_maps(char *maps, exec_map_t **out)
+{
+    size_t n = 0, cap = 0;
+    exec_map_t *m = NULL;
+
+    for (char *line = strtok(maps, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        unsigned long long start, end, offset;
+        char perms[8];
+        int path_at = 0;
+        if (sscanf(line, "%llx-%llx %7s %llx %*s %*s %n", &start, &end, perms, &offset,
+                   &path_at) < 4 || perms[2] != 'x' || path_at == 0 || line[path_at] != '/') {
+            continue;
+        }
+        if (n == cap) {
+            cap = cap ? cap * 2u : 32u;
+            exec_map_t *grown = realloc(m, cap * sizeof(*m));
+            if (grown == NULL) {
+                break;
+            }
+            m = grown;
+        }
+        m[n++] = (exec_map_t){ start, end, offset, &line[path_at] };
+    }
+    *out = m;
+    return n;
+}
+
+static const exec_map_t *find_map(const exec_map_t *m, size_t n, uint64_t addr)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (addr >= m[i].start && addr < m[i].end) {
+            return &m[i];
+        }
+    }
+    return NULL;
+}
+
+static void print_location(const exec_map_t *m, size_t n, uint64_t addr)
+{
+    const exec_map_t *map = find_map(m, n, addr);
+
+    if (map != NULL) {
+        const char *base = strrchr(map->path, '/');
+        printf("  %s+0x%" PRIx64, base ? base + 1 : map->path, addr - map->start + map->offset);
+    }
+    printf("\n");
+}
+
+static void print_attachments(const errcheck_history_header_t *hdr, const errcheck_record_t *rec)
+{
+    uint8_t data[256];
+    uint16_t flags = 0;
+    uint16_t len = errcheck_history_attachments(hdr, rec, data, sizeof(data), &flags);
+    uint16_t pos = 0;
+    errcheck_attach_t att;
+
+    if (len == 0) {
+        return;
+    }
+    printf("           ");
+    while (errcheck_attach_next(data, len, &pos, &att)) {
+        if (att.type == ERRCHECK_ATT_BYTES) {
+            printf(" %u=[%u bytes]", (unsigned)att.key, (unsigned)att.size);
+        } else if (att.type == ERRCHECK_ATT_HEX32) {
+            printf(" %u=0x%08" PRIX64, (unsigned)att.key, att.value);
+        } else if (att.type == ERRCHECK_ATT_I32) {
+            printf(" %u=%" PRId64, (unsigned)att.key, (int64_t)att.value);
+        } else {
+            printf(" %u=%" PRIu64, (unsigned)att.key, att.value);
+        }
+    }
+    printf("%s\n", (flags & ERRCHECK_ATTACH_TRUNCATED) ? " (truncated)" : "");
+}
+
+static void print_history(const dump_t *d)
+{
+    const errcheck_history_header_t *hdr = (const errcheck_history_header_t *)d->history;
+
+    if (d->history_size < sizeof(*hdr) || !errcheck_history_header_valid(hdr, d->history_size)) {
+        printf("\n--- history: region not valid ---\n");
+        return;
+    }
+    errcheck_record_t *recs = calloc(hdr->record_depth, sizeof(*recs));
+    errcheck_breadcrumb_t *crumbs = calloc(hdr->breadcrumb_depth, sizeof(*crumbs));
+    if (recs == NULL || crumbs == NULL) {
+        free(recs);
+        free(crumbs);
+        return;
+    }
+
+    uint32_t n = errcheck_breadcrumb_read(hdr, crumbs, hdr->breadcrumb_depth);
+    printf("\n--- breadcrumbs (oldest first, ns before the dump) ---\n");
+    for (uint32_t i = 0; i < n; i++) {
+        printf("%14" PRId64 "  tag=%-10" PRIu32 " value=0x%08" PRIX32 "\n",
+               (int64_t)(d->hdr->timestamp_ns - crumbs[i].timestamp_ns), crumbs[i].tag,
+               crumbs[i].value);
+    }
+    n = errcheck_history_read(hdr, recs, hdr->record_depth);
+    printf("\n--- failures (oldest first, ns before the dump) ---\n");
+    for (uint32_t i = 0; i < n; i++) {
+        printf("#%-6" PRIu32 " %14" PRId64 "  code=%-4" PRIu32 " inner=0x%08" PRIX32
+               " site=0x%08" PRIX32 ":%" PRIu32 "\n",
+               recs[i].seq, (int64_t)(d->hdr->timestamp_ns - recs[i].timestamp_ns), recs[i].code,
+               recs[i].inner_code, recs[i].site, recs[i].line);
+        print_attachments(hdr, &recs[i]);
+    }
+    free(recs);
+    free(crumbs);
+}
+
+int main(int argc, char **argv)
+{
+    bool hex = false, show_maps = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "xm")) != -1) {
+        if (opt == 'x') {
+            hex = true;
+        } else if (opt == 'm') {
+            show_maps = true;
+        } else {
+            fprintf(stderr, "usage: %s [-x] [-m] dump-file\n", argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "usage: %s [-x] [-m] dump-file\n", argv[0]);
+        return 2;
+    }
+
+    FILE *f = fopen(argv[optind], "rb");
+    if (f == NULL) {
+        perror(argv[optind]);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = (size > 0) ? malloc((size_t)size) : NULL;
+    if (data == NULL || fread(data, 1, (size_t)size, f) != (size_t)size) {
+        fprintf(stderr, "%s: cannot read\n", argv[optind]);
+        return 1;
+    }
+    fclose(f);
+
+    dump_t d;
+    if (!parse(data, (size_t)size, &d)) {
+        fprintf(stderr, "%s: not an errcheck minidump\n", argv[optind]);
+        return 1;
+    }
+    if (show_maps) {
+        printf("--- memory map ---\n%s\n", d.maps);
+    }
+    exec_map_t *maps = NULL;
+    size_t map_count = load_exec_maps(d.maps, &maps);
+
+    const errcheck_minidump_header_t *h = d.hdr;
+    printf("pid %" PRIu32 ", thread %" PRIu32 ": %s (%" PRId32 "), si_code %" PRId32
+           ", address 0x%" PRIx64 "\n", h->pid, h->tid, signal_name(h->signal), h->signal,
+           h->si_code, h->fault_addr);
+    if (d.end != NULL) {
+        printf("dump written in %.1f us%s%s%s\n", (double)d.end->duration_ns / 1e3,
+               (d.end->flags & ERRCHECK_MD_TRUNC_THREADS) ? ", thread list truncated" : "",
+               (d.end->flags & ERRCHECK_MD_TRUNC_MAPS) ? ", memory map truncated" : "",
+               (d.end->flags & ERRCHECK_MD_NO_STACK) ? ", no stack" : "");
+    } else {
+        printf("INCOMPLETE dump: the writer did not finish\n");
+    }
+    if (d.ctx != NULL) {
+        printf("last failure: code %" PRIu32 " inner 0x%08" PRIX32 " at %s:%" PRIu32 "%s\n",
+               d.ctx->code, d.ctx->inner_code, d.ctx->file[0] ? d.ctx->file : "N/A",
+               d.ctx->line, d.ctx->logged ? " (logged)" : "");
+    }
+
+    if (d.regs != NULL) {
+        printf("\n--- registers ---\n");
+        for (uint32_t i = 0; i < d.regs->count; i++) {
+            char buf[16];
+            printf("%-8s 0x%016" PRIx64, reg_name(&d, i, buf, sizeof(buf)), d.reg_values[i]);
+            print_location(maps, map_count, d.reg_values[i]);
+        }
+    }
+
+    if (d.stack != NULL) {
+        printf("\n--- stack: %" PRIu32 " bytes from 0x%" PRIx64 " ---\n", d.stack_size, d.stack_base);
+        uint32_t found = 0;
+        for (uint32_t off = 0; off + 8u <= d.stack_size && found < SCAN_MAX_FRAMES; off += 8u) {
+            uint64_t v;
+            memcpy(&v, &d.stack[off], sizeof(v));
+            if (find_map(maps, map_count, v) != NULL) {
+                printf("sp+0x%04" PRIx32 " 0x%016" PRIx64, off, v);
+                print_location(maps, map_count, v);
+                found++;
+            }
+        }
+        for (uint32_t off = 0; hex && off < d.stack_size; off += 16u) {
+            printf("%016" PRIx64 ":", d.stack_base + off);
+            for (uint32_t i = off; i < off + 16u && i < d.stack_size; i++) {
+                printf(" %02x", d.stack[i]);
+            }
+            printf("\n");
+        }
+    }
+
+    printf("\n--- threads ---\n");
+    for (uint32_t i = 0; i < d.thread_count; i++) {
+        const errcheck_minidump_thread_t *t = &d.threads[i];
+        printf("%c %-7" PRIu32 " %-16.16s %c", (t->tid == h->tid) ? '*' : ' ', t->tid, t->name,
+               t->state);
+        if (t->blocked) {
+            printf("  sp 0x%016" PRIx64 " pc 0x%016" PRIx64, t->sp, t->pc);
+            print_location(maps, map_count, t->pc);
+        } else {
+            printf("\n");
+        }
+    }
+
+    if (d.history != NULL) {
+        print_history(&d);
+    }
+
+    free(maps);
+    free(d.maps);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,496 @@
+/**
+ * =============================================================================
+ * tools/errcheck_preload.c
+ * * LD_PRELOAD shim: fails selected libc calls on the same once/nth/every/rate
+ * * schedule as errcheck's rule-based injection (err_inject.c, linked in), and
+ * * reports which CHECK() site caught each injected failure.
+ * * Interposed: open open64 openat fopen fopen64 read write close ioctl socket
+ * *             connect malloc calloc realloc
+ * * Build: gcc -shared -fPIC -fvisibility=hidden -O2 -D ERRCHECK_ENABLE_INJECT \
+ * *        -D ERRCHECK_INJECT_NO_ENV -D ERRCHECK_NVRAM_STUB_SILENT -I src tools/errcheck_preload.c \
+ * *        src/err_inject.c src/errcheck.c -ldl -o errcheck_preload.so
+ * * Usage: ERRCHECK_PRELOAD='open:every=3:errno=EACCES;malloc:rate=1/1000' \
+ * *        LD_PRELOAD=./errcheck_preload.so ./app
+ * *   rules   fn:[once|nth=N|every=N|rate=A/B][:latency=US][:errno=NAME|N] ; ...
+ * *   ERRCHECK_PRELOAD_LOG=file  report to a file instead of stderr
+ * * Attribution: errcheck.c calls the weak errcheck_preload_observed() for each
+ * * logged failure, and this shim defines it. The failure is credited to the
+ * * last failure injected on the same thread. An injected failure that no CHECK
+ * * logged before the thread's next injection (or exit) is reported as not
+ * * observed: a swallowed error. The application must be dynamically linked.
+ * =============================================================================
+ */
+
+#define _GNU_SOURCE // RTLD_NEXT, dladdr()
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "err_inject.h"
+
+#ifndef ERRCHECK_INJECT_NO_ENV
+    // The application's own err_inject.c owns ERRCHECK_INJECT and the report file
+    #error "build the shim with -D ERRCHECK_INJECT_NO_ENV"
+#endif
+
+#define PL_EXPORT __attribute__((visibility("default")))
+
+typedef enum {
+    PL_OPEN, PL_OPEN64, PL_OPENAT, PL_FOPEN, PL_FOPEN64, PL_READ, PL_WRITE, PL_CLOSE,
+    PL_IOCTL, PL_SOCKET, PL_CONNECT, PL_MALLOC, PL_CALLOC, PL_REALLOC, PL_FUNCS
+} pl_func_t;
+
+static const char *const s_pl_names[PL_FUNCS] = {
+    "open", "open64", "openat", "fopen", "fopen64", "read", "write", "close",
+    "ioctl", "socket", "connect", "malloc", "calloc", "realloc",
+};
+
+static const struct { const char *name; int value; } s_pl_errnos[] = {
+    { "EIO", EIO }, { "ENOENT", ENOENT }, { "EACCES", EACCES }, { "EPERM", EPERM },
+    { "ENOMEM", ENOMEM }, { "ENOSPC", ENOSPC }, { "EAGAIN", EAGAIN }, { "EINTR", EINTR },
+    { "EBADF", EBADF }, { "EMFILE", EMFILE }, { "ETIMEDOUT", ETIMEDOUT },
+    { "ECONNREFUSED", ECONNREFUSED }, { "ENODEV", ENODEV }, { "EBUSY", EBUSY },
+};
+
+typedef struct {
+    int armed;
+    int err;                    // errno reported by an injected failure
+    uint32_t injected;
+    uint32_t observed;
+} pl_stat_t;
+
+// Injected failure waiting for a CHECK on the same thread
+typedef struct {
+    int pending;
+    pl_func_t fn;
+    uint32_t serial;
+} pl_pending_t;
+
+static pl_stat_t s_pl[PL_FUNCS];
+static int s_pl_ready = 0;
+static int s_pl_log = 2;
+static uint32_t s_pl_serial = 0;
+static __thread int t_pl_busy = 0;
+static __thread pl_pending_t t_pl_pending;
+
+/* ========================================================================= */
+/* Real functions                                                            */
+/* ========================================================================= */
+static int (*real_open)(const char *, int, ...);
+static int (*real_open64)(const char *, int, ...);
+static int (*real_openat)(int, const char *, int, ...);
+static FILE *(*real_fopen)(const char *, const char *);
+static FILE *(*real_fopen64)(const char *, const char *);
+static ssize_t (*real_read)(int, void *, size_t);
+static ssize_t (*real_write)(int, const void *, size_t);
+static int (*real_close)(int);
+static int (*real_ioctl)(int, unsigned long, ...);
+static int (*real_socket)(int, int, int);
+static int (*real_connect)(int, const struct sockaddr *, socklen_t);
+static void *(*real_malloc)(size_t);
+static void *(*real_calloc)(size_t, size_t);
+static void *(*real_realloc)(void *, size_t);
+static void (*real_free)(void *);
+
+// dlsym() may allocate before real_calloc is known: serve it from here
+static char s_pl_boot[4096];
+static size_t s_pl_boot_used = 0;
+static int s_pl_resolving = 0;
+
+static void *pl_boot_alloc(size_t size)
+{
+    size_t off = (s_pl_boot_used + 15u) & ~(size_t)15u;
+    if (off + size > sizeof(s_pl_boot)) {
+        return NULL;
+    }
+    s_pl_boot_used = off + size;
+    return memset(&s_pl_boot[off], 0, size);
+}
+
+static int pl_is_boot(const void *p)
+{
+    return (const char *)p >= s_pl_boot && (const char *)p < s_pl_boot + sizeof(s_pl_boot);
+}
+
+#define PL_RESOLVE(fn) (*(void **)&real_##fn = dlsym(RTLD_NEXT, #fn))
+
+static void pl_resolve(void)
+{
+    if (real_free != NULL) {
+        return;
+    }
+    s_pl_resolving = 1;
+    PL_RESOLVE(malloc);
+    PL_RESOLVE(calloc);
+    PL_RESOLVE(realloc);
+    PL_RESOLVE(open);
+    PL_RESOLVE(open64);
+    PL_RESOLVE(openat);
+    PL_RESOLVE(fopen);
+    PL_RESOLVE(fopen64);
+    PL_RESOLVE(read);
+    PL_RESOLVE(write);
+    PL_RESOLVE(close);
+    PL_RESOLVE(ioctl);
+    PL_RESOLVE(socket);
+    PL_RESOLVE(connect);
+    PL_RESOLVE(free);
+    s_pl_resolving = 0;
+}
+
+/* ========================================================================= */
+/* Reporting                                                                 */
+/* ========================================================================= */
+static void pl_report(const char *fmt, ...)
+{
+    char buf[512];
+    va_list ap;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n > 0 && real_write != NULL) {
+        (void)real_write(s_pl_log, buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1u);
+    }
+}
+
+static const char *pl_errno_name(int err)
+{
+    for (size_t i = 0; i < sizeof(s_pl_errnos) / sizeof(s_pl_errnos[0]); i++) {
+        if (s_pl_errnos[i].value == err) {
+            return s_pl_errnos[i].name;
+        }
+    }
+    return "?";
+}
+
+static void pl_unobserved(void)
+{
+    if (t_pl_pending.pending) {
+        pl_report("errcheck_preload: #%" PRIu32 " %s() failure was not observed by any CHECK\n",
+                  t_pl_pending.serial, s_pl_names[t_pl_pending.fn]);
+        t_pl_pending.pending = 0;
+    }
+}
+
+/**
+ * @brief Called by errcheck.c (weak reference) for every failure it logs.
+ */
+PL_EXPORT void errcheck_preload_observed(uint32_t code, const char *file, uint32_t line)
+{
+    if (!t_pl_pending.pending) {
+        return;
+    }
+    t_pl_busy++;
+    __atomic_fetch_add(&s_pl[t_pl_pending.fn].observed, 1u, __ATOMIC_RELAXED);
+    pl_report("errcheck_preload: #%" PRIu32 " %s() failure observed by CHECK at %s:%" PRIu32
+              " (code %" PRIu32 ")\n", t_pl_pending.serial, s_pl_names[t_pl_pending.fn],
+              file != NULL ? file : "?", line, code);
+    t_pl_pending.pending = 0;
+    t_pl_busy--;
+}
+
+// Decides one call; on injection sets errno and records the caller
+static int pl_fail(pl_func_t fn, const void *caller)
+{
+    if (!s_pl_ready || t_pl_busy || !s_pl[fn].armed) {
+        return 0;
+    }
+    t_pl_busy++;
+    int fail = errcheck_inject_eval((uint32_t)fn, NULL, 0, 1) == 0;
+    if (fail) {
+        Dl_info info;
+        char where[256] = "?";
+
+        int found = dladdr(caller, &info) != 0;
+
+        if (found && info.dli_sname != NULL) {
+            snprintf(where, sizeof(where), "%s+0x%" PRIxPTR " (%s)", info.dli_sname,
+                     (uintptr_t)caller - (uintptr_t)info.dli_saddr, info.dli_fname);
+        } else if (found) {
+            snprintf(where, sizeof(where), "%s+0x%" PRIxPTR, info.dli_fname,
+                     (uintptr_t)caller - (uintptr_t)info.dli_fbase);
+        }
+        pl_unobserved();
+        t_pl_pending.pending = 1;
+        t_pl_pending.fn = fn;
+        t_pl_pending.serial = __atomic_add_fetch(&s_pl_serial, 1u, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&s_pl[fn].injected, 1u, __ATOMIC_RELAXED);
+        pl_report("errcheck_preload: #%" PRIu32 " %s() failed with %s, called from %s\n",
+                  t_pl_pending.serial, s_pl_names[fn], pl_errno_name(s_pl[fn].err), where);
+    }
+    t_pl_busy--;
+    if (fail) {
+        errno = s_pl[fn].err;
+    }
+    return fail;
+}
+
+/* ========================================================================= */
+/* Configuration                                                             */
+/* ========================================================================= */
+static int pl_parse_errno(const char *s)
+{
+    for (size_t i = 0; i < sizeof(s_pl_errnos) / sizeof(s_pl_errnos[0]); i++) {
+        if (strcmp(s, s_pl_errnos[i].name) == 0) {
+            return s_pl_errnos[i].value;
+        }
+    }
+    return (int)strtol(s, NULL, 0);
+}
+
+// One "fn:opt:opt" item; returns 0 or -1
+static int pl_parse_rule(char *item)
+{
+    char *save = NULL, *name = strtok_r(item, ":", &save);
+    errcheck_inject_rule_t rule = {
+        .site = ERRCHECK_INJECT_ANY_SITE,
+        .trigger = ERRCHECK_INJECT_ONCE,
+        .fail = true,
+    };
+    int fn = -1, err = 0;
+
+    for (int i = 0; name != NULL && i < PL_FUNCS; i++) {
+        if (strcmp(name, s_pl_names[i]) == 0) {
+            fn = i;
+        }
+    }
+    if (fn < 0) {
+        return -1;
+    }
+    for (char *opt = strtok_r(NULL, ":", &save); opt != NULL; opt = strtok_r(NULL, ":", &save)) {
+        char *val = strchr(opt, '=');
+        if (val != NULL) {
+            *val++ = '\0';
+        }
+        if (strcmp(opt, "once") == 0) {
+            rule.trigger = ERRCHECK_INJECT_ONCE;
+        } else if (val == NULL) {
+            return -1;
+        } else if (strcmp(opt, "nth") == 0 || strcmp(opt, "every") == 0) {
+            rule.trigger = (opt[0] == 'n') ? ERRCHECK_INJECT_NTH : ERRCHECK_INJECT_EVERY;
+            rule.param = (uint32_t)strtoul(val, NULL, 0);
+        } else if (strcmp(opt, "rate") == 0) {
+            char *slash = strchr(val, '/');
+            unsigned long num = strtoul(val, NULL, 0);
+            unsigned long den = slash != NULL ? strtoul(slash + 1, NULL, 0) : 0;
+            if (den == 0 || num > den) {
+                return -1;
+            }
+            rule.trigger = ERRCHECK_INJECT_RATE;
+            rule.param = (uint32_t)(((uint64_t)num << 16) / den);
+        } else if (strcmp(opt, "latency") == 0) {
+            rule.latency_us = (uint32_t)strtoul(val, NULL, 0);
+        } else if (strcmp(opt, "errno") == 0) {
+            err = pl_parse_errno(val);
+        } else {
+            return -1;
+        }
+    }
+
+    rule.code = (uint32_t)fn;
+    if (errcheck_inject_arm(&rule) < 0) {
+        return -1;
+    }
+    s_pl[fn].armed = 1;
+    s_pl[fn].err = err != 0 ? err : (fn >= PL_MALLOC ? ENOMEM : EIO);
+    return 0;
+}
+
+__attribute__((constructor))
+static void pl_init(void)
+{
+    static char spec[1024];
+    const char *env = getenv("ERRCHECK_PRELOAD");
+    const char *log = getenv("ERRCHECK_PRELOAD_LOG");
+    char *save = NULL;
+
+    pl_resolve();
+    if (log != NULL) {
+        int fd = real_open(log, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            s_pl_log = fd;
+        }
+    }
+    if (env == NULL || strlen(env) >= sizeof(spec)) {
+        return;
+    }
+    strcpy(spec, env);
+    for (char *item = strtok_r(spec, ";", &save); item != NULL; item = strtok_r(NULL, ";", &save)) {
+        if (pl_parse_rule(item) != 0) {
+            pl_report("errcheck_preload: ignoring bad rule '%s'\n", item);
+        }
+    }
+    s_pl_ready = 1;
+}
+
+__attribute__((destructor))
+static void pl_fini(void)
+{
+    s_pl_ready = 0;
+    pl_unobserved();
+    for (int i = 0; i < PL_FUNCS; i++) {
+        errcheck_inject_status_t st;
+        if (!s_pl[i].armed) {
+            continue;
+        }
+        for (int r = 0; r < (int)ERRCHECK_INJECT_RULES; r++) {
+            if (errcheck_inject_get(r, &st) && st.rule.code == (uint32_t)i) {
+                pl_report("errcheck_preload: %-8s %8" PRIu32 " calls %6" PRIu32 " injected %6" PRIu32
+                          " observed by a CHECK\n", s_pl_names[i], st.hits,
+                          s_pl[i].injected, s_pl[i].observed);
+            }
+        }
+    }
+}
+
+/* ========================================================================= */
+/* Interposed functions                                                      */
+/* ========================================================================= */
+#define PL_CALLER __builtin_return_address(0)
+
+PL_EXPORT int open(const char *path, int flags, ...)
+{
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list ap;
+        va_start(ap, flags);
+        mode = (mode_t)va_arg(ap, int);
+        va_end(ap);
+    }
+    pl_resolve();
+    return pl_fail(PL_OPEN, PL_CALLER) ? -1 : real_open(path, flags, mode);
+}
+
+PL_EXPORT int open64(const char *path, int flags, ...)
+{
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list ap;
+        va_start(ap, flags);
+        mode = (mode_t)va_arg(ap, int);
+        va_end(ap);
+    }
+    pl_resolve();
+    return pl_fail(PL_OPEN64, PL_CALLER) ? -1 : real_open64(path, flags, mode);
+}
+
+PL_EXPORT int openat(int dirfd, const char *path, int flags, ...)
+{
+    mode_t mode = 0;
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_list ap;
+        va_start(ap, flags);
+        mode = (mode_t)va_arg(ap, int);
+        va_end(ap);
+    }
+    pl_resolve();
+    return pl_fail(PL_OPENAT, PL_CALLER) ? -1 : real_openat(dirfd, path, flags, mode);
+}
+
+PL_EXPORT FILE *fopen(const char *path, const char *mode)
+{
+    pl_resolve();
+    return pl_fail(PL_FOPEN, PL_CALLER) ? NULL : real_fopen(path, mode);
+}
+
+PL_EXPORT FILE *fopen64(const char *path, const char *mode)
+{
+    pl_resolve();
+    return pl_fail(PL_FOPEN64, PL_CALLER) ? NULL : real_fopen64(path, mode);
+}
+
+PL_EXPORT ssize_t read(int fd, void *buf, size_t count)
+{
+    pl_resolve();
+    return pl_fail(PL_READ, PL_CALLER) ? -1 : real_read(fd, buf, count);
+}
+
+PL_EXPORT ssize_t write(int fd, const void *buf, size_t count)
+{
+    pl_resolve();
+    return pl_fail(PL_WRITE, PL_CALLER) ? -1 : real_write(fd, buf, count);
+}
+
+PL_EXPORT int close(int fd)
+{
+    pl_resolve();
+    return pl_fail(PL_CLOSE, PL_CALLER) ? -1 : real_close(fd);
+}
+
+PL_EXPORT int ioctl(int fd, unsigned long request, ...)
+{
+    va_list ap;
+    va_start(ap, request);
+    void *arg = va_arg(ap, void *);
+    va_end(ap);
+    pl_resolve();
+    return pl_fail(PL_IOCTL, PL_CALLER) ? -1 : real_ioctl(fd, request, arg);
+}
+
+PL_EXPORT int socket(int domain, int type, int protocol)
+{
+    pl_resolve();
+    return pl_fail(PL_SOCKET, PL_CALLER) ? -1 : real_socket(domain, type, protocol);
+}
+
+PL_EXPORT int connect(int fd, const struct sockaddr *addr, socklen_t len)
+{
+    pl_resolve();
+    return pl_fail(PL_CONNECT, PL_CALLER) ? -1 : real_connect(fd, addr, len);
+}
+
+PL_EXPORT void *malloc(size_t size)
+{
+    if (s_pl_resolving) {
+        return pl_boot_alloc(size);
+    }
+    pl_resolve();
+    return pl_fail(PL_MALLOC, PL_CALLER) ? NULL : real_malloc(size);
+}
+
+PL_EXPORT void *calloc(size_t n, size_t size)
+{
+    if (s_pl_resolving) {
+        return (size == 0 || n <= SIZE_MAX / size) ? pl_boot_alloc(n * size) : NULL;
+    }
+    pl_resolve();
+    return pl_fail(PL_CALLOC, PL_CALLER) ? NULL : real_calloc(n, size);
+}
+
+PL_EXPORT void *realloc(void *ptr, size_t size)
+{
+    if (s_pl_resolving) {
+        return NULL;
+    }
+    pl_resolve();
+    if (pl_fail(PL_REALLOC, PL_CALLER)) {
+        return NULL;
+    }
+    if (pl_is_boot(ptr)) {
+        // Never resized in place; copy what the bootstrap arena can hold
+        void *p = real_malloc(size);
+        size_t avail = (size_t)(s_pl_boot + sizeof(s_pl_boot) - (char *)ptr);
+        if (p != NULL) {
+            memcpy(p, ptr, size < avail ? size : avail);
+        }
+        return p;
+    }
+    return real_realloc(ptr, size);
+}
+
+PL_EXPORT void free(void *ptr)
+{
+    if (ptr == NULL || pl_is_boot(ptr)) {
+        return;
+    }
+    pl_resolve();
+    real_free(ptr);
+}
@@ -0,0 +1,255 @@
+/**
+ * =============================================================================
+ * tools/errcheck_query.c
+ * * Host tool: filters and aggregates a columnar failure archive (.ecol written
+ * * by errcheck_decode -o). The archive is mapped, blocks whose min/max rule out
+ * * a filter are skipped, and only the chunks of the columns the query uses are
+ * * decoded.
+ * * Build: gcc tools/errcheck_query.c tools/errcheck_ecol.c -o errcheck_query
+ * * Usage: errcheck_query [-w col=value | -w col=lo:hi]... [-g col [-n top]] [-p] archive
+ * *   columns: timestamp device code site inner count
+ * *   -g  occurrences grouped by a column, largest first
+ * *   -p  print matching rows
+ * * e.g.  errcheck_query -w code=2 -w timestamp=3600000:7200000 -g site fleet.ecol
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L // getopt()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include "errcheck_ecol.h"
+
+#define MAX_FILTERS 16
+
+typedef struct {
+    int col;
+    uint64_t lo, hi;
+} filter_t;
+
+/* --- Group-by accumulator (open addressing, grows at 50% load) --- */
+typedef struct {
+    uint64_t key;
+    uint64_t sum;
+    int used;
+} group_t;
+
+static group_t *g_groups = NULL;
+static size_t g_group_cap = 0, g_group_count = 0;
+
+static void group_add(uint64_t key, uint64_t weight)
+{
+    if (2u * (g_group_count + 1u) > g_group_cap) {
+        size_t cap = g_group_cap ? g_group_cap * 2u : 1024u;
+        group_t *old = g_groups, *t = calloc(cap, sizeof(*t));
+        if (t == NULL) {
+            perror("calloc");
+            exit(1);
+        }
+        g_groups = t;
+        size_t old_cap = g_group_cap;
+        g_group_cap = cap;
+        g_group_count = 0;
+        for (size_t i = 0; i < old_cap; i++) {
+            if (old[i].used) {
+                group_add(old[i].key, old[i].sum);
+            }
+        }
+        free(old);
+    }
+    size_t i = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 20) & (g_group_cap - 1u);
+    while (g_groups[i].used && g_groups[i].key != key) {
+        i = (i + 1u) & (g_group_cap - 1u);
+    }
+    if (!g_groups[i].used) {
+        g_groups[i].used = 1;
+        g_groups[i].key = key;
+        g_group_count++;
+    }
+    g_groups[i].sum += weight;
+}
+
+static int cmp_group_desc(const void *a, const void *b)
+{
+    const group_t *x = a, *y = b;
+    return (x->sum < y->sum) - (x->sum > y->sum);
+}
+
+static int parse_filter(const char *arg, filter_t *f)
+{
+    char name[32];
+    const char *eq = strchr(arg, '=');
+    char *end;
+
+    if (eq == NULL || (size_t)(eq - arg) >= sizeof(name)) {
+        return -1;
+    }
+    memcpy(name, arg, (size_t)(eq - arg));
+    name[eq - arg] = '\0';
+    if ((f->col = errcheck_ecol_column_by_name(name)) < 0) {
+        return -1;
+    }
+    f->lo = f->hi = strtoull(eq + 1, &end, 0);
+    if (*end == ':') {
+        f->hi = strtoull(end + 1, &end, 0);
+    }
+    return (*end == '\0' && f->lo <= f->hi) ? 0 : -1;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [-w col=value|col=lo:hi]... [-g col [-n top]] [-p] archive.ecol\n"
+            "columns: timestamp device code site inner count\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+    filter_t filters[MAX_FILTERS];
+    int nfilters = 0, group_col = -1, print_rows = 0, opt;
+    size_t top = 20;
+
+    while ((opt = getopt(argc, argv, "w:g:n:p")) != -1) {
+        switch (opt) {
+        case 'w':
+            if (nfilters == MAX_FILTERS || parse_filter(optarg, &filters[nfilters++]) != 0) {
+                fprintf(stderr, "bad filter '%s'\n", optarg);
+                return 2;
+            }
+            break;
+        case 'g':
+            if ((group_col = errcheck_ecol_column_by_name(optarg)) < 0) {
+                fprintf(stderr, "unknown column '%s'\n", optarg);
+                return 2;
+            }
+            break;
+        case 'n': top = strtoul(optarg, NULL, 0); break;
+        case 'p': print_rows = 1; break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    errcheck_ecol_reader_t r;
+    if (errcheck_ecol_open(&r, argv[optind]) != 0) {
+        fprintf(stderr, "%s: not a columnar archive\n", argv[optind]);
+        return 1;
+    }
+
+    uint64_t *col[ERRCHECK_ECOL_COLUMNS];
+    uint8_t *sel = malloc(ERRCHECK_ECOL_BLOCK_ROWS);
+    for (int c = 0; c < ERRCHECK_ECOL_COLUMNS; c++) {
+        col[c] = malloc(ERRCHECK_ECOL_BLOCK_ROWS * sizeof(uint64_t));
+        if (col[c] == NULL || sel == NULL) {
+            return 1;
+        }
+    }
+
+    uint64_t rows = 0, occurrences = 0, touched = 0;
+    uint32_t skipped_blocks = 0;
+
+    for (uint32_t b = 0; b < r.blocks; b++) {
+        const errcheck_ecol_block_t *blk = &r.index[b];
+        unsigned decoded = 0;
+        int skip = 0;
+
+        for (int f = 0; f < nfilters && !skip; f++) {
+            skip = (filters[f].hi < blk->min[filters[f].col] || filters[f].lo > blk->max[filters[f].col]);
+        }
+        if (skip) {
+            skipped_blocks++;
+            continue;
+        }
+
+        memset(sel, 1, blk->rows);
+        for (int f = 0; f < nfilters; f++) {
+            int c = filters[f].col;
+            if (!(decoded & (1u << c))) {
+                if (errcheck_ecol_read(&r, b, (errcheck_ecol_column_t)c, col[c]) != 0) {
+                    fprintf(stderr, "block %" PRIu32 ": corrupt %s chunk\n", b,
+                            errcheck_ecol_column_name((errcheck_ecol_column_t)c));
+                    return 1;
+                }
+                decoded |= 1u << c;
+                touched += blk->size[c];
+            }
+            for (uint32_t i = 0; i < blk->rows; i++) {
+                sel[i] &= (col[c][i] >= filters[f].lo && col[c][i] <= filters[f].hi);
+            }
+        }
+
+        // Output columns, decoded only if a row survived the filters
+        unsigned need = 1u << ERRCHECK_ECOL_COUNT;
+        if (group_col >= 0) {
+            need |= 1u << group_col;
+        }
+        if (print_rows) {
+            need = (1u << ERRCHECK_ECOL_COLUMNS) - 1u;
+        }
+        if (memchr(sel, 1, blk->rows) == NULL) {
+            continue;
+        }
+        for (int c = 0; c < ERRCHECK_ECOL_COLUMNS; c++) {
+            if ((need & (1u << c)) && !(decoded & (1u << c))) {
+                if (errcheck_ecol_read(&r, b, (errcheck_ecol_column_t)c, col[c]) != 0) {
+                    fprintf(stderr, "block %" PRIu32 ": corrupt %s chunk\n", b,
+                            errcheck_ecol_column_name((errcheck_ecol_column_t)c));
+                    return 1;
+                }
+                decoded |= 1u << c;
+                touched += blk->size[c];
+            }
+        }
+
+        for (uint32_t i = 0; i < blk->rows; i++) {
+            if (!sel[i]) {
+                continue;
+            }
+            rows++;
+            occurrences += col[ERRCHECK_ECOL_COUNT][i];
+            if (group_col >= 0) {
+                group_add(col[group_col][i], col[ERRCHECK_ECOL_COUNT][i]);
+            }
+            if (print_rows) {
+                printf("%15" PRIu64 " ms dev=%-5" PRIu64 " code=%-4" PRIu64 " site=0x%08" PRIX64
+                       " inner=0x%08" PRIX64 " x%" PRIu64 "\n",
+                       col[ERRCHECK_ECOL_TIMESTAMP][i], col[ERRCHECK_ECOL_DEVICE][i],
+                       col[ERRCHECK_ECOL_CODE][i], col[ERRCHECK_ECOL_SITE][i],
+                       col[ERRCHECK_ECOL_INNER][i], col[ERRCHECK_ECOL_COUNT][i]);
+            }
+        }
+    }
+
+    if (group_col >= 0) {
+        size_t n = 0;
+        for (size_t i = 0; i < g_group_cap; i++) {
+            if (g_groups[i].used) {
+                g_groups[n++] = g_groups[i];
+            }
+        }
+        qsort(g_groups, n, sizeof(*g_groups), cmp_group_desc);
+        printf("%-12s %14s\n", errcheck_ecol_column_name((errcheck_ecol_column_t)group_col),
+               "occurrences");
+        for (size_t i = 0; i < n && i < top; i++) {
+            printf("0x%-10" PRIX64 " %14" PRIu64 "\n", g_groups[i].key, g_groups[i].sum);
+        }
+    }
+    printf("%" PRIu64 " matching entries, %" PRIu64 " occurrences\n", rows, occurrences);
+    fprintf(stderr, "%" PRIu64 " rows in %" PRIu32 " blocks (%" PRIu32 " skipped by min/max); "
+            "decoded %" PRIu64 " of %zu bytes\n",
+            r.rows, r.blocks, skipped_blocks, touched, r.size);
+
+    for (int c = 0; c < ERRCHECK_ECOL_COLUMNS; c++) {
+        free(col[c]);
+    }
+    free(sel);
+    free(g_groups);
+    errcheck_ecol_close(&r);
+    return 0;
+}
@@ -0,0 +1,185 @@
+/**
+ * =============================================================================
+ * tools/errcheck_verify.c
+ * * Host tool: bulk CRC-32C verification of sealed failure records
+ * * (errcheck_retained_slot_t images: flash dumps, retained-RAM files).
+ * * Build: gcc -O2 -I src tools/errcheck_verify.c src/err_crc32c.c -o errcheck_verify
+ * * Usage: errcheck_verify [-i auto|sse4.2|armv8|slicing-by-8|bitwise] file...
+ * *        errcheck_verify -g <count> <file>    (write a synthetic dump for timing)
+ * =============================================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "err_crc32c.h"
+#include "err_retained.h"
+
+typedef uint32_t (*crc_fn_t)(uint32_t, const void *, size_t);
+
+typedef struct {
+    uint64_t valid;
+    uint64_t corrupt;   // Known magic, CRC mismatch
+    uint64_t empty;     // Erased flash / unused slot
+    uint64_t bytes;
+} verify_stats_t;
+
+static crc_fn_t pick_impl(const char *name)
+{
+    if (strcmp(name, "auto") == 0) {
+        return errcheck_crc32c;
+    }
+    if (strcmp(name, "bitwise") == 0) {
+        return errcheck_crc32c_bitwise;
+    }
+#ifndef ERRCHECK_CRC32C_SMALL
+    if (strcmp(name, "slicing-by-8") == 0) {
+        return errcheck_crc32c_sb8;
+    }
+#endif
+#ifdef ERRCHECK_CRC32C_HAVE_SSE42
+    if (strcmp(name, "sse4.2") == 0 && errcheck_crc32c_sse42_supported()) {
+        return errcheck_crc32c_sse42;
+    }
+#endif
+#ifdef ERRCHECK_CRC32C_HAVE_ARMV8
+    if (strcmp(name, "armv8") == 0) {
+        return errcheck_crc32c_armv8;
+    }
+#endif
+    return NULL;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int verify_file(const char *path, crc_fn_t crc, verify_stats_t *st)
+{
+    struct stat sb;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &sb) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    size_t size = (size_t)sb.st_size;
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+    const uint8_t *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+    posix_madvise((void *)map, size, POSIX_MADV_SEQUENTIAL);
+
+    const size_t slot_size = sizeof(errcheck_retained_slot_t);
+    size_t count = size / slot_size;
+    for (size_t i = 0; i < count; i++) {
+        const errcheck_retained_slot_t *s =
+            (const errcheck_retained_slot_t *)(map + i * slot_size);
+        if (s->magic != ERRCHECK_RETAINED_PENDING && s->magic != ERRCHECK_RETAINED_MIGRATED) {
+            st->empty++;
+            continue;
+        }
+        uint32_t c = crc(0, &s->seq, sizeof(s->seq));
+        c = crc(c, &s->rec, sizeof(s->rec));
+        if (c == s->crc && s->seq != 0) {
+            st->valid++;
+        } else {
+            st->corrupt++;
+            if (st->corrupt <= 10) {
+                printf("%s: slot %zu (seq %" PRIu32 ") CRC mismatch\n", path, i, s->seq);
+            }
+        }
+    }
+    if (size % slot_size != 0) {
+        printf("%s: %zu trailing byte(s) ignored\n", path, size % slot_size);
+    }
+    st->bytes += count * slot_size;
+    munmap((void *)map, size);
+    return 0;
+}
+
+static int generate(const char *path, uint64_t count)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return 1;
+    }
+    for (uint64_t i = 0; i < count; i++) {
+        errcheck_retained_slot_t s;
+        memset(&s, 0, sizeof(s));
+        s.magic = ERRCHECK_RETAINED_MIGRATED;
+        s.seq = (uint32_t)(i + 1u);
+        s.rec.seq = s.seq;
+        s.rec.site = (uint32_t)(i * 2654435761u);
+        s.rec.code = (uint32_t)(1u + i % 12u);
+        s.rec.line = (uint32_t)(10u + i % 500u);
+        s.rec.timestamp_ns = i * 1000u;
+        s.crc = errcheck_crc32c(errcheck_crc32c(0, &s.seq, sizeof(s.seq)), &s.rec, sizeof(s.rec));
+        if (fwrite(&s, sizeof(s), 1, f) != 1) {
+            fclose(f);
+            return 1;
+        }
+    }
+    return fclose(f) == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    const char *impl = "auto";
+    int argi = 1;
+
+    if (argc == 4 && strcmp(argv[1], "-g") == 0) {
+        return generate(argv[3], strtoull(argv[2], NULL, 10));
+    }
+    if (argc > 2 && strcmp(argv[1], "-i") == 0) {
+        impl = argv[2];
+        argi = 3;
+    }
+    if (argi >= argc) {
+        fprintf(stderr, "usage: %s [-i auto|sse4.2|armv8|slicing-by-8|bitwise] file...\n"
+                        "       %s -g <count> <file>\n", argv[0], argv[0]);
+        return 2;
+    }
+    crc_fn_t crc = pick_impl(impl);
+    if (crc == NULL) {
+        fprintf(stderr, "implementation '%s' not available on this host\n", impl);
+        return 2;
+    }
+
+    verify_stats_t st = {0};
+    double t0 = now_s();
+    for (int i = argi; i < argc; i++) {
+        if (verify_file(argv[i], crc, &st) != 0) {
+            return 1;
+        }
+    }
+    double dt = now_s() - t0;
+
+    printf("%" PRIu64 " valid, %" PRIu64 " corrupt, %" PRIu64 " empty slot(s)\n",
+           st.valid, st.corrupt, st.empty);
+    printf("crc32c=%s: %.1f MB in %.3f s (%.0f MB/s, %.2f M records/s)\n",
+           strcmp(impl, "auto") == 0 ? errcheck_crc32c_impl_name() : impl,
+           (double)st.bytes / 1e6, dt, dt > 0 ? (double)st.bytes / 1e6 / dt : 0.0,
+           dt > 0 ? (double)(st.valid + st.corrupt) / 1e6 / dt : 0.0);
+    return st.corrupt == 0 ? 0 : 1;
+}